@@ -0,0 +1,101 @@
+#include "WebArrange.h"
+#include <QObject>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// Places boxes along one axis with equal gaps, keeping the outermost ones where they are
+void distribute(QList<QRectF> &boxes, bool horizontal)
+{
+    auto start = [horizontal](const QRectF &box) { return horizontal ? box.left() : box.top(); };
+    auto end = [horizontal](const QRectF &box) { return horizontal ? box.right() : box.bottom(); };
+    auto length = [horizontal](const QRectF &box) { return horizontal ? box.width() : box.height(); };
+
+    QList<qsizetype> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](qsizetype a, qsizetype b) {
+        return start(boxes.at(a)) < start(boxes.at(b));
+    });
+
+    qreal first = start(boxes.at(order.constFirst()));
+    qreal last = first;
+    qreal total = 0;
+    for (const QRectF &box : std::as_const(boxes)) {
+        last = qMax(last, end(box));
+        total += length(box);
+    }
+
+    const qreal gap = (last - first - total) / (boxes.size() - 1);
+    qreal position = first;
+    for (qsizetype index : std::as_const(order)) {
+        QRectF &box = boxes[index];
+        if (horizontal)
+            box.moveLeft(position);
+        else
+            box.moveTop(position);
+        position += length(box) + gap;
+    }
+}
+}
+
+QList<QRectF> WebArrange::arrange(Operation operation, const QList<QRectF> &boxes, qsizetype reference)
+{
+    QList<QRectF> result = boxes;
+    if (boxes.size() < minimumCount(operation)) return result;
+
+    QRectF bounds;
+    for (const QRectF &box : boxes)
+        bounds |= box;
+    const QSizeF size = boxes.at(qBound<qsizetype>(0, reference, boxes.size() - 1)).size();
+
+    switch (operation) {
+    case DistributeHorizontally:
+    case DistributeVertically:
+        distribute(result, operation == DistributeHorizontally);
+        return result;
+    default:
+        break;
+    }
+
+    for (QRectF &box : result) {
+        switch (operation) {
+        case AlignLeft: box.moveLeft(bounds.left()); break;
+        case AlignHorizontalCenter: box.moveCenter(QPointF(bounds.center().x(), box.center().y())); break;
+        case AlignRight: box.moveRight(bounds.right()); break;
+        case AlignTop: box.moveTop(bounds.top()); break;
+        case AlignVerticalCenter: box.moveCenter(QPointF(box.center().x(), bounds.center().y())); break;
+        case AlignBottom: box.moveBottom(bounds.bottom()); break;
+        case MatchWidth: box.setWidth(size.width()); break;
+        case MatchHeight: box.setHeight(size.height()); break;
+        case MatchSize: box.setSize(size); break;
+        case DistributeHorizontally:
+        case DistributeVertically:
+            break;
+        }
+    }
+    return result;
+}
+
+qsizetype WebArrange::minimumCount(Operation operation)
+{
+    // With two boxes the gap between them is already the only one
+    return operation == DistributeHorizontally || operation == DistributeVertically ? 3 : 2;
+}
+
+QString WebArrange::text(Operation operation)
+{
+    switch (operation) {
+    case AlignLeft: return QObject::tr("Align Left");
+    case AlignHorizontalCenter: return QObject::tr("Align Centers");
+    case AlignRight: return QObject::tr("Align Right");
+    case AlignTop: return QObject::tr("Align Top");
+    case AlignVerticalCenter: return QObject::tr("Align Middles");
+    case AlignBottom: return QObject::tr("Align Bottom");
+    case DistributeHorizontally: return QObject::tr("Distribute Horizontally");
+    case DistributeVertically: return QObject::tr("Distribute Vertically");
+    case MatchWidth: return QObject::tr("Match Width");
+    case MatchHeight: return QObject::tr("Match Height");
+    case MatchSize: return QObject::tr("Match Size");
+    }
+    return QString();
+}
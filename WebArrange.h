@@ -0,0 +1,37 @@
+#ifndef WEBARRANGE_H
+#define WEBARRANGE_H
+
+#include <QList>
+#include <QRectF>
+#include <QString>
+
+// Alignment, distribution and size matching for a set of boxes. Boxes are
+// only computed here; the scene turns the result into one geometry command,
+// so arranging any number of elements is a single undo step.
+class WebArrange
+{
+public:
+    enum Operation {
+        AlignLeft,
+        AlignHorizontalCenter,
+        AlignRight,
+        AlignTop,
+        AlignVerticalCenter,
+        AlignBottom,
+        DistributeHorizontally,
+        DistributeVertically,
+        MatchWidth,
+        MatchHeight,
+        MatchSize
+    };
+
+    // Boxes in the same order. Alignment lines up with the edge of the
+    // bounding box of all boxes, sizes are matched to boxes[reference].
+    static QList<QRectF> arrange(Operation operation, const QList<QRectF> &boxes, qsizetype reference = 0);
+
+    // Fewer boxes than this are left as they are
+    static qsizetype minimumCount(Operation operation);
+    static QString text(Operation operation);
+};
+
+#endif // WEBARRANGE_H
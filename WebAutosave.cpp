@@ -0,0 +1,438 @@
+#include "WebAutosave.h"
+#include "WebDesignScene.h"
+#include "WebElementItem.h"
+#include "WebElementProperties.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QTimer>
+#include <utility>
+
+namespace {
+constexpr char kJournalMagic[4] = {'W', 'D', 'S', 'J'};
+constexpr qsizetype kJournalHeaderSize = sizeof(kJournalMagic) + sizeof(quint16);
+constexpr qsizetype kFrameHeaderSize = sizeof(quint32) + sizeof(quint16);
+
+enum RecordType : quint8 {
+    AppendRecord = 1,
+    UpdateRecord,
+    RemoveRecord,
+    PropertiesRecord
+};
+
+void writeElement(QDataStream &out, const WebElementData &element)
+{
+    out << element.type << element.id << element.cls << element.text << element.style
+        << element.x << element.y << element.width << element.height << element.parent
+        << element.component << element.part << element.overrides;
+    out << quint8(element.attributes.size());
+    for (const WebAttribute &attribute : element.attributes)
+        out << quint8(attribute.field) << attribute.value;
+    out << element.hidden;
+}
+
+WebElementData readElement(QDataStream &in, quint16 version)
+{
+    WebElementData element;
+    in >> element.type >> element.id >> element.cls >> element.text >> element.style
+       >> element.x >> element.y >> element.width >> element.height;
+    // Version 1 journals predate nesting
+    if (version >= 2)
+        in >> element.parent;
+    if (version >= 3)
+        in >> element.component >> element.part >> element.overrides;
+    if (version >= 4) {
+        quint8 count = 0;
+        in >> count;
+        for (quint8 i = 0; i < count; ++i) {
+            quint8 field = 0;
+            QString value;
+            in >> field >> value;
+            if (field < WebElementFieldCount)
+                element.setValue(WebElementField(field), value);
+        }
+    }
+    if (version >= 5)
+        in >> element.hidden;
+    return element;
+}
+
+// Payload size and checksum in front of every record let replay detect a torn tail
+QByteArray frame(const QByteArray &payload)
+{
+    QByteArray record;
+    record.reserve(kFrameHeaderSize + payload.size());
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out << quint32(payload.size()) << qChecksum(payload);
+    out.writeRawData(payload.constData(), payload.size());
+    return record;
+}
+
+bool fail(QString *errorString, const QString &message)
+{
+    if (errorString) *errorString = message;
+    return false;
+}
+}
+
+WebAutosave::WebAutosave(WebDesignScene *scene, WebElementProperties *properties, const WebProject *project,
+                         QObject *parent)
+    : QObject(parent), m_scene(scene), m_properties(properties), m_project(project),
+      m_recordsSinceCompaction(0), m_compactPending(false)
+{
+    // One thread keeps appends and compactions in the order they were queued
+    m_pool.setMaxThreadCount(1);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &WebAutosave::flush);
+
+    connectScene();
+    connect(m_properties, &WebElementProperties::propertiesChanged, this, &WebAutosave::onPropertiesChanged);
+}
+
+void WebAutosave::connectScene()
+{
+    connect(m_scene, &WebDesignScene::elementAdded, this, &WebAutosave::onElementAdded);
+    connect(m_scene, &WebDesignScene::elementRemoved, this, &WebAutosave::onElementRemoved);
+    connect(m_scene, &WebDesignScene::elementChanged, this, &WebAutosave::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementGeometryChanged, this, &WebAutosave::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementParentChanged, this, &WebAutosave::onElementChanged);
+    connect(m_scene, &WebDesignScene::sceneCleared, this, &WebAutosave::onSceneReset);
+    connect(m_scene, &WebDesignScene::sceneLoaded, this, &WebAutosave::onSceneReset);
+}
+
+void WebAutosave::setScene(WebDesignScene *scene)
+{
+    if (scene == m_scene) return;
+
+    // Records address slots of one page, the other page starts from a snapshot
+    disconnect(m_scene, nullptr, this, nullptr);
+    m_scene = scene;
+    connectScene();
+    onSceneReset();
+}
+
+WebAutosave::~WebAutosave()
+{
+    m_pool.waitForDone();
+}
+
+QString WebAutosave::journalPath(const QString &projectFile)
+{
+    if (!projectFile.isEmpty())
+        return projectFile + ".journal";
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/untitled.webdesign.journal";
+}
+
+QString WebAutosave::snapshotPath(const QString &projectFile)
+{
+    if (!projectFile.isEmpty())
+        return projectFile + ".autosave";
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/untitled.webdesign.autosave";
+}
+
+QString WebAutosave::sessionMarkerPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave.session";
+}
+
+void WebAutosave::setProjectFile(const QString &fileName)
+{
+    // Whatever was pending belongs to the design that is being replaced
+    m_flushTimer->stop();
+    m_pending.clear();
+    m_dirty.clear();
+    m_compactPending = false;
+    m_recordsSinceCompaction = 0;
+    m_lastProperties = m_properties->getGlobalProperties();
+
+    const QStringList stale = {
+        journalPath(m_projectFile), snapshotPath(m_projectFile),
+        journalPath(fileName), snapshotPath(fileName)
+    };
+    m_projectFile = fileName;
+
+    m_pool.start([stale] {
+        for (const QString &path : stale)
+            QFile::remove(path);
+    });
+    writeSessionMarker();
+}
+
+void WebAutosave::snapshotNow()
+{
+    m_compactPending = true;
+    flush();
+}
+
+void WebAutosave::discard()
+{
+    disconnect(m_scene, nullptr, this, nullptr);
+    disconnect(m_properties, nullptr, this, nullptr);
+    m_flushTimer->stop();
+    m_pool.waitForDone();
+
+    QFile::remove(journalPath(m_projectFile));
+    QFile::remove(snapshotPath(m_projectFile));
+    QFile::remove(sessionMarkerPath());
+}
+
+void WebAutosave::writeSessionMarker()
+{
+    const QString path = sessionMarkerPath();
+    const QByteArray project = m_projectFile.toUtf8();
+    m_pool.start([this, path, project] {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile marker(path);
+        if (!marker.open(QIODevice::WriteOnly | QIODevice::Truncate) || marker.write(project) != project.size())
+            reportFailure(marker.errorString());
+    });
+}
+
+void WebAutosave::reportFailure(const QString &error)
+{
+    // Called from the worker, the signal is delivered on the GUI thread
+    QMetaObject::invokeMethod(this, [this, error] { emit autosaveFailed(error); }, Qt::QueuedConnection);
+}
+
+void WebAutosave::schedule(int delay)
+{
+    if (!m_flushTimer->isActive() || delay < m_flushTimer->remainingTime())
+        m_flushTimer->start(delay);
+}
+
+void WebAutosave::appendRecord(const QByteArray &payload)
+{
+    m_pending += frame(payload);
+    ++m_recordsSinceCompaction;
+}
+
+void WebAutosave::onElementAdded(WebElementItem *item)
+{
+    if (m_compactPending) return;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(AppendRecord);
+    writeElement(out, m_scene->elementDataAt(m_scene->slotOf(item)));
+    appendRecord(payload);
+    schedule();
+}
+
+void WebAutosave::onElementRemoved(WebElementItem *item, qsizetype index)
+{
+    m_dirty.remove(item);
+    if (m_compactPending) return;
+
+    // Later records address elements by slot, so removals keep their original order
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(RemoveRecord) << quint32(index);
+    appendRecord(payload);
+    schedule();
+}
+
+void WebAutosave::onElementChanged(WebElementItem *item)
+{
+    // Only remembered here, the element is copied once when the journal is flushed
+    if (m_compactPending) return;
+    m_dirty.insert(item);
+    schedule();
+}
+
+void WebAutosave::onSceneReset()
+{
+    // Clearing or loading replaces everything, a snapshot says that more cheaply than records
+    m_compactPending = true;
+    schedule(0);
+}
+
+void WebAutosave::onPropertiesChanged()
+{
+    QJsonObject properties = m_properties->getGlobalProperties();
+    if (properties == m_lastProperties || m_compactPending) return;
+    m_lastProperties = properties;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(PropertiesRecord) << QJsonDocument(properties).toJson(QJsonDocument::Compact);
+    appendRecord(payload);
+    schedule();
+}
+
+void WebAutosave::flush()
+{
+    m_flushTimer->stop();
+
+    if (m_compactPending) {
+        // Copying the elements is all that happens here, encoding and writing run on the worker.
+        // The other pages are already blobs, copying the project only shares them.
+        WebProject project = *m_project;
+        const QList<WebElementData> elements = m_scene->snapshot();
+        const QJsonObject properties = m_properties->getGlobalProperties();
+        project.setProperties(properties);
+
+        m_pending.clear();
+        m_dirty.clear();
+        m_compactPending = false;
+        m_recordsSinceCompaction = 0;
+        m_lastProperties = properties;
+
+        const QString snapshot = snapshotPath(m_projectFile);
+        const QString journal = journalPath(m_projectFile);
+        m_pool.start([this, project, elements, snapshot, journal]() mutable {
+            project.setElements(project.activePage(), elements);
+            QDir().mkpath(QFileInfo(snapshot).absolutePath());
+            QString error;
+            if (!WebProject::write(snapshot, project, WebDesignSerializer::BinaryFormat, &error)) {
+                reportFailure(error);
+                return;
+            }
+            // Records up to the snapshot are now contained in it
+            QFile::remove(journal);
+        });
+        return;
+    }
+
+    // Dirty elements are written at the slot they have now, after the structural records
+    if (!m_dirty.isEmpty()) {
+        for (qsizetype slot = 0; slot < m_scene->elementCount(); ++slot) {
+            WebElementItem *item = m_scene->elementAt(slot);
+            if (!item || !m_dirty.contains(item)) continue;
+
+            QByteArray payload;
+            QDataStream out(&payload, QIODevice::WriteOnly);
+            out << quint8(UpdateRecord) << quint32(slot);
+            writeElement(out, m_scene->elementDataAt(slot));
+            appendRecord(payload);
+        }
+        m_dirty.clear();
+    }
+
+    if (m_pending.isEmpty()) return;
+
+    const QByteArray records = std::exchange(m_pending, QByteArray());
+    const QString journal = journalPath(m_projectFile);
+    m_pool.start([this, records, journal] {
+        QDir().mkpath(QFileInfo(journal).absolutePath());
+        QFile file(journal);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            reportFailure(file.errorString());
+            return;
+        }
+
+        if (file.size() == 0) {
+            QDataStream out(&file);
+            out.writeRawData(kJournalMagic, sizeof(kJournalMagic));
+            out << JournalVersion;
+        }
+        if (file.write(records) != records.size())
+            reportFailure(file.errorString());
+    });
+
+    // A long journal makes recovery slow, fold it into a snapshot on the next pass
+    if (m_recordsSinceCompaction > CompactThreshold) {
+        m_compactPending = true;
+        schedule();
+    }
+}
+
+bool WebAutosave::hasRecovery(QString *projectFile)
+{
+    QFile marker(sessionMarkerPath());
+    if (!marker.open(QIODevice::ReadOnly))
+        return false;
+
+    QString project = QString::fromUtf8(marker.readAll());
+    if (projectFile) *projectFile = project;
+
+    QFileInfo journal(journalPath(project));
+    return QFileInfo::exists(snapshotPath(project)) || (journal.exists() && journal.size() > kJournalHeaderSize);
+}
+
+bool WebAutosave::recover(const QString &projectFile, WebProject *project, QString *errorString)
+{
+    // The newest snapshot is the base, without one the journal applies to the saved project
+    *project = WebProject();
+    const QString snapshot = snapshotPath(projectFile);
+    if (QFileInfo::exists(snapshot)) {
+        if (!WebProject::read(snapshot, project, nullptr, errorString))
+            return false;
+    } else if (!projectFile.isEmpty() && QFileInfo::exists(projectFile)) {
+        if (!WebProject::read(projectFile, project, nullptr, errorString))
+            return false;
+    }
+
+    QFile file(journalPath(projectFile));
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(errorString, file.errorString());
+
+    const QByteArray journal = file.readAll();
+    if (!journal.startsWith(QByteArrayView(kJournalMagic, sizeof(kJournalMagic))))
+        return fail(errorString, tr("Not an autosave journal"));
+
+    QDataStream header(journal);
+    header.skipRawData(sizeof(kJournalMagic));
+    quint16 version = 0;
+    header >> version;
+    if (version > JournalVersion)
+        return fail(errorString, tr("Unsupported autosave journal version %1").arg(version));
+
+    // Records apply to the page that was active when the snapshot was taken
+    WebDesignDocument page;
+    page.elements = project->elements(project->activePage());
+    QList<WebElementData> &elements = page.elements;
+    qsizetype offset = kJournalHeaderSize;
+    while (journal.size() - offset >= kFrameHeaderSize) {
+        QDataStream frameHeader(journal.sliced(offset, kFrameHeaderSize));
+        quint32 size = 0;
+        quint16 checksum = 0;
+        frameHeader >> size >> checksum;
+
+        // A record cut short or garbled by the crash ends the replay
+        if (size > quint64(journal.size() - offset - kFrameHeaderSize))
+            break;
+        const QByteArray payload = journal.sliced(offset + kFrameHeaderSize, size);
+        if (qChecksum(payload) != checksum)
+            break;
+        offset += kFrameHeaderSize + size;
+
+        QDataStream in(payload);
+        quint8 type = 0;
+        quint32 slot = 0;
+        in >> type;
+        switch (type) {
+        case AppendRecord:
+            elements.append(readElement(in, version));
+            break;
+        case UpdateRecord: {
+            in >> slot;
+            WebElementData element = readElement(in, version);
+            if (slot < quint32(elements.size()))
+                elements[slot] = element;
+            break;
+        }
+        case RemoveRecord:
+            in >> slot;
+            if (slot < quint32(elements.size()))
+                page.removeElement(slot);
+            break;
+        case PropertiesRecord: {
+            QByteArray properties;
+            in >> properties;
+            project->setProperties(QJsonDocument::fromJson(properties).object());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    project->setElements(project->activePage(), elements);
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef WEBAUTOSAVE_H
+#define WEBAUTOSAVE_H
+
+#include "WebProject.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+class QTimer;
+class WebDesignScene;
+class WebElementItem;
+class WebElementProperties;
+
+// Background autosave. Changes are collected on the GUI thread and appended
+// as small records to a journal next to the project ("<file>.journal"), and
+// the journal is periodically compacted into a full binary snapshot
+// ("<file>.autosave"). All file writes run in order on one worker thread,
+// the GUI thread only copies the changed elements.
+//
+// Journal layout: magic "WDSJ", quint16 version, then records framed as
+// quint32 payload size and quint16 checksum. A record torn by a crash fails
+// its checksum and ends the replay.
+//
+// Snapshots hold the whole project. The journal only follows the scene of
+// the active page, so switching pages starts over from a snapshot.
+class WebAutosave : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The project provides the pages that are not open in the scene
+    WebAutosave(WebDesignScene *scene, WebElementProperties *properties, const WebProject *project,
+                QObject *parent = nullptr);
+    ~WebAutosave() override;
+
+    // Starts a fresh journal for the design backed by fileName, empty for an untitled design
+    void setProjectFile(const QString &fileName);
+    QString projectFile() const { return m_projectFile; }
+
+    // Journals another scene, e.g. after switching pages. The next flush writes a snapshot.
+    void setScene(WebDesignScene *scene);
+
+    // Writes a full snapshot of the current design, e.g. after recovering it
+    void snapshotNow();
+
+    // Removes the journal after a clean shutdown, so the next start does not offer recovery
+    void discard();
+
+    static QString journalPath(const QString &projectFile);
+    static QString snapshotPath(const QString &projectFile);
+
+    // True when the last session did not shut down cleanly and left changes behind
+    static bool hasRecovery(QString *projectFile);
+    static bool recover(const QString &projectFile, WebProject *project, QString *errorString = nullptr);
+
+    static constexpr quint16 JournalVersion = 5;
+
+    signals:
+        void autosaveFailed(const QString &error);
+
+private slots:
+    void onElementAdded(WebElementItem *item);
+    void onElementRemoved(WebElementItem *item, qsizetype index);
+    void onElementChanged(WebElementItem *item);
+    void onSceneReset();
+    void onPropertiesChanged();
+    void flush();
+
+private:
+    // Changes are flushed at most this often, edits in between are coalesced
+    static constexpr int FlushDelayMs = 1000;
+    // Journal records written before the next flush turns into a compaction
+    static constexpr qsizetype CompactThreshold = 20000;
+
+    void connectScene();
+    void schedule(int delay = FlushDelayMs);
+    void appendRecord(const QByteArray &payload);
+    void writeSessionMarker();
+    void reportFailure(const QString &error);
+
+    static QString sessionMarkerPath();
+
+    WebDesignScene *m_scene;
+    WebElementProperties *m_properties;
+    const WebProject *m_project;
+    QTimer *m_flushTimer;
+    QThreadPool m_pool;
+
+    QString m_projectFile;
+    // Structural records in the order they happened, then dirty elements at their current slot
+    QByteArray m_pending;
+    QSet<WebElementItem*> m_dirty;
+    QJsonObject m_lastProperties;
+    qsizetype m_recordsSinceCompaction;
+    bool m_compactPending;
+};
+
+#endif // WEBAUTOSAVE_H
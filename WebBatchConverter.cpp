@@ -0,0 +1,55 @@
+#include "WebBatchConverter.h"
+#include "WebHtmlExporter.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+WebBatchConverter::WebBatchConverter(int threadCount)
+    : m_threadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount())
+{
+}
+
+QList<WebBatchResult> WebBatchConverter::convertDirectory(const QString &inputDir, const QString &outputDir) const
+{
+    QDir input(inputDir);
+    QDir output(outputDir);
+    output.mkpath(".");
+
+    // Largest first, so a big design does not start last and keep one core busy alone
+    const QFileInfoList designs = input.entryInfoList({"*.webdesign", "*.json"}, QDir::Files, QDir::Size);
+
+    QList<WebBatchResult> jobs;
+    QSet<QString> names;
+    jobs.reserve(designs.size());
+    for (const QFileInfo &design : designs) {
+        // home.webdesign and home.json next to each other keep their suffix apart
+        QString name = design.completeBaseName();
+        if (names.contains(name))
+            name = design.fileName();
+        names.insert(name);
+
+        WebBatchResult job;
+        job.designFile = design.filePath();
+        job.htmlFile = output.filePath(name + ".html");
+        jobs.append(job);
+    }
+    return convert(jobs);
+}
+
+QList<WebBatchResult> WebBatchConverter::convert(QList<WebBatchResult> jobs) const
+{
+    // Each job writes only its own result, the list itself is not resized while the pool runs
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_threadCount);
+
+    WebBatchResult *results = jobs.data();
+    for (qsizetype i = 0; i < jobs.size(); ++i) {
+        pool.start([result = results + i] {
+            result->ok = WebHtmlExporter::exportDesign(result->designFile, result->htmlFile, &result->error);
+        });
+    }
+    pool.waitForDone();
+    return jobs;
+}
@@ -0,0 +1,35 @@
+#ifndef WEBBATCHCONVERTER_H
+#define WEBBATCHCONVERTER_H
+
+#include <QList>
+#include <QString>
+
+struct WebBatchResult
+{
+    QString designFile;
+    QString htmlFile;
+    bool ok = false;
+    QString error;
+};
+
+// Converts many designs to HTML at once. Every file is read, generated and
+// written by one worker of a thread pool, so a directory of designs keeps
+// all cores busy without any shared state between the conversions.
+class WebBatchConverter
+{
+public:
+    // Zero or less uses one thread per core
+    explicit WebBatchConverter(int threadCount = 0);
+
+    // Converts every .webdesign and .json file of inputDir into outputDir/<name>.html,
+    // projects of several pages into the directory outputDir/<name>
+    QList<WebBatchResult> convertDirectory(const QString &inputDir, const QString &outputDir) const;
+    QList<WebBatchResult> convert(QList<WebBatchResult> jobs) const;
+
+    int threadCount() const { return m_threadCount; }
+
+private:
+    int m_threadCount;
+};
+
+#endif // WEBBATCHCONVERTER_H
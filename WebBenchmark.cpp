@@ -0,0 +1,978 @@
+#include "WebBenchmark.h"
+#include "WebComponent.h"
+#include "WebCssParser.h"
+#include "WebDesignCommands.h"
+#include "WebDesignScene.h"
+#include "WebEdgeIndex.h"
+#include "WebElementItem.h"
+#include "WebElementTree.h"
+#include "WebHtmlWriter.h"
+#include "WebDesignSerializer.h"
+#include "WebElementProperties.h"
+#include "WebOutlineModel.h"
+#include "WebPageCache.h"
+#include "WebPreviewEngine.h"
+#include "WebProfiler.h"
+#include "WebProject.h"
+#include "WebRenderEngine.h"
+#include "WebSearchIndex.h"
+#include "WebStringPool.h"
+#include "WebStyleEngine.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGraphicsScene>
+#include <QGraphicsTextItem>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextDocument>
+#include <QTextEdit>
+#include <QTextStream>
+#include <QThread>
+#include <iterator>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// Keeps the optimizer from discarding the measured work
+volatile qsizetype g_sink = 0;
+
+constexpr qint64 kMinimumRunNs = 200 * 1000 * 1000;
+
+class Reporter
+{
+public:
+    explicit Reporter(QTextStream &out) : m_out(out) {}
+
+    // Repeats body until enough time has passed and reports the cost per element
+    template<typename Body>
+    void measure(const QString &name, qsizetype elements, Body body)
+    {
+        measure(name, elements, elements, body);
+    }
+
+    // Same, for bodies that perform a fixed number of operations on a larger data set
+    template<typename Body>
+    void measure(const QString &name, qsizetype elements, qsizetype operations, Body body)
+    {
+        QElapsedTimer timer;
+        qint64 iterations = 0;
+        timer.start();
+        do {
+            body();
+            ++iterations;
+        } while (timer.nsecsElapsed() < kMinimumRunNs);
+
+        QJsonObject metrics;
+        metrics["iterations"] = iterations;
+        metrics["operations"] = qint64(operations);
+        metrics["ns_per_op"] = double(timer.nsecsElapsed()) / (double(iterations) * operations);
+        if (operations == elements)
+            metrics["ns_per_element"] = metrics["ns_per_op"];
+        record(name, elements, metrics);
+    }
+
+    void record(const QString &name, qsizetype elements, QJsonObject metrics)
+    {
+        metrics["benchmark"] = name;
+        metrics["elements"] = qint64(elements);
+        m_out << QJsonDocument(metrics).toJson(QJsonDocument::Compact) << Qt::endl;
+        if (metrics.contains("ns_per_op"))
+            m_timings.insert(name, metrics["ns_per_op"].toDouble());
+    }
+
+    const QHash<QString, double> &timings() const { return m_timings; }
+
+private:
+    QTextStream &m_out;
+    QHash<QString, double> m_timings;
+};
+
+// Sizes of the synthetic designs the scaling benchmarks run on
+constexpr qsizetype kDesignSizes[] = {100, 1000, 10000, 100000};
+
+QList<WebElementData> syntheticElements(qsizetype count)
+{
+    static const QString types[] = {
+        "Container", "Text", "Heading 1", "Image", "Button", "Link", "Input", "Section"
+    };
+
+    QList<WebElementData> elements;
+    elements.reserve(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        WebElementData element;
+        element.type = types[i % std::size(types)];
+        element.id = u"element-%1"_s.arg(i);
+        element.cls = "card cta";
+        element.text = "Sign up & get \"early\" access";
+        element.style = "color: #333; margin: 4px 8px;";
+        // A grid one hundred elements wide, like a long page of cards
+        element.x = (i % 100) * 220;
+        element.y = (i / 100) * 100;
+        element.width = 200;
+        element.height = 80;
+        elements.append(element);
+    }
+    return elements;
+}
+
+// Rows of ten: a Section followed by the nine elements it holds
+QList<WebElementData> nestedElements(qsizetype count)
+{
+    QList<WebElementData> elements = syntheticElements(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        WebElementData &element = elements[i];
+        if (i % 10 == 0) {
+            element.type = "Section";
+            element.x = 0;
+            element.y = (i / 10) * 100;
+            element.width = 2000;
+            element.height = 100;
+        } else {
+            element.parent = qint32(i - i % 10);
+            element.x = (i % 10) * 220;
+            element.y = 10;
+        }
+    }
+    return elements;
+}
+
+// The operator+ based generator WebHtmlWriter replaced, kept as the baseline
+QString legacyGenerateHtml(const WebElementData &element)
+{
+    QString tag = WebHtmlWriter::tagForType(element.type);
+    QString html = "<" + tag;
+
+    if (!element.id.isEmpty()) html += " id=\"" + element.id + "\"";
+    if (!element.cls.isEmpty()) html += " class=\"" + element.cls + "\"";
+    if (!element.style.isEmpty()) html += " style=\"" + element.style + "\"";
+
+    if (tag == "img") {
+        html += " src=\"placeholder.png\"";
+        html += " alt=\"" + element.text + "\"";
+        html += " />";
+    } else if (tag == "input") {
+        html += " type=\"text\"";
+        html += " value=\"" + element.text + "\"";
+        html += " />";
+    } else {
+        html += ">";
+        html += element.text;
+        html += "</" + tag + ">";
+    }
+    return html;
+}
+
+void benchmarkHtml(Reporter &reporter)
+{
+    const QList<WebElementData> elements = syntheticElements(1000);
+
+    reporter.measure("html/legacy", elements.size(), [&] {
+        for (const WebElementData &element : elements)
+            g_sink = g_sink + legacyGenerateHtml(element).size();
+    });
+
+    WebHtmlWriter writer;
+    reporter.measure("html/writer", elements.size(), [&] {
+        for (const WebElementData &element : elements) {
+            writer.clear();
+            writer.writeElement(element);
+            g_sink = g_sink + writer.html().size();
+        }
+    });
+}
+
+void benchmarkSerializer(Reporter &reporter)
+{
+    WebDesignDocument document;
+    document.elements = syntheticElements(5000);
+
+    const QByteArray json = WebDesignSerializer::toJson(document);
+    const QByteArray binary = WebDesignSerializer::toBinary(document);
+
+    reporter.measure("serializer/json-read", document.elements.size(), [&] {
+        WebDesignDocument loaded;
+        WebDesignSerializer::fromJson(json, &loaded);
+        g_sink = g_sink + loaded.elements.size();
+    });
+
+    reporter.measure("serializer/binary-read", document.elements.size(), [&] {
+        WebDesignDocument loaded;
+        WebDesignSerializer::fromBinary(binary, &loaded);
+        g_sink = g_sink + loaded.elements.size();
+    });
+
+    reporter.measure("serializer/binary-write", document.elements.size(), [&] {
+        g_sink = g_sink + WebDesignSerializer::toBinary(document).size();
+    });
+}
+
+void benchmarkItemMemory(Reporter &reporter)
+{
+    const QList<WebElementData> elements = syntheticElements(20000);
+
+    // Items as they were built before labels moved into paint: one editor child each
+    auto measureItems = [&](const QString &name, bool withEditorChild) {
+        QGraphicsScene scene;
+        qint64 before = WebProfiler::memoryInUse();
+        for (const WebElementData &element : elements) {
+            WebElementItem *item = new WebElementItem(element.type);
+            item->setElementData(element);
+            if (withEditorChild) {
+                QGraphicsTextItem *text = new QGraphicsTextItem(element.text, item);
+                text->setTextInteractionFlags(Qt::TextEditorInteraction);
+            }
+            scene.addItem(item);
+        }
+        qint64 after = WebProfiler::memoryInUse();
+
+        QJsonObject metrics;
+        metrics["scene_items"] = qint64(scene.items().size());
+        if (before >= 0)
+            metrics["bytes_per_element"] = double(after - before) / elements.size();
+        reporter.record(name, elements.size(), metrics);
+    };
+
+    measureItems("memory/items-text-child", true);
+    measureItems("memory/items", false);
+
+    // A large design as loaded from JSON, where every parsed value is a string
+    // of its own, against the same values with types, classes and styles interned
+    constexpr qsizetype kDesignSize = 100000;
+    QList<WebElementData> design = syntheticElements(kDesignSize);
+    for (qsizetype i = 0; i < design.size(); i += 10) {
+        WebElementData &element = design[i];
+        element.setValue(WebElementField::Href, u"/pages/%1.html"_s.arg(i));
+        element.setValue(WebElementField::Alt, u"Card %1"_s.arg(i));
+    }
+    auto own = [](const QString &value) { return QString(value.constData(), value.size()); };
+
+    auto measureData = [&](const QString &name, bool interned) {
+        qint64 before = WebProfiler::memoryInUse();
+        QList<WebElementData> copies;
+        copies.reserve(design.size());
+        for (const WebElementData &element : std::as_const(design)) {
+            WebElementData copy = element;
+            copy.type = interned ? WebStringPool::intern(element.type) : own(element.type);
+            copy.id = own(element.id);
+            copy.cls = interned ? WebStringPool::intern(element.cls) : own(element.cls);
+            copy.text = own(element.text);
+            copy.style = interned ? WebStringPool::intern(element.style) : own(element.style);
+            for (WebAttribute &attribute : copy.attributes)
+                attribute.value = own(attribute.value);
+            copies.append(copy);
+        }
+        qint64 after = WebProfiler::memoryInUse();
+
+        QJsonObject metrics;
+        metrics["pooled_strings"] = qint64(WebStringPool::size());
+        if (before >= 0)
+            metrics["bytes_per_element"] = double(after - before) / copies.size();
+        reporter.record(name, copies.size(), metrics);
+    };
+    measureData(u"memory/data-parsed/%1"_s.arg(kDesignSize), false);
+    measureData(u"memory/data-interned/%1"_s.arg(kDesignSize), true);
+
+    // Items keep only the fields that are set, the attributes cost nothing on the other nine tenths
+    {
+        WebDesignScene scene;
+        qint64 before = WebProfiler::memoryInUse();
+        scene.loadElements(design);
+        qint64 after = WebProfiler::memoryInUse();
+
+        QJsonObject metrics;
+        metrics["pooled_strings"] = qint64(WebStringPool::size());
+        if (before >= 0)
+            metrics["bytes_per_element"] = double(after - before) / design.size();
+        reporter.record(u"memory/design/%1"_s.arg(kDesignSize), design.size(), metrics);
+    }
+}
+
+void benchmarkScene(Reporter &reporter)
+{
+    constexpr int kQueries = 1000;
+    const QSizeF viewport(1200, 800);
+
+    const struct {
+        QLatin1StringView name;
+        WebDesignScene::IndexStrategy strategy;
+    } strategies[] = {
+        {"automatic"_L1, WebDesignScene::AutomaticBspDepth},
+        {"tuned"_L1, WebDesignScene::TunedBspDepth},
+        {"unindexed-drag"_L1, WebDesignScene::UnindexedDrag},
+    };
+
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = syntheticElements(count);
+
+        for (const auto &strategy : strategies) {
+            WebDesignScene scene;
+            scene.setIndexStrategy(strategy.strategy);
+            scene.loadElements(elements);
+            const QRectF bounds = scene.itemsBoundingRect();
+            const QString suffix = u"/%1/%2"_s.arg(strategy.name).arg(count);
+
+            // Fixed seed so every strategy answers the same queries
+            QRandomGenerator random(42);
+            QList<QPointF> points;
+            points.reserve(kQueries);
+            for (int i = 0; i < kQueries; ++i)
+                points.append(QPointF(bounds.left() + random.bounded(bounds.width()),
+                                      bounds.top() + random.bounded(bounds.height())));
+
+            reporter.measure("scene/item-at" + suffix, count, kQueries, [&] {
+                for (const QPointF &point : std::as_const(points))
+                    g_sink = g_sink + (scene.itemAt(point, QTransform()) != nullptr);
+            });
+
+            reporter.measure("scene/viewport-items" + suffix, count, kQueries, [&] {
+                for (const QPointF &point : std::as_const(points))
+                    g_sink = g_sink + scene.items(QRectF(point, viewport)).size();
+            });
+
+            // Drags move one item many times, the drag strategy drops the index around them
+            WebElementItem *dragged = scene.elementAt(count / 2);
+            const QPointF origin = dragged->pos();
+            reporter.measure("scene/drag" + suffix, count, kQueries, [&] {
+                if (strategy.strategy == WebDesignScene::UnindexedDrag)
+                    scene.setItemIndexMethod(QGraphicsScene::NoIndex);
+                for (int i = 0; i < kQueries; ++i)
+                    dragged->setPos(origin + QPointF(i % 50, i % 30));
+                // Applying the strategy again tunes the rebuilt tree as a drop does
+                if (strategy.strategy == WebDesignScene::UnindexedDrag) {
+                    scene.setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+                    scene.setIndexStrategy(strategy.strategy);
+                }
+                g_sink = g_sink + scene.items(QRectF(origin, viewport)).size();
+            });
+        }
+    }
+}
+
+void benchmarkTree(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = nestedElements(count);
+
+        // Linking the tree is part of every export, so it is measured with the walk
+        WebHtmlWriter writer;
+        reporter.measure(u"tree/html/%1"_s.arg(count), count, [&] {
+            const WebElementTree tree(elements);
+            writer.clear();
+            tree.walk([&](qsizetype index, bool hasChildren) {
+                if (hasChildren)
+                    writer.writeStartTag(elements.at(index));
+                else
+                    writer.writeElement(elements.at(index));
+            }, [&](qsizetype index) {
+                writer.writeEndTag(elements.at(index).type);
+            });
+            g_sink = g_sink + writer.html().size();
+        });
+    }
+
+    // Moving a container with everything in it, as one subtree and as separate top level items
+    constexpr qsizetype kContents = 1000;
+    QList<WebElementData> elements = syntheticElements(kContents + 1);
+    elements[0].type = "Section";
+    elements[0].width = 22000;
+    elements[0].height = 1000;
+    for (qsizetype i = 1; i < elements.size(); ++i)
+        elements[i].parent = 0;
+
+    WebDesignScene nested;
+    nested.loadElements(elements);
+    WebElementItem *container = nested.elementAt(0);
+    qreal step = 1;
+    reporter.measure("tree/move-subtree", elements.size(), 1, [&] {
+        container->moveBy(step, 0);
+        step = -step;
+    });
+
+    for (WebElementData &element : elements)
+        element.parent = -1;
+    WebDesignScene flat;
+    flat.loadElements(elements);
+    reporter.measure("tree/move-flat", elements.size(), 1, [&] {
+        for (qsizetype i = 0; i < flat.elementCount(); ++i)
+            flat.elementAt(i)->moveBy(step, 0);
+        step = -step;
+    });
+}
+
+// One rule per id plus a few class and tag rules, like a generated site theme
+QString syntheticStyleSheet(qsizetype rules)
+{
+    QString css = u"section { font-family: serif; color: #222 }\n.card { background: #fafafa; border: 1px solid #ccc }\n"_s
+                  u".cta { font-weight: bold } section > .card { font-size: 14px }\n"_s;
+    for (qsizetype i = 0; i < rules; ++i)
+        css += u"#element-%1 { color: rgb(%2, 0, 0); width: 180px }\n"_s.arg(i).arg(i % 256);
+    return css;
+}
+
+void benchmarkCss(Reporter &reporter)
+{
+    for (qsizetype count : {100, 1000, 10000}) {
+        const QString css = syntheticStyleSheet(count);
+        reporter.measure(u"css/parse/%1"_s.arg(count), count, [&] {
+            g_sink = g_sink + WebCssParser::parseStyleSheet(css).rules().size();
+        });
+    }
+
+    constexpr qsizetype kElements = 10000;
+    WebDesignScene scene;
+    scene.loadElements(nestedElements(kElements));
+    WebStyleEngine engine(&scene);
+    const QString css = syntheticStyleSheet(kElements);
+    engine.setStyleSheet(css);
+
+    reporter.measure("css/restyle-all", kElements, [&] {
+        engine.restyleAll();
+    });
+
+    // Editing one rule only restyles the element its id selects
+    const QString edited = css + u"#element-5 { color: blue }\n"_s;
+    bool toggle = false;
+    reporter.measure("css/edit-rule", kElements, 1, [&] {
+        toggle = !toggle;
+        engine.setStyleSheet(toggle ? edited : css);
+    });
+}
+
+void benchmarkUndo(Reporter &reporter)
+{
+    constexpr int kEdits = 100000;
+    const QList<WebElementData> elements = syntheticElements(10000);
+
+    WebDesignScene scene;
+    scene.loadElements(elements);
+    WebUndoStack *stack = scene.undoStack();
+    stack->setMemoryLimit(4 * 1024 * 1024);
+
+    // A long session: text edits spread over the design with a move every few edits
+    QRandomGenerator random(42);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kEdits; ++i) {
+        qsizetype slot = random.bounded(int(elements.size()));
+        WebElementItem *item = scene.elementAt(slot);
+        if (i % 4 == 3) {
+            QRectF from = item->geometry();
+            QRectF to = from.translated(random.bounded(20) - 10, random.bounded(20) - 10);
+            stack->push(new WebGeometryCommand(&scene, {WebGeometryChange{slot, from, to}}));
+        } else {
+            scene.setElementProperty(item, WebElementField::Text, u"Edit %1"_s.arg(i));
+        }
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+
+    QJsonObject metrics;
+    metrics["edits"] = kEdits;
+    metrics["ns_per_op"] = double(elapsed) / kEdits;
+    metrics["commands"] = qint64(stack->count());
+    metrics["history_bytes"] = qint64(stack->memoryUsage());
+    metrics["history_limit"] = qint64(stack->memoryLimit());
+    reporter.record("undo/session", elements.size(), metrics);
+
+    timer.restart();
+    qsizetype undone = 0;
+    for (; stack->canUndo(); ++undone)
+        stack->undo();
+    metrics = QJsonObject();
+    metrics["commands"] = qint64(undone);
+    metrics["ns_per_op"] = double(timer.nsecsElapsed()) / qMax<qsizetype>(1, undone);
+    reporter.record("undo/unwind", elements.size(), metrics);
+}
+
+void benchmarkArrange(Reporter &reporter)
+{
+    const QList<WebElementData> elements = syntheticElements(10000);
+    WebDesignScene scene;
+    scene.loadElements(elements);
+
+    // Every tenth element selected, a batch spread over the whole design
+    const qsizetype selected = elements.size() / 10;
+    for (qsizetype slot = 0; slot < elements.size(); slot += 10)
+        scene.elementAt(slot)->setSelected(true);
+    const QList<WebElementItem*> selection = scene.selectedElements();
+
+    // One command each, undone right away so every run starts from the same design
+    reporter.measure("arrange/align", selected, [&] {
+        scene.arrangeSelection(WebArrange::AlignLeft);
+        scene.undoStack()->undo();
+    });
+    reporter.measure("arrange/distribute", selected, [&] {
+        scene.arrangeSelection(WebArrange::DistributeVertically);
+        scene.undoStack()->undo();
+    });
+    reporter.measure("arrange/bulk-property", selected, [&] {
+        scene.setElementsProperty(selection, WebElementField::Class, u"card featured"_s);
+        scene.undoStack()->undo();
+    });
+
+    QJsonObject metrics;
+    metrics["selected"] = qint64(selected);
+    metrics["undo_steps"] = qint64(scene.undoStack()->count());
+    reporter.record("arrange/history", elements.size(), metrics);
+}
+
+void benchmarkSnap(Reporter &reporter)
+{
+    constexpr int kQueries = 1000;
+    constexpr qreal kTolerance = 6;
+
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = syntheticElements(count);
+        QList<WebEdgeIndex::Entry> entries;
+        entries.reserve(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            const WebElementData &element = elements.at(i);
+            entries.append(WebEdgeIndex::Entry{quintptr(i + 1), QRectF(element.x, element.y, element.width, element.height)});
+        }
+
+        WebEdgeIndex index;
+        reporter.measure(u"snap/rebuild-%1"_s.arg(count), count, [&] {
+            index.rebuild(entries);
+            g_sink = g_sink + index.size();
+        });
+
+        // A drag looks up the nearest edge of each of the three moving edges per axis
+        QRandomGenerator random(42);
+        QList<qreal> positions(kQueries);
+        for (qreal &position : positions)
+            position = random.bounded(220.0 * 100);
+
+        reporter.measure(u"snap/nearest-%1"_s.arg(count), count, kQueries, [&] {
+            for (qreal position : std::as_const(positions))
+                g_sink = g_sink + index.nearest(WebEdgeIndex::Horizontal, position, kTolerance).key;
+        });
+
+        // What itemChange would cost without the index: every box on every move
+        reporter.measure(u"snap/scan-%1"_s.arg(count), count, kQueries / 10, [&] {
+            for (qsizetype q = 0; q < kQueries / 10; ++q) {
+                qreal best = kTolerance;
+                for (const WebEdgeIndex::Entry &entry : std::as_const(entries)) {
+                    qreal edges[3];
+                    WebEdgeIndex::edgesOf(entry.rect, WebEdgeIndex::Horizontal, edges);
+                    for (qreal edge : edges)
+                        best = qMin(best, qAbs(edge - positions.at(q)));
+                }
+                g_sink = g_sink + qsizetype(best);
+            }
+        });
+
+        // One element dropped somewhere else, then a whole page of them
+        reporter.measure(u"snap/update-one-%1"_s.arg(count), count, 1, [&] {
+            const quintptr key = quintptr(random.bounded(int(count))) + 1;
+            index.insert(key, index.rect(key).translated(random.bounded(40) - 20, 0));
+        });
+        const qsizetype batch = qMin<qsizetype>(count, 1000);
+        reporter.measure(u"snap/update-batch-%1"_s.arg(count), count, batch, [&] {
+            QList<WebEdgeIndex::Entry> moved;
+            moved.reserve(batch);
+            for (qsizetype i = 0; i < batch; ++i) {
+                const quintptr key = quintptr(random.bounded(int(count))) + 1;
+                moved.append(WebEdgeIndex::Entry{key, index.rect(key).translated(0, random.bounded(40) - 20)});
+            }
+            index.update(moved);
+        });
+    }
+}
+
+void benchmarkPages(Reporter &reporter)
+{
+    constexpr int kPages = 16;
+    constexpr qsizetype kPageElements = 2000;
+
+    WebProject project;
+    project.setElements(0, syntheticElements(kPageElements));
+    for (int i = 1; i < kPages; ++i)
+        project.addPage(u"Page %1"_s.arg(i), syntheticElements(kPageElements));
+
+    QJsonObject metrics;
+    metrics["pages"] = kPages;
+    metrics["blob_bytes_per_element"] = double(project.byteSize()) / (kPages * kPageElements);
+    reporter.record("pages/blobs", kPages * kPageElements, metrics);
+
+    // Opening a page that is not cached decodes its blob into a new scene
+    reporter.measure("pages/switch-cold", kPageElements, [&] {
+        WebPageCache cache;
+        g_sink = g_sink + cache.acquire(project, 1)->elementCount();
+    });
+
+    // Going back and forth between two pages finds both in the cache
+    WebPageCache cache;
+    cache.acquire(project, 0);
+    cache.acquire(project, 1);
+    reporter.measure("pages/switch-cached", kPageElements, 2, [&] {
+        g_sink = g_sink + cache.acquire(project, 0)->elementCount();
+        g_sink = g_sink + cache.acquire(project, 1)->elementCount();
+    });
+
+    QTemporaryDir directory;
+    for (int threads : {1, QThread::idealThreadCount()}) {
+        reporter.measure(u"pages/export-site-%1t"_s.arg(threads), kPages * kPageElements, [&] {
+            g_sink = g_sink + project.exportSite(directory.path(), nullptr, threads);
+        });
+    }
+}
+
+void benchmarkModel(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = syntheticElements(count);
+
+        QList<WebElementItem*> items;
+        items.reserve(count);
+        for (const WebElementData &element : elements) {
+            items.append(new WebElementItem(element.type));
+            items.last()->setElementData(element);
+        }
+
+        QJsonArray json;
+        reporter.measure(u"model/to-json/%1"_s.arg(count), count, [&] {
+            json = QJsonArray();
+            for (const WebElementItem *item : std::as_const(items))
+                json.append(item->toJson());
+            g_sink = g_sink + json.size();
+        });
+
+        reporter.measure(u"model/from-json/%1"_s.arg(count), count, [&] {
+            for (qsizetype i = 0; i < count; ++i)
+                items.at(i)->fromJson(json.at(i).toObject());
+            g_sink = g_sink + items.size();
+        });
+
+        qDeleteAll(items);
+    }
+}
+
+void benchmarkLoad(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        QJsonArray json;
+        for (const WebElementData &element : syntheticElements(count))
+            json.append(element.toJson());
+
+        WebDesignScene scene;
+        reporter.measure(u"load/scene-from-json/%1"_s.arg(count), count, [&] {
+            scene.fromJson(json);
+            g_sink = g_sink + scene.elementCount();
+        });
+    }
+}
+
+void benchmarkGenerator(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = syntheticElements(count);
+
+        reporter.measure(u"generator/element-html/%1"_s.arg(count), count, [&] {
+            for (const WebElementData &element : elements)
+                g_sink = g_sink + WebHtmlWriter::elementHtml(element).size();
+        });
+    }
+}
+
+void benchmarkPreview(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        WebDesignScene scene;
+        WebElementProperties properties;
+        QTextEdit view;
+        WebPreviewEngine engine(&scene, &properties, &view);
+        scene.loadElements(syntheticElements(count));
+
+        reporter.measure(u"preview/rebuild/%1"_s.arg(count), count, [&] {
+            engine.rebuild();
+            g_sink = g_sink + view.document()->characterCount();
+        });
+    }
+}
+
+void benchmarkComponents(Reporter &reporter)
+{
+    constexpr qsizetype kElements = 20000;
+
+    // A card: a Section holding nine elements
+    WebComponentLibrary library;
+    QList<WebElementData> card = nestedElements(10);
+    const quint32 id = library.add(u"Card"_s, card);
+    const qsizetype parts = card.size();
+
+    QList<WebElementData> instances;
+    QList<WebElementData> copies;
+    for (qsizetype first = 0; first + parts <= kElements; first += parts) {
+        const QPointF position((first / parts % 100) * 220, (first / parts / 100) * 100);
+        const QList<WebElementData> instance = library.instantiate(id, position, qint32(first));
+        instances.append(instance);
+        // Pasted copies end up with strings of their own once they are edited
+        for (WebElementData element : instance) {
+            element.component = 0;
+            element.part = -1;
+            element.cls = QString(element.cls.constData(), element.cls.size());
+            element.text = QString(element.text.constData(), element.text.size());
+            element.style = QString(element.style.constData(), element.style.size());
+            copies.append(element);
+        }
+    }
+
+    auto measureScene = [&](const QString &name, const QList<WebElementData> &elements) {
+        WebDesignScene scene;
+        scene.setComponentLibrary(&library);
+        const qint64 before = WebProfiler::memoryInUse();
+        scene.loadElements(elements);
+        const qint64 after = WebProfiler::memoryInUse();
+
+        QJsonObject metrics;
+        if (before >= 0)
+            metrics["bytes_per_element"] = double(after - before) / elements.size();
+        reporter.record(name, elements.size(), metrics);
+    };
+    measureScene("components/memory-copies", copies);
+    measureScene("components/memory-instances", instances);
+
+    // Editing the master reaches every instance of the page in one pass
+    WebDesignScene scene;
+    scene.setComponentLibrary(&library);
+    scene.loadElements(instances);
+    bool toggle = false;
+    reporter.measure("components/follow-master", instances.size(), [&] {
+        toggle = !toggle;
+        WebElementFields fields = *library.fields(id, 1).constData();
+        fields.setValue(WebElementField::Text, toggle ? u"Edited"_s : u"Text"_s);
+        library.setFields(id, 1, fields);
+        scene.followComponent(id);
+    });
+
+    reporter.measure("components/export", instances.size(), [&] {
+        g_sink = g_sink + library.exportElements(instances).size();
+    });
+}
+
+void benchmarkRender(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        WebDesignScene scene;
+        WebStyleEngine styles(&scene);
+        scene.loadElements(syntheticElements(count));
+
+        // A new engine every time, with no previous layout to reuse measurements from
+        reporter.measure(u"render/layout/%1"_s.arg(count), count, [&] {
+            WebRenderEngine engine(&scene, &styles);
+            engine.setActive(true);
+            engine.layoutPage();
+            g_sink = g_sink + engine.pageHeight();
+        });
+
+        // Only the edited element is measured again
+        WebRenderEngine engine(&scene, &styles);
+        engine.setActive(true);
+        engine.layoutPage();
+        WebElementItem *item = scene.elementAt(count / 2);
+        bool toggle = false;
+        reporter.measure(u"render/edit-one/%1"_s.arg(count), count, 1, [&] {
+            toggle = !toggle;
+            item->setText(toggle ? u"Edited text that wraps onto a second line, maybe"_s : u"Text"_s);
+            engine.layoutPage();
+            g_sink = g_sink + engine.boxCount();
+        });
+    }
+}
+
+void benchmarkSearch(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        const QList<WebElementData> elements = syntheticElements(count);
+
+        // Done once after a load, on the first query
+        QList<WebSearchIndex::Entry> entries;
+        entries.reserve(count);
+        for (qsizetype i = 0; i < count; ++i)
+            entries.append(WebSearchIndex::Entry{quintptr(i + 1) << 1, elements.at(i)});
+        WebSearchIndex index;
+        reporter.measure(u"search/build/%1"_s.arg(count), count, [&] {
+            index.rebuild(entries);
+        });
+
+        // One in eight elements is a button, every element has the class
+        reporter.measure(u"search/query-common/%1"_s.arg(count), count, 1, [&] {
+            g_sink = g_sink + index.find(u"type:button .cta").size();
+        });
+        reporter.measure(u"search/query-rare/%1"_s.arg(count), count, 1, [&] {
+            g_sink = g_sink + index.find(u"#element-42 sign").size();
+        });
+
+        // Query, select and fill the properties panel, with the index already built
+        WebDesignScene scene;
+        WebElementProperties properties;
+        scene.loadElements(elements);
+        scene.findElements(u"#element-0"_s);
+        bool other = false;
+        reporter.measure(u"search/select/%1"_s.arg(count), count, 1, [&] {
+            other = !other;
+            const QList<WebElementItem*> found = scene.findElements(other ? u"#element-42"_s : u"#element-43"_s);
+            scene.selectElements(found);
+            properties.setSelection(found);
+            g_sink = g_sink + found.size();
+        });
+
+        // An edit updates the index in place
+        WebElementItem *item = scene.elementAt(count / 2);
+        bool toggle = false;
+        reporter.measure(u"search/edit-one/%1"_s.arg(count), count, 1, [&] {
+            toggle = !toggle;
+            item->setText(toggle ? u"Limited offer"_s : u"Sign up"_s);
+            g_sink = g_sink + scene.findElements(u"text:limited"_s).size();
+        });
+    }
+}
+
+void benchmarkOutline(Reporter &reporter)
+{
+    for (qsizetype count : kDesignSizes) {
+        WebDesignScene scene;
+        scene.loadElements(nestedElements(count));
+
+        // What a view does on its first layout: collect the top level, fetch one batch
+        reporter.measure(u"outline/first-batch/%1"_s.arg(count), count, 1, [&] {
+            WebOutlineModel model(&scene);
+            if (model.canFetchMore(QModelIndex()))
+                model.fetchMore(QModelIndex());
+            g_sink = g_sink + model.rowCount();
+        });
+
+        // Selecting the last element on the canvas reveals it in the outline
+        WebOutlineModel model(&scene);
+        WebElementItem *last = scene.elementAt(count - 1);
+        reporter.measure(u"outline/reveal-last/%1"_s.arg(count), count, 1, [&] {
+            g_sink = g_sink + model.indexOf(last).row();
+        });
+
+        // Adding and removing an element updates only its row
+        WebElementData element = syntheticElements(1).constFirst();
+        reporter.measure(u"outline/add-remove/%1"_s.arg(count), count, 1, [&] {
+            scene.removeElement(scene.appendElement(element));
+            g_sink = g_sink + model.rowCount();
+        });
+    }
+}
+
+struct Benchmark
+{
+    QLatin1StringView name;
+    void (*run)(Reporter &reporter);
+};
+
+const Benchmark kBenchmarks[] = {
+    {"model"_L1, benchmarkModel},
+    {"load"_L1, benchmarkLoad},
+    {"generator"_L1, benchmarkGenerator},
+    {"preview"_L1, benchmarkPreview},
+    {"html"_L1, benchmarkHtml},
+    {"serializer"_L1, benchmarkSerializer},
+    {"memory"_L1, benchmarkItemMemory},
+    {"scene"_L1, benchmarkScene},
+    {"tree"_L1, benchmarkTree},
+    {"css"_L1, benchmarkCss},
+    {"undo"_L1, benchmarkUndo},
+    {"pages"_L1, benchmarkPages},
+    {"snap"_L1, benchmarkSnap},
+    {"arrange"_L1, benchmarkArrange},
+    {"components"_L1, benchmarkComponents},
+    {"render"_L1, benchmarkRender},
+    {"search"_L1, benchmarkSearch},
+    {"outline"_L1, benchmarkOutline},
+};
+}
+
+QHash<QString, double> readTimings(const QString &fileName)
+{
+    QHash<QString, double> timings;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return timings;
+
+    while (!file.atEnd()) {
+        QJsonObject result = QJsonDocument::fromJson(file.readLine()).object();
+        if (result.contains("ns_per_op"))
+            timings.insert(result["benchmark"].toString(), result["ns_per_op"].toDouble());
+    }
+    return timings;
+}
+}
+
+int runBenchmarks(const QStringList &arguments)
+{
+    QStringList filters;
+    QString outputFile;
+    QString baselineFile;
+    double tolerance = 10;
+    for (qsizetype i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        if (argument == "--output" && i + 1 < arguments.size())
+            outputFile = arguments.at(++i);
+        else if (argument == "--baseline" && i + 1 < arguments.size())
+            baselineFile = arguments.at(++i);
+        else if (argument == "--tolerance" && i + 1 < arguments.size())
+            tolerance = arguments.at(++i).toDouble();
+        else if (!argument.startsWith(u'-'))
+            filters.append(argument);
+    }
+
+    // Results go to stdout, or to a file that a later run can use as its baseline
+    QFile file;
+    if (outputFile.isEmpty()) {
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    } else {
+        file.setFileName(outputFile);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            QTextStream(stderr) << outputFile << ": " << file.errorString() << Qt::endl;
+            return 2;
+        }
+    }
+
+    QTextStream out(&file);
+    Reporter reporter(out);
+
+    QJsonObject environment;
+    environment["qt"] = qVersion();
+    environment["threads"] = QThread::idealThreadCount();
+#ifdef QT_DEBUG
+    environment["build"] = "debug";
+#else
+    environment["build"] = "release";
+#endif
+    reporter.record("environment", 0, environment);
+
+    for (const Benchmark &benchmark : kBenchmarks) {
+        bool selected = filters.isEmpty();
+        for (const QString &filter : std::as_const(filters))
+            selected = selected || benchmark.name.startsWith(filter) || filter.startsWith(benchmark.name);
+        if (selected)
+            benchmark.run(reporter);
+    }
+
+    if (baselineFile.isEmpty())
+        return 0;
+
+    // Anything slower than the baseline by more than the tolerance fails the run
+    const QHash<QString, double> baseline = readTimings(baselineFile);
+    QTextStream err(stderr);
+    int regressions = 0;
+    for (auto it = reporter.timings().cbegin(); it != reporter.timings().cend(); ++it) {
+        double before = baseline.value(it.key(), 0);
+        if (before <= 0) continue;
+
+        double change = (it.value() - before) / before * 100;
+        if (change > tolerance) {
+            err << "regression: " << it.key() << " " << before << " -> " << it.value()
+                << " ns/op (+" << qRound(change) << "%)" << Qt::endl;
+            ++regressions;
+        }
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#ifndef WEBBENCHMARK_H
+#define WEBBENCHMARK_H
+
+#include <QStringList>
+
+// Built-in micro benchmarks, run with
+//
+//   --benchmark [name-prefix...] [--output results.jsonl]
+//               [--baseline previous.jsonl] [--tolerance percent]
+//
+// Each result is printed as one JSON object per line, on stdout or into the
+// output file. With a baseline, benchmarks whose ns_per_op grew by more than
+// the tolerance (10% by default) are reported and the run exits with 1.
+int runBenchmarks(const QStringList &arguments);
+
+#endif // WEBBENCHMARK_H
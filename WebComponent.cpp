@@ -0,0 +1,225 @@
+#include "WebComponent.h"
+#include <QJsonObject>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+WebElementFields *fieldsOf(const WebElementData &element)
+{
+    WebElementFields *fields = new WebElementFields;
+    for (int field = 0; field < WebElementFieldCount; ++field)
+        fields->setValue(WebElementField(field), element.value(WebElementField(field)));
+    return fields;
+}
+
+void copyFields(const WebElementFields &fields, WebElementData &element)
+{
+    for (int field = 0; field < WebElementFieldCount; ++field)
+        element.setValue(WebElementField(field), fields.value(WebElementField(field)));
+}
+}
+
+const WebComponent *WebComponentLibrary::find(quint32 id) const
+{
+    for (const WebComponent &component : m_components) {
+        if (component.id == id)
+            return &component;
+    }
+    return nullptr;
+}
+
+const WebComponentPart *WebComponentLibrary::part(quint32 id, qint32 part) const
+{
+    const WebComponent *component = find(id);
+    if (!component || part < 0 || part >= component->parts.size())
+        return nullptr;
+    return &component->parts.at(part);
+}
+
+quint32 WebComponentLibrary::add(const QString &name, QList<WebElementData> &elements)
+{
+    if (elements.isEmpty()) return 0;
+
+    WebComponent component;
+    component.id = m_nextId++;
+    component.name = name;
+    component.parts.reserve(elements.size());
+    for (qsizetype i = 0; i < elements.size(); ++i) {
+        WebElementData &element = elements[i];
+        WebComponentPart part;
+        part.type = element.type;
+        part.geometry = QRectF(i == 0 ? 0 : element.x, i == 0 ? 0 : element.y, element.width, element.height);
+        part.parent = i == 0 ? -1 : element.parent;
+        part.fields = fieldsOf(element);
+        component.parts.append(part);
+
+        element.component = component.id;
+        element.part = qint32(i);
+        element.overrides = 0;
+    }
+    m_components.append(component);
+    return component.id;
+}
+
+void WebComponentLibrary::rename(quint32 id, const QString &name)
+{
+    for (WebComponent &component : m_components) {
+        if (component.id == id)
+            component.name = name;
+    }
+}
+
+void WebComponentLibrary::setFields(quint32 id, qint32 part, const WebElementFields &fields)
+{
+    for (WebComponent &component : m_components) {
+        if (component.id != id || part < 0 || part >= component.parts.size()) continue;
+        // A new master, instances still share the old one until they follow it
+        component.parts[part].fields = new WebElementFields(fields);
+    }
+}
+
+QSharedDataPointer<WebElementFields> WebComponentLibrary::fields(quint32 id, qint32 part) const
+{
+    const WebComponentPart *found = this->part(id, part);
+    return found ? found->fields : QSharedDataPointer<WebElementFields>();
+}
+
+QList<WebElementData> WebComponentLibrary::instantiate(quint32 id, const QPointF &position, qint32 firstIndex) const
+{
+    QList<WebElementData> elements;
+    const WebComponent *component = find(id);
+    if (!component) return elements;
+
+    elements.reserve(component->parts.size());
+    for (qsizetype i = 0; i < component->parts.size(); ++i) {
+        const WebComponentPart &part = component->parts.at(i);
+        WebElementData element;
+        element.type = part.type;
+        copyFields(*part.fields, element);
+        element.x = i == 0 ? position.x() : part.geometry.x();
+        element.y = i == 0 ? position.y() : part.geometry.y();
+        element.width = part.geometry.width();
+        element.height = part.geometry.height();
+        element.parent = part.parent < 0 ? -1 : firstIndex + part.parent;
+        element.component = id;
+        element.part = qint32(i);
+        elements.append(element);
+    }
+    // Every instance would repeat the same id otherwise
+    if (!elements.first().id.isEmpty()) {
+        elements.first().id.clear();
+        elements.first().overrides = WebElementData::fieldBit(WebElementField::Id);
+    }
+    return elements;
+}
+
+void WebComponentLibrary::resolve(WebElementData &element) const
+{
+    if (!element.isInstance()) return;
+
+    const WebComponentPart *found = part(element.component, element.part);
+    if (!found) {
+        element.component = 0;
+        element.part = -1;
+        element.overrides = 0;
+        return;
+    }
+
+    const WebElementFields &master = *found->fields;
+    for (int i = 0; i < WebElementFieldCount; ++i) {
+        const WebElementField field = WebElementField(i);
+        if (!(element.overrides & WebElementData::fieldBit(field)))
+            element.setValue(field, master.value(field));
+    }
+}
+
+QString WebComponentLibrary::className(quint32 id, qint32 part)
+{
+    return u"wd-c%1-%2"_s.arg(id).arg(part);
+}
+
+QString WebComponentLibrary::styleSheet() const
+{
+    QString css;
+    for (const WebComponent &component : m_components) {
+        for (qsizetype i = 0; i < component.parts.size(); ++i) {
+            const QString &style = component.parts.at(i).fields->value(WebElementField::Style);
+            if (style.isEmpty()) continue;
+            css += u"\n."_s + className(component.id, qint32(i)) + u" { "_s + style + u" }"_s;
+        }
+    }
+    return css;
+}
+
+QList<WebElementData> WebComponentLibrary::exportElements(const QList<WebElementData> &elements) const
+{
+    QList<WebElementData> exported = elements;
+    for (WebElementData &element : exported) {
+        resolve(element);
+        if (!element.isInstance()) continue;
+
+        // Overridden styles stay inline, where they win over the shared class
+        const WebComponentPart *found = part(element.component, element.part);
+        if (!found->fields->has(WebElementField::Style)) continue;
+        const QString shared = className(element.component, element.part);
+        element.cls = element.cls.isEmpty() ? shared : element.cls + u' ' + shared;
+        if (!(element.overrides & WebElementData::fieldBit(WebElementField::Style)))
+            element.style.clear();
+    }
+    return exported;
+}
+
+QJsonArray WebComponentLibrary::toJson() const
+{
+    QJsonArray components;
+    for (const WebComponent &component : m_components) {
+        QJsonArray parts;
+        for (const WebComponentPart &part : component.parts) {
+            WebElementData element;
+            element.type = part.type;
+            copyFields(*part.fields, element);
+            element.x = part.geometry.x();
+            element.y = part.geometry.y();
+            element.width = part.geometry.width();
+            element.height = part.geometry.height();
+            element.parent = part.parent;
+            parts.append(element.toJson());
+        }
+
+        QJsonObject object;
+        object["id"] = qint64(component.id);
+        object["name"] = component.name;
+        object["parts"] = parts;
+        components.append(object);
+    }
+    return components;
+}
+
+WebComponentLibrary WebComponentLibrary::fromJson(const QJsonArray &array)
+{
+    WebComponentLibrary library;
+    for (const QJsonValue &value : array) {
+        const QJsonObject object = value.toObject();
+        WebComponent component;
+        component.id = quint32(object["id"].toInteger());
+        component.name = object["name"].toString();
+
+        const QJsonArray parts = object["parts"].toArray();
+        for (const QJsonValue &partValue : parts) {
+            const WebElementData element = WebElementData::fromJson(partValue.toObject());
+            WebComponentPart part;
+            part.type = element.type;
+            part.geometry = QRectF(element.x, element.y, element.width, element.height);
+            // Parts come after their parent, others are moved under the root
+            const bool validParent = element.parent >= 0 && element.parent < component.parts.size();
+            part.parent = component.parts.isEmpty() ? -1 : validParent ? element.parent : 0;
+            part.fields = fieldsOf(element);
+            component.parts.append(part);
+        }
+
+        if (component.id == 0 || component.parts.isEmpty() || library.find(component.id)) continue;
+        library.m_nextId = qMax(library.m_nextId, component.id + 1);
+        library.m_components.append(component);
+    }
+    return library;
+}
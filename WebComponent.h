@@ -0,0 +1,79 @@
+#ifndef WEBCOMPONENT_H
+#define WEBCOMPONENT_H
+
+#include "WebElementData.h"
+#include <QJsonArray>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSharedDataPointer>
+#include <QString>
+
+// One element of a component's master copy
+struct WebComponentPart
+{
+    QString type;
+    // Relative to the parent part, the root's position is ignored
+    QRectF geometry;
+    // Index into the component's parts, -1 for the root
+    qint32 parent = -1;
+    // What instances of the part share until they override a field
+    QSharedDataPointer<WebElementFields> fields;
+};
+
+// A reusable group of elements such as a header, a footer or a card. Pages
+// only hold instances: each element of an instance names its component and
+// part and keeps the fields it overrides, everything else comes from the
+// master copy.
+struct WebComponent
+{
+    quint32 id = 0;
+    QString name;
+    // Root first, every part after its parent
+    QList<WebComponentPart> parts;
+};
+
+// The components of a project, shared by all of its pages. Saved with the
+// project properties as {"components": [{"id", "name", "parts"}]}.
+class WebComponentLibrary
+{
+public:
+    const QList<WebComponent> &components() const { return m_components; }
+    qsizetype size() const { return m_components.size(); }
+    bool isEmpty() const { return m_components.isEmpty(); }
+    const WebComponent *find(quint32 id) const;
+
+    // Turns elements, a root followed by its subtree with parents indexing
+    // into the list, into a new component. The elements are rewritten to be
+    // its first instance. Returns 0 when there is nothing to turn into one.
+    quint32 add(const QString &name, QList<WebElementData> &elements);
+    void rename(quint32 id, const QString &name);
+    // Replaces the master copy of one part's fields
+    void setFields(quint32 id, qint32 part, const WebElementFields &fields);
+    // Master copy of a part's fields, null for unknown parts
+    QSharedDataPointer<WebElementFields> fields(quint32 id, qint32 part) const;
+
+    // Elements of a new instance with its root at position, its parents
+    // counted from firstIndex in the list the elements are appended to
+    QList<WebElementData> instantiate(quint32 id, const QPointF &position, qint32 firstIndex) const;
+    // Fills the fields an instance does not override from its part; elements
+    // of unknown components become plain elements with the values they hold
+    void resolve(WebElementData &element) const;
+
+    // Export keeps styles of the master copy in one class per part instead
+    // of repeating them inline on every instance
+    static QString className(quint32 id, qint32 part);
+    QString styleSheet() const;
+    QList<WebElementData> exportElements(const QList<WebElementData> &elements) const;
+
+    QJsonArray toJson() const;
+    static WebComponentLibrary fromJson(const QJsonArray &array);
+
+private:
+    const WebComponentPart *part(quint32 id, qint32 part) const;
+
+    QList<WebComponent> m_components;
+    quint32 m_nextId = 1;
+};
+
+#endif // WEBCOMPONENT_H
@@ -0,0 +1,792 @@
+#include "WebCssParser.h"
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// Font size of the root element, what em and rem refer to without a font-size of their own
+constexpr qreal kDefaultFontSize = 16;
+// CSS "medium" border width, used when the border shorthand names no width
+constexpr qreal kMediumBorderWidth = 3;
+
+enum class TokenType : quint8 {
+    Ident,
+    Function,
+    AtKeyword,
+    Hash,
+    String,
+    Number,
+    Percentage,
+    Dimension,
+    Delim,
+    Whitespace,
+    Colon,
+    Semicolon,
+    Comma,
+    LeftBrace,
+    RightBrace,
+    LeftParen,
+    RightParen,
+    LeftBracket,
+    RightBracket,
+    End
+};
+
+struct Token
+{
+    TokenType type = TokenType::End;
+    // Span in the source, rule signatures are cut from it
+    qsizetype start = 0;
+    qsizetype end = 0;
+    // Name of idents, functions, at-keywords and hashes, contents of strings, unit of dimensions
+    QStringView value;
+    double number = 0;
+    QChar delim;
+};
+
+bool isNameStart(QChar c)
+{
+    return c.isLetter() || c == u'_' || c.unicode() >= 0x80;
+}
+
+bool isNameChar(QChar c)
+{
+    return isNameStart(c) || c.isDigit() || c == u'-';
+}
+
+// Splits CSS into tokens without copying, every token is a view into the source
+class Tokenizer
+{
+public:
+    explicit Tokenizer(QStringView css) : m_css(css), m_pos(0) {}
+
+    Token next();
+
+private:
+    QChar at(qsizetype pos) const { return pos < m_css.size() ? m_css[pos] : QChar(); }
+    bool startsName(qsizetype pos) const;
+    bool startsNumber(qsizetype pos) const;
+    qsizetype consumeName(qsizetype pos) const;
+
+    QStringView m_css;
+    qsizetype m_pos;
+};
+
+bool Tokenizer::startsName(qsizetype pos) const
+{
+    const QChar c = at(pos);
+    if (c == u'-')
+        return isNameStart(at(pos + 1)) || at(pos + 1) == u'-';
+    if (c == u'\\')
+        return pos + 1 < m_css.size() && at(pos + 1) != u'\n';
+    return isNameStart(c);
+}
+
+bool Tokenizer::startsNumber(qsizetype pos) const
+{
+    QChar c = at(pos);
+    if (c == u'+' || c == u'-')
+        c = at(++pos);
+    return c.isDigit() || (c == u'.' && at(pos + 1).isDigit());
+}
+
+qsizetype Tokenizer::consumeName(qsizetype pos) const
+{
+    // Escapes stay in the name as written, they only must not end it
+    while (pos < m_css.size()) {
+        if (m_css[pos] == u'\\' && pos + 1 < m_css.size())
+            pos += 2;
+        else if (isNameChar(m_css[pos]))
+            ++pos;
+        else
+            break;
+    }
+    return pos;
+}
+
+Token Tokenizer::next()
+{
+    while (m_css.sliced(m_pos).startsWith(u"/*")) {
+        qsizetype close = m_css.indexOf(u"*/", m_pos + 2);
+        m_pos = close < 0 ? m_css.size() : close + 2;
+    }
+
+    Token token;
+    token.start = m_pos;
+    if (m_pos >= m_css.size()) {
+        token.end = m_pos;
+        return token;
+    }
+
+    const QChar c = m_css[m_pos];
+    if (c.isSpace()) {
+        while (m_pos < m_css.size() && m_css[m_pos].isSpace())
+            ++m_pos;
+        token.type = TokenType::Whitespace;
+    } else if (c == u'"' || c == u'\'') {
+        // An unterminated string ends at the line break
+        qsizetype pos = m_pos + 1;
+        while (pos < m_css.size() && m_css[pos] != c && m_css[pos] != u'\n')
+            pos += m_css[pos] == u'\\' ? 2 : 1;
+        pos = qMin(pos, m_css.size());
+        token.type = TokenType::String;
+        token.value = m_css.sliced(m_pos + 1, pos - m_pos - 1);
+        m_pos = qMin(pos + 1, m_css.size());
+    } else if (startsNumber(m_pos)) {
+        qsizetype pos = m_pos;
+        if (at(pos) == u'+' || at(pos) == u'-')
+            ++pos;
+        while (at(pos).isDigit())
+            ++pos;
+        if (at(pos) == u'.' && at(pos + 1).isDigit()) {
+            pos += 2;
+            while (at(pos).isDigit())
+                ++pos;
+        }
+        token.number = m_css.sliced(m_pos, pos - m_pos).toDouble();
+
+        if (at(pos) == u'%') {
+            token.type = TokenType::Percentage;
+            ++pos;
+        } else if (startsName(pos)) {
+            qsizetype end = consumeName(pos);
+            token.type = TokenType::Dimension;
+            token.value = m_css.sliced(pos, end - pos);
+            pos = end;
+        } else {
+            token.type = TokenType::Number;
+        }
+        m_pos = pos;
+    } else if (startsName(m_pos)) {
+        qsizetype end = consumeName(m_pos);
+        token.value = m_css.sliced(m_pos, end - m_pos);
+        if (at(end) == u'(') {
+            token.type = TokenType::Function;
+            ++end;
+        } else {
+            token.type = TokenType::Ident;
+        }
+        m_pos = end;
+    } else if ((c == u'#' || c == u'@') && (isNameChar(at(m_pos + 1)) || at(m_pos + 1) == u'\\')) {
+        qsizetype end = consumeName(m_pos + 1);
+        token.type = c == u'#' ? TokenType::Hash : TokenType::AtKeyword;
+        token.value = m_css.sliced(m_pos + 1, end - m_pos - 1);
+        m_pos = end;
+    } else {
+        switch (c.unicode()) {
+        case u':': token.type = TokenType::Colon; break;
+        case u';': token.type = TokenType::Semicolon; break;
+        case u',': token.type = TokenType::Comma; break;
+        case u'{': token.type = TokenType::LeftBrace; break;
+        case u'}': token.type = TokenType::RightBrace; break;
+        case u'(': token.type = TokenType::LeftParen; break;
+        case u')': token.type = TokenType::RightParen; break;
+        case u'[': token.type = TokenType::LeftBracket; break;
+        case u']': token.type = TokenType::RightBracket; break;
+        default:
+            token.type = TokenType::Delim;
+            token.delim = c;
+            break;
+        }
+        ++m_pos;
+    }
+
+    token.end = m_pos;
+    return token;
+}
+
+QList<Token> tokenize(QStringView css)
+{
+    QList<Token> tokens;
+    Tokenizer tokenizer(css);
+    for (Token token = tokenizer.next(); token.type != TokenType::End; token = tokenizer.next())
+        tokens.append(token);
+    return tokens;
+}
+
+bool isDelim(const Token &token, char16_t c)
+{
+    return token.type == TokenType::Delim && token.delim == c;
+}
+
+bool isIdent(const Token &token, QLatin1StringView name)
+{
+    return token.type == TokenType::Ident && token.value.compare(name, Qt::CaseInsensitive) == 0;
+}
+
+// Value tokens without the whitespace between them, functions stay one token followed by their arguments
+QList<Token> significant(const QList<Token> &tokens)
+{
+    QList<Token> result;
+    result.reserve(tokens.size());
+    for (const Token &token : tokens) {
+        if (token.type != TokenType::Whitespace)
+            result.append(token);
+    }
+    return result;
+}
+
+struct NamedColor
+{
+    QLatin1StringView name;
+    quint32 color;
+};
+
+constexpr quint32 opaque(quint32 rgb)
+{
+    return 0xff000000u | rgb;
+}
+
+const NamedColor kNamedColors[] = {
+    {"transparent"_L1, 0x00000000u},
+    {"black"_L1, opaque(0x000000)}, {"white"_L1, opaque(0xffffff)},
+    {"red"_L1, opaque(0xff0000)}, {"green"_L1, opaque(0x008000)}, {"blue"_L1, opaque(0x0000ff)},
+    {"yellow"_L1, opaque(0xffff00)}, {"orange"_L1, opaque(0xffa500)}, {"purple"_L1, opaque(0x800080)},
+    {"gray"_L1, opaque(0x808080)}, {"grey"_L1, opaque(0x808080)}, {"silver"_L1, opaque(0xc0c0c0)},
+    {"maroon"_L1, opaque(0x800000)}, {"olive"_L1, opaque(0x808000)}, {"lime"_L1, opaque(0x00ff00)},
+    {"aqua"_L1, opaque(0x00ffff)}, {"cyan"_L1, opaque(0x00ffff)}, {"teal"_L1, opaque(0x008080)},
+    {"navy"_L1, opaque(0x000080)}, {"fuchsia"_L1, opaque(0xff00ff)}, {"magenta"_L1, opaque(0xff00ff)},
+    {"pink"_L1, opaque(0xffc0cb)}, {"hotpink"_L1, opaque(0xff69b4)}, {"deeppink"_L1, opaque(0xff1493)},
+    {"brown"_L1, opaque(0xa52a2a)}, {"gold"_L1, opaque(0xffd700)}, {"crimson"_L1, opaque(0xdc143c)},
+    {"coral"_L1, opaque(0xff7f50)}, {"tomato"_L1, opaque(0xff6347)}, {"salmon"_L1, opaque(0xfa8072)},
+    {"darkorange"_L1, opaque(0xff8c00)}, {"indigo"_L1, opaque(0x4b0082)}, {"violet"_L1, opaque(0xee82ee)},
+    {"orchid"_L1, opaque(0xda70d6)}, {"plum"_L1, opaque(0xdda0dd)}, {"khaki"_L1, opaque(0xf0e68c)},
+    {"beige"_L1, opaque(0xf5f5dc)}, {"ivory"_L1, opaque(0xfffff0)}, {"lavender"_L1, opaque(0xe6e6fa)},
+    {"tan"_L1, opaque(0xd2b48c)}, {"chocolate"_L1, opaque(0xd2691e)}, {"sienna"_L1, opaque(0xa0522d)},
+    {"turquoise"_L1, opaque(0x40e0d0)}, {"skyblue"_L1, opaque(0x87ceeb)}, {"steelblue"_L1, opaque(0x4682b4)},
+    {"royalblue"_L1, opaque(0x4169e1)}, {"dodgerblue"_L1, opaque(0x1e90ff)}, {"midnightblue"_L1, opaque(0x191970)},
+    {"lightblue"_L1, opaque(0xadd8e6)}, {"darkblue"_L1, opaque(0x00008b)}, {"aliceblue"_L1, opaque(0xf0f8ff)},
+    {"lightgreen"_L1, opaque(0x90ee90)}, {"darkgreen"_L1, opaque(0x006400)}, {"forestgreen"_L1, opaque(0x228b22)},
+    {"seagreen"_L1, opaque(0x2e8b57)}, {"honeydew"_L1, opaque(0xf0fff0)}, {"mintcream"_L1, opaque(0xf5fffa)},
+    {"darkred"_L1, opaque(0x8b0000)}, {"lightyellow"_L1, opaque(0xffffe0)},
+    {"lightgray"_L1, opaque(0xd3d3d3)}, {"lightgrey"_L1, opaque(0xd3d3d3)},
+    {"darkgray"_L1, opaque(0xa9a9a9)}, {"darkgrey"_L1, opaque(0xa9a9a9)}, {"dimgray"_L1, opaque(0x696969)},
+    {"slategray"_L1, opaque(0x708090)}, {"darkslategray"_L1, opaque(0x2f4f4f)},
+    {"gainsboro"_L1, opaque(0xdcdcdc)}, {"whitesmoke"_L1, opaque(0xf5f5f5)},
+};
+
+bool parseHexColor(QStringView hex, quint32 *color)
+{
+    bool ok = false;
+    const quint32 value = hex.toUInt(&ok, 16);
+    if (!ok) return false;
+
+    // Short forms repeat every digit, #rgb is #rrggbb
+    auto expand = [](quint32 digit) { return digit << 4 | digit; };
+    switch (hex.size()) {
+    case 3:
+        *color = opaque(expand(value >> 8 & 0xf) << 16 | expand(value >> 4 & 0xf) << 8 | expand(value & 0xf));
+        return true;
+    case 4:
+        *color = expand(value & 0xf) << 24 | expand(value >> 12 & 0xf) << 16
+                 | expand(value >> 8 & 0xf) << 8 | expand(value >> 4 & 0xf);
+        return true;
+    case 6:
+        *color = opaque(value);
+        return true;
+    case 8:
+        // CSS puts alpha last, WebStyle first
+        *color = (value & 0xff) << 24 | value >> 8;
+        return true;
+    default:
+        return false;
+    }
+}
+
+quint32 channel(const Token &token, qreal scale)
+{
+    qreal value = token.type == TokenType::Percentage ? token.number * 2.55 : token.number * scale;
+    return quint32(qBound(0.0, value, 255.0) + 0.5);
+}
+
+// Reads a color starting at tokens[index], which has no whitespace tokens, and moves index past it
+bool colorAt(const QList<Token> &tokens, qsizetype &index, quint32 *color)
+{
+    if (index >= tokens.size()) return false;
+    const Token &token = tokens.at(index);
+
+    if (token.type == TokenType::Hash) {
+        if (!parseHexColor(token.value, color)) return false;
+        ++index;
+        return true;
+    }
+
+    if (token.type == TokenType::Ident) {
+        for (const NamedColor &named : kNamedColors) {
+            if (token.value.compare(named.name, Qt::CaseInsensitive) == 0) {
+                *color = named.color;
+                ++index;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (token.type != TokenType::Function
+        || !(token.value.compare("rgb"_L1, Qt::CaseInsensitive) == 0
+             || token.value.compare("rgba"_L1, Qt::CaseInsensitive) == 0)) {
+        return false;
+    }
+
+    // rgb(1, 2, 3), rgba(1, 2, 3, 0.5) and the space separated rgb(1 2 3 / 50%)
+    QList<Token> arguments;
+    qsizetype pos = index + 1;
+    for (; pos < tokens.size() && tokens.at(pos).type != TokenType::RightParen; ++pos) {
+        const Token &argument = tokens.at(pos);
+        if (argument.type == TokenType::Number || argument.type == TokenType::Percentage)
+            arguments.append(argument);
+        else if (argument.type != TokenType::Comma && !isDelim(argument, u'/'))
+            return false;
+    }
+    if (arguments.size() != 3 && arguments.size() != 4) return false;
+
+    quint32 alpha = arguments.size() == 4 ? channel(arguments.at(3), 255) : 255;
+    *color = alpha << 24 | channel(arguments.at(0), 1) << 16 | channel(arguments.at(1), 1) << 8
+             | channel(arguments.at(2), 1);
+    index = qMin(pos + 1, tokens.size());
+    return true;
+}
+
+bool lengthOf(const Token &token, qreal fontSize, qreal *pixels)
+{
+    if (token.type == TokenType::Number) {
+        // Unitless lengths are pixels, as in quirks mode
+        *pixels = token.number;
+        return true;
+    }
+    if (token.type != TokenType::Dimension)
+        return false;
+
+    const struct {
+        QLatin1StringView unit;
+        qreal pixels;
+    } units[] = {
+        {"px"_L1, 1}, {"pt"_L1, 96.0 / 72}, {"pc"_L1, 16}, {"in"_L1, 96},
+        {"cm"_L1, 96 / 2.54}, {"mm"_L1, 96 / 25.4}, {"em"_L1, fontSize}, {"rem"_L1, kDefaultFontSize},
+    };
+    for (const auto &unit : units) {
+        if (token.value.compare(unit.unit, Qt::CaseInsensitive) == 0) {
+            *pixels = token.number * unit.pixels;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool fontSizeOf(const Token &token, qreal fontSize, qreal *pixels)
+{
+    const struct {
+        QLatin1StringView name;
+        qreal pixels;
+    } keywords[] = {
+        {"xx-small"_L1, 9}, {"x-small"_L1, 10}, {"small"_L1, 13}, {"medium"_L1, 16},
+        {"large"_L1, 18}, {"x-large"_L1, 24}, {"xx-large"_L1, 32},
+    };
+    for (const auto &keyword : keywords) {
+        if (isIdent(token, keyword.name)) {
+            *pixels = keyword.pixels;
+            return true;
+        }
+    }
+    if (token.type == TokenType::Percentage) {
+        *pixels = token.number * fontSize / 100;
+        return true;
+    }
+    return lengthOf(token, fontSize, pixels) && *pixels > 0;
+}
+
+bool fontWeightOf(const Token &token, quint16 *weight)
+{
+    if (token.type == TokenType::Number && token.number >= 1 && token.number <= 1000) {
+        *weight = quint16(token.number);
+        return true;
+    }
+    if (isIdent(token, "normal"_L1)) *weight = 400;
+    else if (isIdent(token, "bold"_L1) || isIdent(token, "bolder"_L1)) *weight = 700;
+    else if (isIdent(token, "lighter"_L1)) *weight = 300;
+    else return false;
+    return true;
+}
+
+bool borderWidthOf(const Token &token, qreal fontSize, qreal *width)
+{
+    if (isIdent(token, "thin"_L1)) *width = 1;
+    else if (isIdent(token, "medium"_L1)) *width = kMediumBorderWidth;
+    else if (isIdent(token, "thick"_L1)) *width = 5;
+    else return lengthOf(token, fontSize, width) && *width >= 0;
+    return true;
+}
+
+bool borderStyleOf(const Token &token, WebStyle::Border *border)
+{
+    if (token.type != TokenType::Ident) return false;
+
+    if (isIdent(token, "none"_L1) || isIdent(token, "hidden"_L1)) *border = WebStyle::NoBorder;
+    else if (isIdent(token, "dashed"_L1)) *border = WebStyle::DashedBorder;
+    else if (isIdent(token, "dotted"_L1)) *border = WebStyle::DottedBorder;
+    // The 3D styles and double are drawn as plain lines
+    else if (isIdent(token, "solid"_L1) || isIdent(token, "double"_L1) || isIdent(token, "groove"_L1)
+             || isIdent(token, "ridge"_L1) || isIdent(token, "inset"_L1) || isIdent(token, "outset"_L1))
+        *border = WebStyle::SolidBorder;
+    else return false;
+    return true;
+}
+
+// First family of a font-family list, quoted or as a run of identifiers
+QString fontFamilyOf(const QList<Token> &tokens, qsizetype index)
+{
+    if (index < tokens.size() && tokens.at(index).type == TokenType::String)
+        return tokens.at(index).value.toString();
+
+    QStringList words;
+    for (; index < tokens.size() && tokens.at(index).type == TokenType::Ident; ++index)
+        words.append(tokens.at(index).value.toString());
+    return words.join(u' ');
+}
+
+void applyFont(const QList<Token> &tokens, WebStyle *style)
+{
+    // [style] [weight] size[/line-height] family, the size and family are required
+    qsizetype index = 0;
+    bool italic = false;
+    quint16 weight = 400;
+    qreal size = 0;
+    for (; index < tokens.size(); ++index) {
+        const Token &token = tokens.at(index);
+        if (isIdent(token, "italic"_L1) || isIdent(token, "oblique"_L1))
+            italic = true;
+        else if (isIdent(token, "normal"_L1) || isIdent(token, "small-caps"_L1))
+            continue;
+        else if (!fontWeightOf(token, &weight))
+            break;
+    }
+    if (index >= tokens.size() || !fontSizeOf(tokens.at(index), kDefaultFontSize, &size))
+        return;
+    ++index;
+    if (index + 1 < tokens.size() && isDelim(tokens.at(index), u'/'))
+        index += 2;
+
+    QString family = fontFamilyOf(tokens, index);
+    if (family.isEmpty())
+        return;
+
+    style->italic = italic;
+    style->fontWeight = weight;
+    style->fontSize = size;
+    style->fontFamily = family;
+    style->defined |= WebStyle::FontStyle | WebStyle::FontWeight | WebStyle::FontSize | WebStyle::FontFamily;
+}
+
+void applyBorder(const QList<Token> &tokens, WebStyle *style)
+{
+    // Omitted parts of the shorthand go back to their initial values
+    qreal width = kMediumBorderWidth;
+    WebStyle::Border border = WebStyle::NoBorder;
+    quint32 color = 0;
+    bool hasColor = false;
+    const qreal fontSize = style->has(WebStyle::FontSize) ? style->fontSize : kDefaultFontSize;
+
+    for (qsizetype index = 0; index < tokens.size();) {
+        if (borderWidthOf(tokens.at(index), fontSize, &width) || borderStyleOf(tokens.at(index), &border)) {
+            ++index;
+        } else if (colorAt(tokens, index, &color)) {
+            hasColor = true;
+        } else {
+            return;
+        }
+    }
+
+    style->borderWidth = width;
+    style->borderStyle = border;
+    style->defined |= WebStyle::BorderWidth | WebStyle::BorderStyle;
+    if (hasColor) {
+        style->borderColor = color;
+        style->defined |= WebStyle::BorderColor;
+    } else {
+        // currentColor, resolved against the text color when drawing
+        style->defined &= ~WebStyle::BorderColor;
+    }
+}
+
+void applyProperty(QStringView name, const QList<Token> &tokens, WebStyle *style)
+{
+    const Token &first = tokens.constFirst();
+    const qreal fontSize = style->has(WebStyle::FontSize) ? style->fontSize : kDefaultFontSize;
+    qsizetype index = 0;
+    quint32 color = 0;
+    qreal length = 0;
+
+    if (name == "color"_L1) {
+        if (colorAt(tokens, index, &color)) {
+            style->color = color;
+            style->defined |= WebStyle::Color;
+        }
+    } else if (name == "background-color"_L1 || name == "background"_L1) {
+        // The shorthand may carry images and positions as well, only its color is used
+        for (index = 0; index < tokens.size(); ++index) {
+            qsizetype at = index;
+            if (colorAt(tokens, at, &color)) {
+                style->backgroundColor = color;
+                style->defined |= WebStyle::BackgroundColor;
+                break;
+            }
+        }
+    } else if (name == "font"_L1) {
+        applyFont(tokens, style);
+    } else if (name == "font-family"_L1) {
+        QString family = fontFamilyOf(tokens, 0);
+        if (!family.isEmpty()) {
+            style->fontFamily = family;
+            style->defined |= WebStyle::FontFamily;
+        }
+    } else if (name == "font-size"_L1) {
+        if (fontSizeOf(first, kDefaultFontSize, &length)) {
+            style->fontSize = length;
+            style->defined |= WebStyle::FontSize;
+        }
+    } else if (name == "font-weight"_L1) {
+        if (fontWeightOf(first, &style->fontWeight))
+            style->defined |= WebStyle::FontWeight;
+    } else if (name == "font-style"_L1) {
+        if (isIdent(first, "italic"_L1) || isIdent(first, "oblique"_L1) || isIdent(first, "normal"_L1)) {
+            style->italic = !isIdent(first, "normal"_L1);
+            style->defined |= WebStyle::FontStyle;
+        }
+    } else if (name == "border"_L1) {
+        applyBorder(tokens, style);
+    } else if (name == "border-width"_L1) {
+        if (borderWidthOf(first, fontSize, &length)) {
+            style->borderWidth = length;
+            style->defined |= WebStyle::BorderWidth;
+        }
+    } else if (name == "border-style"_L1) {
+        if (borderStyleOf(first, &style->borderStyle))
+            style->defined |= WebStyle::BorderStyle;
+    } else if (name == "border-color"_L1) {
+        if (colorAt(tokens, index, &color)) {
+            style->borderColor = color;
+            style->defined |= WebStyle::BorderColor;
+        }
+    } else if (name == "width"_L1 || name == "height"_L1) {
+        if (lengthOf(first, fontSize, &length) && length >= 0) {
+            const bool width = name == "width"_L1;
+            (width ? style->width : style->height) = length;
+            style->defined |= width ? WebStyle::Width : WebStyle::Height;
+        }
+    }
+}
+
+// One "name: value" declaration, without its semicolon
+void applyDeclaration(const QList<Token> &declaration, WebStyle *style)
+{
+    QList<Token> tokens = significant(declaration);
+    if (tokens.size() < 3 || tokens.at(0).type != TokenType::Ident || tokens.at(1).type != TokenType::Colon)
+        return;
+
+    // Importance is not tracked, an !important declaration applies like any other
+    if (tokens.size() >= 4 && isIdent(tokens.constLast(), "important"_L1) && isDelim(tokens.at(tokens.size() - 2), u'!'))
+        tokens.resize(tokens.size() - 2);
+
+    const QString name = tokens.at(0).value.toString().toLower();
+    tokens.remove(0, 2);
+    if (!tokens.isEmpty())
+        applyProperty(name, tokens, style);
+}
+
+WebStyle compileDeclarations(const QList<Token> &tokens)
+{
+    WebStyle style;
+    qsizetype start = 0;
+    int depth = 0;
+    for (qsizetype i = 0; i <= tokens.size(); ++i) {
+        if (i < tokens.size()) {
+            const TokenType type = tokens.at(i).type;
+            if (type == TokenType::Function || type == TokenType::LeftParen) ++depth;
+            else if (type == TokenType::RightParen) depth = qMax(0, depth - 1);
+            if (type != TokenType::Semicolon || depth > 0) continue;
+        }
+        applyDeclaration(tokens.mid(start, i - start), &style);
+        start = i + 1;
+    }
+    return style;
+}
+
+// One selector of a selector list; anything the canvas cannot evaluate
+// (pseudo-classes, attribute selectors, sibling combinators) rejects it
+bool parseSelector(const QList<Token> &tokens, WebCssSelector *selector)
+{
+    WebCssCompound current;
+    bool open = false;
+    bool space = false;
+
+    for (qsizetype i = 0; i < tokens.size(); ++i) {
+        const Token &token = tokens.at(i);
+        if (token.type == TokenType::Whitespace) {
+            space = open;
+            continue;
+        }
+        if (isDelim(token, u'>')) {
+            if (!open) return false;
+            selector->compounds.append(current);
+            current = WebCssCompound();
+            current.combinator = WebCssCompound::Child;
+            open = false;
+            space = false;
+            continue;
+        }
+
+        if (open && space) {
+            selector->compounds.append(current);
+            current = WebCssCompound();
+            current.combinator = WebCssCompound::Descendant;
+            open = false;
+        }
+        space = false;
+
+        if (token.type == TokenType::Ident) {
+            if (open) return false;
+            current.tag = token.value.toString().toLower();
+        } else if (isDelim(token, u'*')) {
+            if (open) return false;
+        } else if (isDelim(token, u'.') && i + 1 < tokens.size() && tokens.at(i + 1).type == TokenType::Ident) {
+            current.classes.append(tokens.at(++i).value.toString());
+        } else if (token.type == TokenType::Hash) {
+            current.id = token.value.toString();
+        } else {
+            return false;
+        }
+        open = true;
+    }
+
+    if (!open) return false;
+    selector->compounds.append(current);
+    return true;
+}
+
+class Parser
+{
+public:
+    explicit Parser(QStringView css) : m_css(css), m_tokenizer(css) { advance(); }
+
+    WebStyleSheet parseStyleSheet();
+
+private:
+    void advance() { m_token = m_tokenizer.next(); }
+    void skipAtRule();
+    QList<Token> consumeBlock();
+    void addRules(WebStyleSheet *sheet, const QList<Token> &prelude, const QList<Token> &block) const;
+    QString text(const QList<Token> &tokens, qsizetype from, qsizetype to) const;
+
+    QStringView m_css;
+    Tokenizer m_tokenizer;
+    Token m_token;
+};
+
+WebStyleSheet Parser::parseStyleSheet()
+{
+    WebStyleSheet sheet;
+    while (m_token.type != TokenType::End) {
+        const TokenType type = m_token.type;
+        if (type == TokenType::Whitespace || type == TokenType::RightBrace || type == TokenType::Semicolon) {
+            advance();
+            continue;
+        }
+        if (type == TokenType::AtKeyword) {
+            skipAtRule();
+            continue;
+        }
+
+        QList<Token> prelude;
+        for (; m_token.type != TokenType::End && m_token.type != TokenType::LeftBrace; advance())
+            prelude.append(m_token);
+        if (m_token.type == TokenType::End)
+            break;
+
+        advance();
+        addRules(&sheet, prelude, consumeBlock());
+    }
+    return sheet;
+}
+
+void Parser::skipAtRule()
+{
+    // @media, @import and the like do not apply to the canvas
+    for (; m_token.type != TokenType::End; advance()) {
+        if (m_token.type == TokenType::Semicolon) {
+            advance();
+            return;
+        }
+        if (m_token.type == TokenType::LeftBrace) {
+            advance();
+            consumeBlock();
+            return;
+        }
+    }
+}
+
+QList<Token> Parser::consumeBlock()
+{
+    // Tokens up to the matching brace, which is consumed as well
+    QList<Token> tokens;
+    int depth = 0;
+    for (; m_token.type != TokenType::End; advance()) {
+        if (m_token.type == TokenType::LeftBrace) {
+            ++depth;
+        } else if (m_token.type == TokenType::RightBrace && depth-- == 0) {
+            advance();
+            break;
+        }
+        tokens.append(m_token);
+    }
+    return tokens;
+}
+
+void Parser::addRules(WebStyleSheet *sheet, const QList<Token> &prelude, const QList<Token> &block) const
+{
+    const WebStyle style = compileDeclarations(block);
+    if (style.isEmpty())
+        return;
+
+    // One invalid selector drops the whole list, as in a browser
+    QList<WebCssRule> rules;
+    const QString declarations = text(block, 0, block.size());
+    qsizetype start = 0;
+    for (qsizetype i = 0; i <= prelude.size(); ++i) {
+        if (i < prelude.size() && prelude.at(i).type != TokenType::Comma) continue;
+
+        WebCssRule rule;
+        if (!parseSelector(prelude.mid(start, i - start), &rule.selector))
+            return;
+        rule.style = style;
+        rule.signature = text(prelude, start, i) + u"{"_s + declarations + u"}"_s;
+        rules.append(rule);
+        start = i + 1;
+    }
+
+    for (const WebCssRule &rule : std::as_const(rules))
+        sheet->addRule(rule);
+}
+
+QString Parser::text(const QList<Token> &tokens, qsizetype from, qsizetype to) const
+{
+    if (from >= to) return QString();
+    const qsizetype start = tokens.at(from).start;
+    return m_css.sliced(start, tokens.at(to - 1).end - start).toString().simplified();
+}
+}
+
+WebStyleSheet WebCssParser::parseStyleSheet(QStringView css)
+{
+    return Parser(css).parseStyleSheet();
+}
+
+WebStyle WebCssParser::parseDeclarations(QStringView declarations)
+{
+    return compileDeclarations(tokenize(declarations));
+}
+
+bool WebCssParser::parseColor(QStringView value, quint32 *color)
+{
+    const QList<Token> tokens = significant(tokenize(value));
+    qsizetype index = 0;
+    return colorAt(tokens, index, color) && index == tokens.size();
+}
@@ -0,0 +1,23 @@
+#ifndef WEBCSSPARSER_H
+#define WEBCSSPARSER_H
+
+#include "WebStyleSheet.h"
+#include <QStringView>
+
+// Compiles CSS text for the canvas. A tokenizer in the spirit of CSS Syntax
+// Level 3 feeds a small parser: rules with type, class, id and compound
+// selectors joined by descendant or child combinators, and declarations of
+// the properties WebStyle knows. Everything else (at-rules, pseudo-classes,
+// unknown properties) is skipped the way a browser skips what it does not
+// understand, so a half-typed sheet still compiles what it can.
+class WebCssParser
+{
+public:
+    static WebStyleSheet parseStyleSheet(QStringView css);
+    // Body of a style attribute, "color: red; border: 1px solid"
+    static WebStyle parseDeclarations(QStringView declarations);
+    // Parses a color value, returns false for anything that is not one
+    static bool parseColor(QStringView value, quint32 *color);
+};
+
+#endif // WEBCSSPARSER_H
@@ -0,0 +1,226 @@
+#include "WebDesignCommands.h"
+#include "WebDesignScene.h"
+#include "WebDesignSerializer.h"
+#include <QObject>
+#include <algorithm>
+
+namespace {
+qsizetype elementBytes(const WebElementData &element)
+{
+    return (element.type.size() + element.id.size() + element.cls.size()
+            + element.text.size() + element.style.size()) * qsizetype(sizeof(char16_t));
+}
+}
+
+WebCreateElementCommand::WebCreateElementCommand(WebDesignScene *scene, const WebElementData &element)
+    : m_scene(scene), m_element(element), m_slot(scene->elementCount())
+{
+    setText(QObject::tr("Create %1").arg(element.type));
+}
+
+void WebCreateElementCommand::undo()
+{
+    // Later elements were undone first, so this one is the last slot again
+    m_scene->removeElement(m_scene->elementAt(m_slot));
+}
+
+void WebCreateElementCommand::redo()
+{
+    m_scene->appendElement(m_element);
+}
+
+qsizetype WebCreateElementCommand::byteSize() const
+{
+    return sizeof(*this) + elementBytes(m_element);
+}
+
+WebGeometryCommand::WebGeometryCommand(WebDesignScene *scene, const QList<WebGeometryChange> &changes,
+                                       const QString &text)
+    : m_scene(scene), m_changes(changes)
+{
+    if (!text.isEmpty()) {
+        setText(text);
+        return;
+    }
+    bool resized = std::any_of(changes.cbegin(), changes.cend(), [](const WebGeometryChange &change) {
+        return change.from.size() != change.to.size();
+    });
+    setText(resized ? QObject::tr("Resize") : QObject::tr("Move"));
+}
+
+void WebGeometryCommand::undo()
+{
+    m_scene->applyGeometry(m_changes, false);
+}
+
+void WebGeometryCommand::redo()
+{
+    m_scene->applyGeometry(m_changes, true);
+}
+
+qsizetype WebGeometryCommand::byteSize() const
+{
+    return sizeof(*this) + m_changes.size() * qsizetype(sizeof(WebGeometryChange));
+}
+
+WebParentCommand::WebParentCommand(WebDesignScene *scene, const QList<WebParentChange> &changes)
+    : m_scene(scene), m_changes(changes)
+{
+    setText(QObject::tr("Change Parent"));
+}
+
+void WebParentCommand::undo()
+{
+    for (auto it = m_changes.crbegin(); it != m_changes.crend(); ++it) {
+        if (WebElementItem *item = elementAt(it->slot))
+            m_scene->setElementParent(item, elementAt(it->from));
+    }
+}
+
+void WebParentCommand::redo()
+{
+    for (const WebParentChange &change : std::as_const(m_changes)) {
+        if (WebElementItem *item = elementAt(change.slot))
+            m_scene->setElementParent(item, elementAt(change.to));
+    }
+}
+
+WebElementItem *WebParentCommand::elementAt(qsizetype slot) const
+{
+    return slot >= 0 ? m_scene->elementAt(slot) : nullptr;
+}
+
+qsizetype WebParentCommand::byteSize() const
+{
+    return sizeof(*this) + m_changes.size() * qsizetype(sizeof(WebParentChange));
+}
+
+WebPropertyCommand::WebPropertyCommand(WebDesignScene *scene, qsizetype slot, WebElementField field,
+                                       const QString &from, const QString &to)
+    : WebPropertyCommand(scene, {WebPropertyChange{slot, from}}, field, to)
+{
+}
+
+WebPropertyCommand::WebPropertyCommand(WebDesignScene *scene, const QList<WebPropertyChange> &changes,
+                                       WebElementField field, const QString &to)
+    : m_scene(scene), m_changes(changes), m_field(field), m_to(to)
+{
+    switch (field) {
+    case WebElementField::Id: setText(QObject::tr("Change ID")); break;
+    case WebElementField::Class: setText(QObject::tr("Change Class")); break;
+    case WebElementField::Text: setText(QObject::tr("Change Text")); break;
+    case WebElementField::Style: setText(QObject::tr("Change Style")); break;
+    case WebElementField::Href: setText(QObject::tr("Change Link")); break;
+    case WebElementField::Src: setText(QObject::tr("Change Source")); break;
+    case WebElementField::Alt: setText(QObject::tr("Change Alternative Text")); break;
+    }
+}
+
+void WebPropertyCommand::undo()
+{
+    for (const WebPropertyChange &change : std::as_const(m_changes)) {
+        if (WebElementItem *item = m_scene->elementAt(change.slot))
+            setValue(item, m_field, change.from);
+    }
+}
+
+void WebPropertyCommand::redo()
+{
+    for (const WebPropertyChange &change : std::as_const(m_changes)) {
+        if (WebElementItem *item = m_scene->elementAt(change.slot))
+            setValue(item, m_field, m_to);
+    }
+}
+
+bool WebPropertyCommand::mergeWith(const QUndoCommand *other)
+{
+    // Typing into one field is one step, only the oldest and newest values are kept
+    const WebPropertyCommand *edit = static_cast<const WebPropertyCommand*>(other);
+    if (edit->m_field != m_field || edit->m_changes.size() != m_changes.size())
+        return false;
+    for (qsizetype i = 0; i < m_changes.size(); ++i) {
+        if (edit->m_changes.at(i).slot != m_changes.at(i).slot)
+            return false;
+    }
+
+    m_to = edit->m_to;
+    return true;
+}
+
+qsizetype WebPropertyCommand::byteSize() const
+{
+    qsizetype size = sizeof(*this) + stringBytes(m_to);
+    for (const WebPropertyChange &change : m_changes)
+        size += qsizetype(sizeof(WebPropertyChange)) + stringBytes(change.from);
+    return size;
+}
+
+QString WebPropertyCommand::value(const WebElementItem *item, WebElementField field)
+{
+    return item->elementField(field);
+}
+
+void WebPropertyCommand::setValue(WebElementItem *item, WebElementField field, const QString &value)
+{
+    item->setElementField(field, value);
+}
+
+WebVisibilityCommand::WebVisibilityCommand(WebDesignScene *scene, const QList<qsizetype> &elements,
+                                           bool visible)
+    : m_scene(scene), m_elements(elements), m_visible(visible)
+{
+    setText(visible ? QObject::tr("Show All") : QObject::tr("Hide"));
+}
+
+void WebVisibilityCommand::undo()
+{
+    apply(!m_visible);
+}
+
+void WebVisibilityCommand::redo()
+{
+    apply(m_visible);
+}
+
+void WebVisibilityCommand::apply(bool visible)
+{
+    // Hidden records of a mapped design are created to be shown
+    for (qsizetype slot : std::as_const(m_elements)) {
+        if (WebElementItem *item = m_scene->materializeElement(slot))
+            m_scene->setElementVisible(item, visible);
+    }
+}
+
+qsizetype WebVisibilityCommand::byteSize() const
+{
+    return sizeof(*this) + m_elements.size() * qsizetype(sizeof(qsizetype));
+}
+
+WebClearCommand::WebClearCommand(WebDesignScene *scene)
+    : m_scene(scene)
+{
+    setText(QObject::tr("Clear"));
+}
+
+void WebClearCommand::undo()
+{
+    WebDesignDocument document;
+    WebDesignSerializer::fromBinary(m_elements, &document);
+    m_scene->loadElements(document.elements);
+}
+
+void WebClearCommand::redo()
+{
+    // The snapshot is taken once, redoing after an undo clears the same elements
+    if (m_elements.isEmpty()) {
+        WebDesignDocument document;
+        document.elements = m_scene->snapshot();
+        m_elements = WebDesignSerializer::toBinary(document);
+    }
+    m_scene->clear();
+}
+
+qsizetype WebClearCommand::byteSize() const
+{
+    return sizeof(*this) + m_elements.size();
+}
@@ -0,0 +1,148 @@
+#ifndef WEBDESIGNCOMMANDS_H
+#define WEBDESIGNCOMMANDS_H
+
+#include "WebUndoStack.h"
+#include "WebElementItem.h"
+#include <QByteArray>
+#include <QList>
+#include <QRectF>
+
+class WebDesignScene;
+
+// Commands refer to elements by their slot in the scene's document order.
+// History is linear, so a slot always names the same element when the
+// command is undone or redone, while item pointers do not survive a removal.
+
+class WebCreateElementCommand : public WebUndoCommand
+{
+public:
+    WebCreateElementCommand(WebDesignScene *scene, const WebElementData &element);
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    WebDesignScene *m_scene;
+    WebElementData m_element;
+    qsizetype m_slot;
+};
+
+struct WebGeometryChange
+{
+    qsizetype slot;
+    QRectF from;
+    QRectF to;
+};
+
+// Covers both moves and resizes, a drag of several selected elements is one command.
+// Without a text it is named after what changed.
+class WebGeometryCommand : public WebUndoCommand
+{
+public:
+    WebGeometryCommand(WebDesignScene *scene, const QList<WebGeometryChange> &changes,
+                       const QString &text = QString());
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    WebDesignScene *m_scene;
+    QList<WebGeometryChange> m_changes;
+};
+
+// Parents are slots as well, -1 stands for the top level
+struct WebParentChange
+{
+    qsizetype slot;
+    qsizetype from;
+    qsizetype to;
+};
+
+// Moves elements in or out of containers. Elements keep their place on the
+// canvas, so it pairs with a WebGeometryCommand for a drag onto a container.
+class WebParentCommand : public WebUndoCommand
+{
+public:
+    WebParentCommand(WebDesignScene *scene, const QList<WebParentChange> &changes);
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    WebElementItem *elementAt(qsizetype slot) const;
+
+    WebDesignScene *m_scene;
+    QList<WebParentChange> m_changes;
+};
+
+struct WebPropertyChange
+{
+    qsizetype slot;
+    QString from;
+};
+
+// Sets one field to the same value on one or more elements
+class WebPropertyCommand : public WebUndoCommand
+{
+public:
+    enum { Id = 1 };
+
+    WebPropertyCommand(WebDesignScene *scene, qsizetype slot, WebElementField field,
+                       const QString &from, const QString &to);
+    WebPropertyCommand(WebDesignScene *scene, const QList<WebPropertyChange> &changes,
+                       WebElementField field, const QString &to);
+
+    void undo() override;
+    void redo() override;
+    int id() const override { return Id; }
+    bool mergeWith(const QUndoCommand *other) override;
+    qsizetype byteSize() const override;
+
+    static QString value(const WebElementItem *item, WebElementField field);
+    static void setValue(WebElementItem *item, WebElementField field, const QString &value);
+
+private:
+    WebDesignScene *m_scene;
+    QList<WebPropertyChange> m_changes;
+    WebElementField m_field;
+    QString m_to;
+};
+
+// Hides or shows elements on the canvas, each listed element changes state
+class WebVisibilityCommand : public WebUndoCommand
+{
+public:
+    WebVisibilityCommand(WebDesignScene *scene, const QList<qsizetype> &elements, bool visible);
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    void apply(bool visible);
+
+    WebDesignScene *m_scene;
+    QList<qsizetype> m_elements;
+    bool m_visible;
+};
+
+// Keeps the removed elements in the binary design encoding, where every
+// distinct string is stored once, instead of a JSON snapshot
+class WebClearCommand : public WebUndoCommand
+{
+public:
+    explicit WebClearCommand(WebDesignScene *scene);
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    WebDesignScene *m_scene;
+    QByteArray m_elements;
+};
+
+#endif // WEBDESIGNCOMMANDS_H
@@ -1,40 +1,898 @@
 #include "WebDesignScene.h"
+#include "WebComponent.h"
 #include "WebElementItem.h"
+#include "WebDesignSerializer.h"
+#include "WebElementTree.h"
+#include "WebInlineEditor.h"
+#include "WebDesignCommands.h"
+#include "WebUndoStack.h"
+#include "WebProfiler.h"
 #include <QMimeData>
 #include <QGraphicsView>
 #include <QJsonObject>
 #include <QGraphicsSceneEvent>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QTimer>
+#include <QSignalBlocker>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// What snapping lines up: the box as drawn, in scene coordinates
+QRectF edgeRect(const WebElementItem *item)
+{
+    return item->mapRectToScene(item->displayRect());
+}
+}
 
 WebDesignScene::WebDesignScene(QObject *parent)
-    : QGraphicsScene(parent)
+    : QGraphicsScene(parent), m_components(nullptr), m_selectionAnchor(nullptr), m_indexStrategy(TunedBspDepth), m_dragUnindexed(false),
+      m_edgeIndexStale(false), m_searchIndexStale(false), m_snapEnabled(true), m_snapping(false),
+      m_maxPendingHeight(0), m_pendingCount(0), m_materializeQueued(false), m_frameStart(-1)
 {
-    setSceneRect(0, 0, 1200, 800);
+    setSceneRect(0, 0, MinimumSceneWidth, MinimumSceneHeight);
     setBackgroundBrush(QColor(240, 240, 240));
+
+    m_editor = new WebInlineEditor;
+    addItem(m_editor);
+    connect(m_editor, &WebInlineEditor::textCommitted, this, &WebDesignScene::elementTextEdited);
+
+    m_undoStack = new WebUndoStack(this);
 }
 
 void WebDesignScene::clear()
 {
+    // The shared editor outlives the elements it edits
+    m_editor->finish(false);
+    removeItem(m_editor);
+
+    m_elements.clear();
+    m_slotOf.clear();
+    m_dragChanges.clear();
+    m_selectionAnchor = nullptr;
+    endSnap();
+    m_edgeIndex.clear();
+    m_dirtyEdges.clear();
+    m_edgeIndexStale = false;
+    m_searchIndex.clear();
+    m_searchIndexStale = false;
+    releaseMapping();
     QGraphicsScene::clear();
+
+    addItem(m_editor);
+    fitSceneRect();
+    tuneIndexDepth();
+    emit sceneCleared();
+}
+
+void WebDesignScene::setIndexStrategy(IndexStrategy strategy)
+{
+    m_indexStrategy = strategy;
+    if (strategy == AutomaticBspDepth && itemIndexMethod() == BspTreeIndex)
+        setBspTreeDepth(0);
+    tuneIndexDepth();
+}
+
+void WebDesignScene::tuneIndexDepth()
+{
+    // Without a BSP tree the depth is ignored, restoreIndex() tunes the new one
+    if (m_indexStrategy == AutomaticBspDepth || itemIndexMethod() != BspTreeIndex) return;
+
+    // Deep enough for a handful of items per leaf, changing the depth rebuilds the tree
+    qsizetype leaves = qMax<qsizetype>(1, m_elements.size() / ItemsPerBspLeaf);
+    int depth = qBound(4, int(std::ceil(std::log2(double(leaves)))), 16);
+    if (depth != bspTreeDepth())
+        setBspTreeDepth(depth);
+}
+
+void WebDesignScene::restoreIndex()
+{
+    // Switching back builds a new tree at the automatic depth
+    setItemIndexMethod(BspTreeIndex);
+    tuneIndexDepth();
+}
+
+void WebDesignScene::notifyGeometryChanged(WebElementItem *item)
+{
+    // Growing is a cheap containment test, shrinking waits for the next full fit
+    QRectF bounds = item->sceneBoundingRect() | item->mapRectToScene(item->childrenBoundingRect());
+    if (!sceneRect().contains(bounds))
+        setSceneRect(sceneRect().united(bounds.adjusted(0, 0, SceneMargin, SceneMargin)));
+    invalidateEdges(item);
+    emit elementGeometryChanged(item);
+}
+
+void WebDesignScene::fitSceneRect()
+{
+    QRectF content = m_pendingBounds;
+    for (WebElementItem *item : std::as_const(m_elements)) {
+        if (item) content |= item->sceneBoundingRect();
+    }
+
+    QRectF rect(0, 0, MinimumSceneWidth, MinimumSceneHeight);
+    if (!content.isNull())
+        rect |= content.adjusted(0, 0, SceneMargin, SceneMargin);
+    setSceneRect(rect);
+}
+
+void WebDesignScene::removeElement(WebElementItem *item)
+{
+    qsizetype index = slotOf(item);
+    if (index < 0) return;
+
+    if (m_editor->target() == item)
+        m_editor->finish(false);
+
+    // Deleting an item deletes its children, they move up to its parent first
+    const QList<QGraphicsItem*> children = item->childItems();
+    for (QGraphicsItem *child : children)
+        setElementParent(static_cast<WebElementItem*>(child), item->parentElement());
+
+    m_elements.removeAt(index);
+    m_slotOf.remove(item);
+    m_edgeIndex.remove(quintptr(item));
+    m_dirtyEdges.remove(item);
+    if (!m_searchIndexStale)
+        m_searchIndex.remove(quintptr(item));
+    if (m_selectionAnchor == item)
+        m_selectionAnchor = nullptr;
+    for (qsizetype slot = index; slot < m_elements.size(); ++slot) {
+        if (WebElementItem *element = m_elements.at(slot))
+            m_slotOf[element] = slot;
+    }
+    m_dragChanges.clear();
+    if (m_mapping) {
+        m_recordOfSlot.removeAt(index);
+        rebuildRecordSlots();
+    }
+
+    emit elementRemoved(item, index);
+    removeItem(item);
+    delete item;
+    tuneIndexDepth();
+}
+
+WebElementItem* WebDesignScene::appendElement(const WebElementData &data)
+{
+    WebElementItem *item = new WebElementItem(data.type);
+    item->setElementData(data);
+    bindComponent(item, data);
+    // Parenting an item puts it into the parent's scene
+    if (data.parent >= 0 && data.parent < m_elements.size() && m_elements.at(data.parent))
+        item->setParentItem(m_elements.at(data.parent));
+    else
+        addItem(item);
+    m_slotOf.insert(item, m_elements.size());
+    m_elements.append(item);
+    if (m_mapping)
+        m_recordOfSlot.append(-1);
+    if (!m_searchIndexStale)
+        m_searchIndex.insert(quintptr(item), item->elementData());
+    tuneIndexDepth();
+    notifyGeometryChanged(item);
+    emit elementAdded(item);
+    return item;
+}
+
+void WebDesignScene::bindComponent(WebElementItem *item, const WebElementData &data)
+{
+    if (!data.isInstance() || !m_components) return;
+    // Parts that no longer exist leave a plain element with the values it was saved with
+    item->setComponent(data.component, data.part, data.overrides,
+                       m_components->fields(data.component, data.part));
+}
+
+void WebDesignScene::insertComponent(quint32 id, const QPointF &pos)
+{
+    const WebComponent *component = m_components ? m_components->find(id) : nullptr;
+    if (!component) return;
+
+    const QList<WebElementData> elements = m_components->instantiate(id, pos, qint32(elementCount()));
+    m_undoStack->beginMacro(tr("Insert %1").arg(component->name));
+    for (const WebElementData &element : elements)
+        m_undoStack->push(new WebCreateElementCommand(this, element));
+    m_undoStack->endMacro();
+}
+
+void WebDesignScene::followComponent(quint32 id)
+{
+    const WebProfileScope scope("scene/followComponent");
+    if (!m_components) return;
+
+    // Elements of records still pending pick the master up when they are materialized
+    for (WebElementItem *item : std::as_const(m_elements)) {
+        if (item && item->component() == id)
+            item->followComponent(m_components->fields(id, item->componentPart()));
+    }
+}
+
+QList<WebElementItem*> WebDesignScene::subtree(WebElementItem *root) const
+{
+    QList<WebElementItem*> items{root};
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        const QList<QGraphicsItem*> children = items.at(i)->childItems();
+        for (QGraphicsItem *child : children) {
+            if (WebElementItem *element = dynamic_cast<WebElementItem*>(child))
+                items.append(element);
+        }
+    }
+    return items;
+}
+
+void WebDesignScene::setElementProperty(WebElementItem *item, WebElementField field, const QString &value)
+{
+    QString current = WebPropertyCommand::value(item, field);
+    if (current == value) return;
+
+    qsizetype slot = slotOf(item);
+    if (slot < 0) return;
+    m_undoStack->push(new WebPropertyCommand(this, slot, field, current, value));
+}
+
+void WebDesignScene::setElementsProperty(const QList<WebElementItem*> &items, WebElementField field,
+                                         const QString &value)
+{
+    QList<WebPropertyChange> changes;
+    for (WebElementItem *item : items) {
+        QString current = WebPropertyCommand::value(item, field);
+        qsizetype slot = slotOf(item);
+        if (current != value && slot >= 0)
+            changes.append(WebPropertyChange{slot, current});
+    }
+    if (changes.isEmpty()) return;
+    m_undoStack->push(new WebPropertyCommand(this, changes, field, value));
+}
+
+QList<WebElementItem*> WebDesignScene::selectedElements() const
+{
+    QList<std::pair<qsizetype, WebElementItem*>> bySlot;
+    const QList<QGraphicsItem*> selected = selectedItems();
+    for (QGraphicsItem *item : selected) {
+        WebElementItem *element = dynamic_cast<WebElementItem*>(item);
+        qsizetype slot = element ? slotOf(element) : -1;
+        if (slot >= 0)
+            bySlot.append({slot, element});
+    }
+    std::sort(bySlot.begin(), bySlot.end());
+
+    QList<WebElementItem*> elements;
+    elements.reserve(bySlot.size());
+    for (const auto &entry : std::as_const(bySlot))
+        elements.append(entry.second);
+    return elements;
+}
+
+void WebDesignScene::selectElements(const QList<WebElementItem*> &items)
+{
+    {
+        const QSignalBlocker blocker(this);
+        clearSelection();
+        for (WebElementItem *item : items)
+            item->setSelected(true);
+    }
+    m_selectionAnchor = items.isEmpty() ? nullptr : items.constLast();
+    emit selectionChanged();
+}
+
+QList<WebElementItem*> WebDesignScene::findElements(const QString &query)
+{
+    const WebProfileScope scope("scene/findElements");
+    updateSearchIndex();
+
+    const QList<quintptr> keys = m_searchIndex.find(query);
+    QList<qsizetype> found;
+    found.reserve(keys.size());
+    for (quintptr key : keys) {
+        const qsizetype slot = slotOfKey(key);
+        if (slot >= 0)
+            found.append(slot);
+    }
+    std::sort(found.begin(), found.end());
+
+    QList<WebElementItem*> items;
+    items.reserve(found.size());
+    for (qsizetype slot : std::as_const(found))
+        items.append(materializeElement(slot));
+    return items;
+}
+
+WebElementItem *WebDesignScene::materializeElement(qsizetype slot)
+{
+    if (!m_elements.at(slot))
+        materializeSlot(slot);
+    return m_elements.at(slot);
+}
+
+void WebDesignScene::materializeAll()
+{
+    if (!m_mapping) return;
+
+    const WebProfileScope scope("scene/materializeAll");
+    ItemIndexMethod indexMethod = itemIndexMethod();
+    setItemIndexMethod(NoIndex);
+    // The last record releases the mapping
+    for (qsizetype slot = 0; m_mapping && slot < m_elements.size(); ++slot) {
+        if (!m_elements.at(slot))
+            materializeSlot(slot);
+    }
+    if (indexMethod == BspTreeIndex)
+        restoreIndex();
+    update();
+}
+
+QString WebDesignScene::mappedFileName() const
+{
+    return m_mapping ? m_mapping->fileName() : QString();
+}
+
+quintptr WebDesignScene::elementKey(qsizetype slot) const
+{
+    // Item addresses are aligned, so the low bit tells records apart
+    if (WebElementItem *item = m_elements.at(slot))
+        return quintptr(item);
+    return (quintptr(m_recordOfSlot.at(slot)) << 1) | 1;
+}
+
+qsizetype WebDesignScene::slotOfKey(quintptr key) const
+{
+    if (key & 1)
+        return m_slotOfRecord.value(qsizetype(key >> 1), -1);
+    return slotOf(reinterpret_cast<const WebElementItem*>(key));
+}
+
+void WebDesignScene::updateSearchIndex()
+{
+    if (!m_searchIndexStale) return;
+    const WebProfileScope scope("scene/updateSearchIndex");
+
+    QList<WebSearchIndex::Entry> entries;
+    entries.reserve(m_elements.size());
+    for (qsizetype slot = 0; slot < m_elements.size(); ++slot)
+        entries.append(WebSearchIndex::Entry{elementKey(slot), elementDataAt(slot)});
+    m_searchIndex.rebuild(entries);
+    m_searchIndexStale = false;
+}
+
+void WebDesignScene::arrangeSelection(WebArrange::Operation operation)
+{
+    const WebProfileScope scope("scene/arrange");
+
+    // A child moves along with its container, only the outermost selected elements are arranged
+    QList<WebElementItem*> elements;
+    const QList<WebElementItem*> selected = selectedElements();
+    for (WebElementItem *item : selected) {
+        bool nested = false;
+        for (QGraphicsItem *ancestor = item->parentItem(); ancestor && !nested; ancestor = ancestor->parentItem())
+            nested = ancestor->isSelected();
+        if (!nested)
+            elements.append(item);
+    }
+    if (elements.size() < WebArrange::minimumCount(operation)) return;
+
+    // Boxes as drawn, on the canvas; the results go back into each parent's coordinates
+    QList<QRectF> boxes;
+    boxes.reserve(elements.size());
+    for (const WebElementItem *item : std::as_const(elements))
+        boxes.append(QRectF(item->scenePos(), item->displayRect().size()));
+    const QList<QRectF> arranged = WebArrange::arrange(operation, boxes, qMax<qsizetype>(0, elements.indexOf(m_selectionAnchor)));
+
+    QList<WebGeometryChange> changes;
+    for (qsizetype i = 0; i < elements.size(); ++i) {
+        if (arranged.at(i) == boxes.at(i)) continue;
+
+        WebElementItem *item = elements.at(i);
+        const QPointF topLeft = arranged.at(i).topLeft();
+        QRectF to = item->geometry();
+        to.moveTopLeft(item->parentItem() ? item->parentItem()->mapFromScene(topLeft) : topLeft);
+        if (arranged.at(i).size() != boxes.at(i).size())
+            to.setSize(arranged.at(i).size());
+        changes.append(WebGeometryChange{slotOf(item), item->geometry(), to});
+    }
+    if (changes.isEmpty()) return;
+    m_undoStack->push(new WebGeometryCommand(this, changes, WebArrange::text(operation)));
+}
+
+void WebDesignScene::applyGeometry(const QList<WebGeometryChange> &changes, bool forward)
+{
+    const WebProfileScope scope("scene/applyGeometry");
+
+    // Every move re-files the item in the BSP tree; past a share of the scene
+    // dropping the index and building it again once is cheaper
+    const bool reindex = itemIndexMethod() == BspTreeIndex
+        && changes.size() * BatchReindexRatio > m_elements.size();
+    if (reindex)
+        setItemIndexMethod(NoIndex);
+
+    for (const WebGeometryChange &change : changes) {
+        if (WebElementItem *item = elementAt(change.slot))
+            item->setGeometry(forward ? change.to : change.from);
+    }
+
+    if (reindex)
+        restoreIndex();
+}
+
+void WebDesignScene::clearElements()
+{
+    if (m_elements.isEmpty()) return;
+    m_undoStack->push(new WebClearCommand(this));
+}
+
+void WebDesignScene::notifyElementChanged(WebElementItem *item)
+{
+    // Items report changes before they are added too, only indexed ones are updated
+    if (!m_searchIndexStale && m_searchIndex.contains(quintptr(item)))
+        m_searchIndex.insert(quintptr(item), item->elementData());
+    emit elementChanged(item);
+}
+
+void WebDesignScene::setElementParent(WebElementItem *item, WebElementItem *parent)
+{
+    if (item->parentItem() == parent) return;
+
+    // Children are positioned relative to the item, so they come along unchanged
+    const QPointF scenePos = item->scenePos();
+    item->setParentItem(parent);
+    item->setPos(parent ? parent->mapFromScene(scenePos) : scenePos);
+    emit elementParentChanged(item);
+}
+
+WebElementItem *WebDesignScene::containerAt(const QPointF &scenePos, const WebElementItem *moving) const
+{
+    // Topmost first, a child container is above the one that holds it
+    const QList<QGraphicsItem*> candidates = items(scenePos);
+    for (QGraphicsItem *candidate : candidates) {
+        WebElementItem *element = dynamic_cast<WebElementItem*>(candidate);
+        if (!element || !element->canContain()) continue;
+
+        // Elements dragged along with the moving one cannot take it in, nor can its own subtree
+        if (moving && (element->isSelected() || element == moving || moving->isAncestorOf(element)))
+            continue;
+        return element;
+    }
+    return nullptr;
+}
+
+void WebDesignScene::hideSelection()
+{
+    QList<qsizetype> hidden;
+    const QList<WebElementItem*> selected = selectedElements();
+    for (WebElementItem *element : selected) {
+        if (!element->isVisibleTo(element->parentItem())) continue;
+        // The text being typed is kept as its own step before the element goes
+        if (m_editor->target() && (m_editor->target() == element || element->isAncestorOf(m_editor->target())))
+            m_editor->finish(true);
+        hidden.append(slotOf(element));
+    }
+    if (hidden.isEmpty()) return;
+    m_undoStack->push(new WebVisibilityCommand(this, hidden, false));
+}
+
+void WebDesignScene::showAllElements()
+{
+    // Children of a hidden container are only hidden through it and need nothing
+    QList<qsizetype> shown;
+    for (qsizetype slot = 0; slot < m_elements.size(); ++slot) {
+        const WebElementItem *item = m_elements.at(slot);
+        if (item ? !item->isVisibleTo(item->parentItem()) : m_mapping->isHidden(m_recordOfSlot.at(slot)))
+            shown.append(slot);
+    }
+    if (shown.isEmpty()) return;
+    m_undoStack->push(new WebVisibilityCommand(this, shown, true));
+}
+
+void WebDesignScene::setElementVisible(WebElementItem *item, bool visible)
+{
+    if (!visible && m_editor->target() && (m_editor->target() == item || item->isAncestorOf(m_editor->target())))
+        m_editor->finish(false);
+    item->setVisible(visible);
+    invalidateEdges(item);
+    emit elementChanged(item);
 }
 
 QJsonObject WebDesignScene::toJson() const {
     QJsonObject project;
     QJsonArray elements;
-    // 填充 elements 数组...
+    for (qsizetype i = 0; i < m_elements.size(); ++i)
+        elements.append(elementDataAt(i).toJson());
     project["elements"] = elements;
     return project;
 }
 
-void WebDesignScene::fromJson(const QJsonArray &elements)
+QList<WebElementData> WebDesignScene::snapshot() const
+{
+    QList<WebElementData> elements;
+    elements.reserve(m_elements.size());
+    for (qsizetype i = 0; i < m_elements.size(); ++i)
+        elements.append(elementDataAt(i));
+    return elements;
+}
+
+WebElementData WebDesignScene::elementDataAt(qsizetype index) const
+{
+    WebElementItem *item = m_elements.at(index);
+    if (!item) {
+        // The record holds the values the instance showed when it was saved
+        WebElementData data = m_mapping->element(m_recordOfSlot.at(index));
+        if (m_components)
+            m_components->resolve(data);
+        return data;
+    }
+
+    WebElementData data = item->elementData();
+    data.parent = qint32(slotOf(item->parentElement()));
+    return data;
+}
+
+void WebDesignScene::loadElements(const QList<WebElementData> &elements)
+{
+    clear();
+    insertElements(elements);
+}
+
+void WebDesignScene::insertElements(const QList<WebElementData> &elements)
 {
+    const WebProfileScope scope("scene/insertElements");
+    // Index once at the end instead of updating the BSP tree per item
+    ItemIndexMethod indexMethod = itemIndexMethod();
+    setItemIndexMethod(NoIndex);
+
+    {
+        // Per-item added/changed/selected signals would only be replayed by listeners
+        const QSignalBlocker blocker(this);
+
+        const qsizetype first = m_elements.size();
+        m_elements.reserve(first + elements.size());
+        m_slotOf.reserve(first + elements.size());
+        if (m_mapping)
+            m_recordOfSlot.reserve(first + elements.size());
+
+        for (const WebElementData &element : elements) {
+            WebElementItem *item = new WebElementItem(element.type);
+            item->setElementData(element);
+            bindComponent(item, element);
+            m_slotOf.insert(item, m_elements.size());
+            m_elements.append(item);
+            if (m_mapping)
+                m_recordOfSlot.append(-1);
+        }
+
+        // Parents are set once every item exists, a container may come after its children.
+        // Adding a top level item brings its whole subtree into the scene.
+        const WebElementTree tree(elements);
+        for (qsizetype i = 0; i < elements.size(); ++i) {
+            WebElementItem *item = m_elements.at(first + i);
+            qsizetype parent = tree.parentOf(i);
+            if (parent >= 0)
+                item->setParentItem(m_elements.at(first + parent));
+        }
+        for (qsizetype i = 0; i < elements.size(); ++i) {
+            WebElementItem *item = m_elements.at(first + i);
+            if (!item->parentItem())
+                addItem(item);
+        }
+    }
+
+    if (indexMethod == BspTreeIndex)
+        restoreIndex();
+    fitSceneRect();
+    // Sorting everything once beats merging thousands of new elements in
+    m_edgeIndexStale = true;
+    m_searchIndexStale = true;
+    emit sceneLoaded();
+}
+
+void WebDesignScene::loadMapped(const QSharedPointer<WebDesignMapping> &mapping)
+{
+    const WebProfileScope scope("scene/loadMapped");
     clear();
-    for (const QJsonValue &element : elements) {
-        QJsonObject obj = element.toObject();
-        WebElementItem *item = createElement(obj["type"].toString(),
-                                           QPointF(obj["x"].toDouble(), obj["y"].toDouble()));
-        item->fromJson(obj);
+
+    // Nested records are placed relative to a container that has to exist first, they load in full
+    if (mapping->isNested()) {
+        QList<WebElementData> elements;
+        elements.reserve(mapping->elementCount());
+        for (qsizetype record = 0; record < mapping->elementCount(); ++record)
+            elements.append(mapping->element(record));
+        insertElements(elements);
+        return;
+    }
+
+    // Only the geometry index is built here, items are created as they scroll into view
+    qsizetype count = mapping->elementCount();
+    m_mapping = mapping;
+    m_elements.fill(nullptr, count);
+    m_recordOfSlot.resize(count);
+    m_pendingByTop.reserve(count);
+    for (qsizetype record = 0; record < count; ++record) {
+        QRectF geometry = mapping->geometry(record);
+        m_recordOfSlot[record] = qint32(record);
+        m_pendingByTop.append(PendingRecord{geometry.top(), quint32(record)});
+        m_pendingBounds |= geometry;
+        m_maxPendingHeight = qMax(m_maxPendingHeight, geometry.height());
+    }
+    std::sort(m_pendingByTop.begin(), m_pendingByTop.end(),
+              [](const PendingRecord &a, const PendingRecord &b) { return a.top < b.top; });
+    m_slotOfRecord = QList<qsizetype>(count);
+    rebuildRecordSlots();
+    m_pendingCount = count;
+    m_searchIndexStale = true;
+
+    fitSceneRect();
+    if (m_pendingCount == 0)
+        releaseMapping();
+    tuneIndexDepth();
+    update();
+    emit sceneLoaded();
+}
+
+void WebDesignScene::materialize(const QRectF &area)
+{
+    const WebProfileScope scope("scene/materialize");
+    m_materializeArea = area;
+    if (!m_mapping) return;
+
+    int budget = MaterializeBatch;
+    QList<qsizetype> batch;
+    forEachPendingIn(area, [&](qsizetype slot) {
+        if (budget-- > 0)
+            batch.append(slot);
+    });
+
+    for (qsizetype slot : std::as_const(batch))
+        materializeSlot(slot);
+
+    // Whatever is left keeps its placeholder until the next pass
+    if (budget < 0 && !m_materializeQueued) {
+        m_materializeQueued = true;
+        QTimer::singleShot(0, this, [this] {
+            m_materializeQueued = false;
+            materialize(m_materializeArea);
+        });
+    }
+}
+
+void WebDesignScene::materializeSlot(qsizetype slot)
+{
+    WebElementData data = m_mapping->element(m_recordOfSlot.at(slot));
+    WebElementItem *item = new WebElementItem(data.type);
+    item->setElementData(data);
+    bindComponent(item, data);
+    addItem(item);
+    const quintptr pendingKey = elementKey(slot);
+    m_elements[slot] = item;
+    m_slotOf.insert(item, slot);
+    invalidateEdges(item);
+    if (!m_searchIndexStale)
+        m_searchIndex.rekey(pendingKey, quintptr(item));
+
+    emit elementMaterialized(slot, item);
+
+    // Once every record is live the mapping is no longer needed
+    if (--m_pendingCount == 0)
+        releaseMapping();
+}
+
+void WebDesignScene::releaseMapping()
+{
+    m_mapping.reset();
+    m_recordOfSlot.clear();
+    m_slotOfRecord.clear();
+    m_pendingByTop.clear();
+    m_pendingBounds = QRectF();
+    m_maxPendingHeight = 0;
+    m_pendingCount = 0;
+}
+
+void WebDesignScene::rebuildRecordSlots()
+{
+    m_slotOfRecord.fill(-1);
+    for (qsizetype slot = 0; slot < m_recordOfSlot.size(); ++slot) {
+        if (m_recordOfSlot.at(slot) >= 0)
+            m_slotOfRecord[m_recordOfSlot.at(slot)] = slot;
+    }
+}
+
+template<typename Visitor>
+void WebDesignScene::forEachPendingIn(const QRectF &area, Visitor visit) const
+{
+    // Records are sorted by top edge, so only a band of the list can reach the area
+    auto it = std::lower_bound(m_pendingByTop.cbegin(), m_pendingByTop.cend(),
+                               area.top() - m_maxPendingHeight,
+                               [](const PendingRecord &record, qreal top) { return record.top < top; });
+
+    for (; it != m_pendingByTop.cend() && it->top <= area.bottom(); ++it) {
+        qsizetype slot = m_slotOfRecord.at(it->record);
+        if (slot < 0 || m_elements.at(slot)) continue;
+        if (m_mapping->geometry(it->record).intersects(area))
+            visit(slot);
+    }
+}
+
+void WebDesignScene::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    // A frame spans from the background to the foreground pass of one view repaint
+    m_frameStart = WebProfiler::isEnabled() ? WebProfiler::instance().nowNs() : -1;
+    QGraphicsScene::drawBackground(painter, rect);
+    if (!m_mapping) return;
+
+    painter->setPen(QPen(Qt::gray, 1, Qt::DotLine));
+    painter->setBrush(Qt::NoBrush);
+    forEachPendingIn(rect, [&](qsizetype slot) {
+        painter->drawRect(m_mapping->geometry(m_recordOfSlot.at(slot)));
+    });
+}
+
+void WebDesignScene::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsScene::drawForeground(painter, rect);
+
+    if (!m_guides.isEmpty()) {
+        painter->setPen(QPen(QColor(230, 0, 120), 0));
+        painter->drawLines(m_guides);
     }
+
+    if (m_frameStart >= 0) {
+        WebProfiler &profiler = WebProfiler::instance();
+        profiler.addSample("scene/frame", m_frameStart, profiler.nowNs() - m_frameStart);
+        m_frameStart = -1;
+    }
+}
+
+void WebDesignScene::updateEdgeIndex()
+{
+    if (!m_edgeIndexStale && m_dirtyEdges.isEmpty()) return;
+
+    const WebProfileScope scope("scene/updateEdgeIndex");
+    QList<WebEdgeIndex::Entry> entries;
+    auto add = [&](const WebElementItem *item) {
+        // Hidden elements leave the index, a null box removes them
+        entries.append(WebEdgeIndex::Entry{quintptr(item), item->isVisible() ? edgeRect(item) : QRectF()});
+    };
+
+    if (m_edgeIndexStale) {
+        entries.reserve(m_elements.size());
+        for (const WebElementItem *item : std::as_const(m_elements)) {
+            if (item) add(item);
+        }
+        m_edgeIndex.rebuild(entries);
+    } else {
+        // Children are positioned relative to their container, moving it moves the subtree
+        QSet<QGraphicsItem*> seen;
+        QList<QGraphicsItem*> pending(m_dirtyEdges.cbegin(), m_dirtyEdges.cend());
+        while (!pending.isEmpty()) {
+            QGraphicsItem *item = pending.takeLast();
+            if (seen.contains(item)) continue;
+            seen.insert(item);
+            add(static_cast<const WebElementItem*>(item));
+            pending.append(item->childItems());
+        }
+        m_edgeIndex.update(entries);
+    }
+    m_dirtyEdges.clear();
+    m_edgeIndexStale = false;
+}
+
+void WebDesignScene::beginSnap()
+{
+    updateEdgeIndex();
+
+    m_snapOrigins.clear();
+    m_snapExcluded.clear();
+    m_snapBounds = QRectF();
+    const QList<QGraphicsItem*> selected = selectedItems();
+    for (QGraphicsItem *item : selected) {
+        if (WebElementItem *element = dynamic_cast<WebElementItem*>(item)) {
+            m_snapOrigins.insert(element, element->pos());
+            m_snapBounds |= edgeRect(element);
+        }
+    }
+
+    // Nothing that moves along can be snapped to, not even by a child
+    QList<QGraphicsItem*> moving = selected;
+    while (!moving.isEmpty()) {
+        QGraphicsItem *item = moving.takeLast();
+        m_snapExcluded.insert(quintptr(item));
+        moving.append(item->childItems());
+    }
+
+    // NaN equals no delta, the first move always looks for edges
+    m_snapDelta = QPointF(std::numeric_limits<qreal>::quiet_NaN(), 0);
+    m_snapOffset = QPointF();
+    m_snapping = !m_snapOrigins.isEmpty();
+}
+
+void WebDesignScene::endSnap()
+{
+    m_snapping = false;
+    m_snapOrigins.clear();
+    m_snapExcluded.clear();
+    setGuides({});
+}
+
+QPointF WebDesignScene::snapPosition(WebElementItem *item, const QPointF &pos)
+{
+    if (!m_snapping) return pos;
+    auto origin = m_snapOrigins.constFind(item);
+    if (origin == m_snapOrigins.cend()) return pos;
+
+    // Every selected element moves by the same delta, so the selection snaps
+    // as one box and the offset is looked up once per mouse move
+    const QPointF delta = pos - origin.value();
+    if (delta != m_snapDelta) {
+        m_snapDelta = delta;
+        m_snapOffset = snapOffset(m_snapBounds.translated(delta));
+    }
+    return pos + m_snapOffset;
+}
+
+QPointF WebDesignScene::snapOffset(const QRectF &moving)
+{
+    const WebProfileScope scope("scene/snap");
+    const qreal scale = views().isEmpty() ? 1.0 : views().constFirst()->transform().m11();
+    const qreal tolerance = SnapDistance / qMax(scale, 0.01);
+    auto excluded = [this](quintptr key) { return m_snapExcluded.contains(key); };
+
+    // Per axis the closest pair of a moving edge and an indexed one wins
+    WebEdgeIndex::Match matches[2];
+    QPointF offset;
+    for (WebEdgeIndex::Axis axis : {WebEdgeIndex::Horizontal, WebEdgeIndex::Vertical}) {
+        qreal edges[3];
+        WebEdgeIndex::edgesOf(moving, axis, edges);
+        for (qreal edge : edges) {
+            const WebEdgeIndex::Match match = m_edgeIndex.nearest(axis, edge, tolerance, excluded);
+            if (match.distance < matches[axis].distance) {
+                matches[axis] = match;
+                if (axis == WebEdgeIndex::Horizontal)
+                    offset.setX(match.position - edge);
+                else
+                    offset.setY(match.position - edge);
+            }
+        }
+    }
+
+    // A guide runs along the snapped line, across both boxes
+    const QRectF snapped = moving.translated(offset);
+    QList<QLineF> guides;
+    if (matches[WebEdgeIndex::Horizontal].isValid()) {
+        const WebEdgeIndex::Match &match = matches[WebEdgeIndex::Horizontal];
+        const QRectF target = m_edgeIndex.rect(match.key);
+        guides.append(QLineF(match.position, qMin(snapped.top(), target.top()),
+                             match.position, qMax(snapped.bottom(), target.bottom())));
+    }
+    if (matches[WebEdgeIndex::Vertical].isValid()) {
+        const WebEdgeIndex::Match &match = matches[WebEdgeIndex::Vertical];
+        const QRectF target = m_edgeIndex.rect(match.key);
+        guides.append(QLineF(qMin(snapped.left(), target.left()), match.position,
+                             qMax(snapped.right(), target.right()), match.position));
+    }
+    setGuides(guides);
+    return offset;
+}
+
+void WebDesignScene::setGuides(const QList<QLineF> &guides)
+{
+    if (guides == m_guides) return;
+
+    // Only the strips under the old and the new guides are repainted
+    auto repaint = [this](const QList<QLineF> &lines) {
+        for (const QLineF &line : lines)
+            update(QRectF(line.p1(), line.p2()).normalized().adjusted(-2, -2, 2, 2));
+    };
+    repaint(m_guides);
+    m_guides = guides;
+    repaint(m_guides);
+}
+
+void WebDesignScene::fromJson(const QJsonArray &elements)
+{
+    const WebProfileScope scope("scene/fromJson");
+    QList<WebElementData> data;
+    data.reserve(elements.size());
+    for (const QJsonValue &element : elements)
+        data.append(WebElementData::fromJson(element.toObject()));
+    loadElements(data);
 }
 
 void WebDesignScene::dragEnterEvent(QGraphicsSceneDragDropEvent *event)
@@ -67,19 +925,120 @@ void WebDesignScene::dropEvent(QGraphicsSceneDragDropEvent *event)
 
 void WebDesignScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
+    const WebProfileScope scope("scene/mousePress");
     QGraphicsScene::mousePressEvent(event);
 
     if (event->button() == Qt::LeftButton) {
         QGraphicsItem *item = itemAt(event->scenePos(), QTransform());
+        if (item == m_editor) return;
+
+        if (WebElementItem *element = dynamic_cast<WebElementItem*>(item))
+            m_selectionAnchor = element;
+
+        if (WebElementItem *grabber = dynamic_cast<WebElementItem*>(mouseGrabberItem())) {
+            // Remember where the selection started so the drag is recorded as one command
+            m_dragChanges.clear();
+            const QList<QGraphicsItem*> selected = selectedItems();
+            for (QGraphicsItem *selectedItem : selected) {
+                WebElementItem *element = dynamic_cast<WebElementItem*>(selectedItem);
+                qsizetype slot = element ? slotOf(element) : -1;
+                if (slot >= 0)
+                    m_dragChanges.append(WebGeometryChange{slot, element->geometry(), QRectF()});
+            }
+
+            // A resize keeps the dragged corner under the mouse, only moves snap
+            if (m_snapEnabled && !grabber->isResizing())
+                beginSnap();
+        }
         emit elementSelected(item);
     }
 }
 
+void WebDesignScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    // Moving an indexed item re-files it in the BSP tree on every step.
+    // The index is dropped once the drag moves, a plain click keeps it.
+    if (m_indexStrategy == UnindexedDrag && !m_dragUnindexed && !m_dragChanges.isEmpty()
+        && (event->buttons() & Qt::LeftButton) && itemIndexMethod() == BspTreeIndex
+        && event->scenePos() != event->buttonDownScenePos(Qt::LeftButton)) {
+        m_dragUnindexed = true;
+        setItemIndexMethod(NoIndex);
+    }
+    QGraphicsScene::mouseMoveEvent(event);
+}
+
+void WebDesignScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    QGraphicsScene::mouseReleaseEvent(event);
+    endSnap();
+
+    if (m_dragUnindexed) {
+        m_dragUnindexed = false;
+        restoreIndex();
+    }
+
+    // Only elements that actually moved or were resized end up in the command
+    QList<WebGeometryChange> changes;
+    for (WebGeometryChange &change : m_dragChanges) {
+        WebElementItem *element = change.slot < m_elements.size() ? m_elements.at(change.slot) : nullptr;
+        if (!element) continue;
+        change.to = element->geometry();
+        if (change.to != change.from)
+            changes.append(change);
+    }
+    m_dragChanges.clear();
+    if (changes.isEmpty()) return;
+
+    // Dropped onto a container an element becomes its child, dragged out of one it moves up.
+    // Resizing never changes the parent.
+    QList<WebParentChange> parentChanges;
+    for (const WebGeometryChange &change : std::as_const(changes)) {
+        if (change.from.size() != change.to.size()) continue;
+
+        WebElementItem *element = m_elements.at(change.slot);
+        WebElementItem *container = containerAt(element->sceneBoundingRect().center(), element);
+        if (container != element->parentElement())
+            parentChanges.append(WebParentChange{change.slot, slotOf(element->parentElement()), slotOf(container)});
+    }
+
+    if (parentChanges.isEmpty()) {
+        m_undoStack->push(new WebGeometryCommand(this, changes));
+        return;
+    }
+    m_undoStack->beginMacro(tr("Move"));
+    m_undoStack->push(new WebGeometryCommand(this, changes));
+    m_undoStack->push(new WebParentCommand(this, parentChanges));
+    m_undoStack->endMacro();
+}
+
+void WebDesignScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
+{
+    QGraphicsItem *item = itemAt(event->scenePos(), QTransform());
+    if (WebElementItem *element = dynamic_cast<WebElementItem*>(item)) {
+        m_editor->attach(element);
+        event->accept();
+        return;
+    }
+    QGraphicsScene::mouseDoubleClickEvent(event);
+}
+
 WebElementItem* WebDesignScene::createElement(const QString &type, const QPointF &pos)
 {
-    WebElementItem *item = new WebElementItem(type);
-    item->setPos(pos);
-    addItem(item);
+    // The new element starts from the type's defaults, the command appends it.
+    // Dropped onto a container it is created inside.
+    const QSizeF size = WebElementTypeInfo::of(WebElementTypeInfo::kindOf(type)).defaultSize;
+    WebElementItem *container = containerAt(pos);
+    const QPointF local = container ? container->mapFromScene(pos) : pos;
+    WebElementData data;
+    data.type = type;
+    data.text = type;
+    data.parent = qint32(slotOf(container));
+    data.x = local.x();
+    data.y = local.y();
+    data.width = size.width();
+    data.height = size.height();
+    m_undoStack->push(new WebCreateElementCommand(this, data));
+    WebElementItem *item = m_elements.last();
 
     // Select the new item
     clearSelection();
@@ -1,33 +1,234 @@
 #ifndef WEBDESIGNSCENE_H
 #define WEBDESIGNSCENE_H
 
+#include "WebArrange.h"
+#include "WebDesignCommands.h"
+#include "WebEdgeIndex.h"
+#include "WebSearchIndex.h"
 #include <QGraphicsScene>
+#include <QHash>
 #include <QJsonArray>
+#include <QLineF>
+#include <QSet>
+#include <QSharedPointer>
 
 class WebElementItem;
+class WebComponentLibrary;
+class WebDesignMapping;
+class WebInlineEditor;
+struct WebElementData;
 
 class WebDesignScene : public QGraphicsScene
 {
     Q_OBJECT
 
 public:
+    // How the scene keeps its BSP index while elements are added and dragged
+    enum IndexStrategy {
+        AutomaticBspDepth,
+        TunedBspDepth,
+        UnindexedDrag
+    };
+
     explicit WebDesignScene(QObject *parent = nullptr);
 
+    IndexStrategy indexStrategy() const { return m_indexStrategy; }
+    void setIndexStrategy(IndexStrategy strategy);
+
     void clear();
     QJsonObject toJson() const;
     void fromJson(const QJsonArray &elements);
 
+    QList<WebElementData> snapshot() const;
+    void loadElements(const QList<WebElementData> &elements);
+    void insertElements(const QList<WebElementData> &elements);
+    void loadMapped(const QSharedPointer<WebDesignMapping> &mapping);
+
+    // Slots of a mapped design stay null until they are materialized
+    qsizetype elementCount() const { return m_elements.size(); }
+    WebElementItem *elementAt(qsizetype index) const { return m_elements.at(index); }
+    WebElementData elementDataAt(qsizetype index) const;
+    qsizetype pendingElementCount() const { return m_pendingCount; }
+    qsizetype slotOf(const WebElementItem *item) const { return m_slotOf.value(item, -1); }
+    // Identity of a slot that survives other slots moving: the item's address,
+    // or a key for the record while it is pending. It changes once, when the
+    // record is materialized.
+    quintptr elementKey(qsizetype slot) const;
+    qsizetype slotOfKey(quintptr key) const;
+    // The item of a slot, created first if its record is pending
+    WebElementItem *materializeElement(qsizetype slot);
+    // Every pending record, which releases the mapping and with it the file
+    void materializeAll();
+    // The file of a mapped design while records are pending, empty otherwise
+    QString mappedFileName() const;
+
+    WebElementItem *appendElement(const WebElementData &data);
+    void removeElement(WebElementItem *item);
+    void notifyElementChanged(WebElementItem *item);
+    void notifyGeometryChanged(WebElementItem *item);
+
+    // Components of the project the page belongs to; instances are bound to
+    // their part when they are created, so set it before loading
+    void setComponentLibrary(const WebComponentLibrary *library) { m_components = library; }
+    // Adds an instance of a component at a scene position as one step
+    void insertComponent(quint32 id, const QPointF &pos);
+    // Every instance of the component takes its new master copy, in one pass
+    void followComponent(quint32 id);
+    // An element and its descendants, every element after its parent
+    QList<WebElementItem*> subtree(WebElementItem *root) const;
+
+    // Moves an element with its subtree into parent, or to the top level for
+    // nullptr, keeping it where it is on the canvas
+    void setElementParent(WebElementItem *item, WebElementItem *parent);
+    // Innermost container under a scene position that could take moving as a child
+    WebElementItem *containerAt(const QPointF &scenePos, const WebElementItem *moving = nullptr) const;
+
+    // Dragged elements snap to the edges and centers of the others and show
+    // a guide along the line they snapped to
+    bool snapEnabled() const { return m_snapEnabled; }
+    void setSnapEnabled(bool enabled) { m_snapEnabled = enabled; }
+    // Called by an element about to move, returns the position it should take
+    QPointF snapPosition(WebElementItem *item, const QPointF &pos);
+    // The element's box changed, its edges are indexed again before the next drag
+    void invalidateEdges(WebElementItem *item) { m_dirtyEdges.insert(item); }
+
+    // Hiding an element hides its subtree on the canvas, the HTML keeps it.
+    // Both are undoable steps and the state is saved with the design.
+    void hideSelection();
+    void showAllElements();
+    // Used by WebVisibilityCommand
+    void setElementVisible(WebElementItem *item, bool visible);
+
+    // Selected elements in document order
+    QList<WebElementItem*> selectedElements() const;
+    // Replaces the selection, with one selectionChanged however many elements there are
+    void selectElements(const QList<WebElementItem*> &items);
+
+    // Elements matching a query (see WebSearchIndex), in document order.
+    // Matching records of a mapped design are materialized.
+    QList<WebElementItem*> findElements(const QString &query);
+
+    // Edits made through these are recorded in the undo history
+    WebUndoStack *undoStack() const { return m_undoStack; }
+    void setElementProperty(WebElementItem *item, WebElementField field, const QString &value);
+    // One step for all elements, whatever number of them is selected
+    void setElementsProperty(const QList<WebElementItem*> &items, WebElementField field, const QString &value);
+    // Aligns, distributes or resizes the selection on the canvas as one step.
+    // Sizes are matched to the element clicked last.
+    void arrangeSelection(WebArrange::Operation operation);
+    void clearElements();
+
+    // Used by WebGeometryCommand, applies a batch with at most one rebuild of the BSP index
+    void applyGeometry(const QList<WebGeometryChange> &changes, bool forward);
+
+public slots:
+    void materialize(const QRectF &area);
+
     signals:
         void elementSelected(QGraphicsItem *item);
+        void elementAdded(WebElementItem *item);
+        void elementRemoved(WebElementItem *item, qsizetype index);
+        void elementChanged(WebElementItem *item);
+        void elementGeometryChanged(WebElementItem *item);
+        void elementParentChanged(WebElementItem *item);
+        void elementTextEdited(WebElementItem *item);
+        void elementMaterialized(qsizetype index, WebElementItem *item);
+        void sceneCleared();
+        void sceneLoaded();
 
 protected:
     void dragEnterEvent(QGraphicsSceneDragDropEvent *event) override;
     void dragMoveEvent(QGraphicsSceneDragDropEvent *event) override;
     void dropEvent(QGraphicsSceneDragDropEvent *event) override;
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
 
 private:
+    struct PendingRecord
+    {
+        qreal top;
+        quint32 record;
+    };
+
+    // Upper bound on items created per event loop pass while scrolling into a mapped design
+    static constexpr int MaterializeBatch = 1000;
+    // Empty canvas size and the room kept beyond the content for dropping new elements
+    static constexpr qreal MinimumSceneWidth = 1200;
+    static constexpr qreal MinimumSceneHeight = 800;
+    static constexpr qreal SceneMargin = 400;
+    // Target number of items per BSP leaf when the depth is tuned
+    static constexpr int ItemsPerBspLeaf = 16;
+    // How close, in view pixels, an edge has to come to snap
+    static constexpr qreal SnapDistance = 6;
+    // Batches moving more than one element in this many re-index the scene once
+    static constexpr int BatchReindexRatio = 16;
+
     WebElementItem* createElement(const QString &type, const QPointF &pos);
+    void bindComponent(WebElementItem *item, const WebElementData &data);
+    void materializeSlot(qsizetype slot);
+    void releaseMapping();
+    void rebuildRecordSlots();
+    void fitSceneRect();
+    void tuneIndexDepth();
+    void restoreIndex();
+    void updateEdgeIndex();
+    void updateSearchIndex();
+    void beginSnap();
+    void endSnap();
+    QPointF snapOffset(const QRectF &moving);
+    void setGuides(const QList<QLineF> &guides);
+
+    template<typename Visitor>
+    void forEachPendingIn(const QRectF &area, Visitor visit) const;
+
+    // Elements in document order, used for HTML generation
+    QList<WebElementItem*> m_elements;
+    QHash<const WebElementItem*, qsizetype> m_slotOf;
+    WebInlineEditor *m_editor;
+    WebUndoStack *m_undoStack;
+    const WebComponentLibrary *m_components;
+    // Geometry of the dragged elements when the mouse went down
+    QList<WebGeometryChange> m_dragChanges;
+    // Element clicked last, sizes are matched to it
+    WebElementItem *m_selectionAnchor;
+    IndexStrategy m_indexStrategy;
+    bool m_dragUnindexed;
+
+    // Scene boxes of the visible elements, brought up to date when a drag starts
+    WebEdgeIndex m_edgeIndex;
+    QSet<WebElementItem*> m_dirtyEdges;
+    bool m_edgeIndexStale;
+    // Words of every element, pending records included. Kept up to date
+    // element by element; a bulk load only marks it stale and the next query
+    // rebuilds it.
+    WebSearchIndex m_searchIndex;
+    bool m_searchIndexStale;
+    // Drag state while snapping: where the dragged elements started, their
+    // bounds and every key they and their subtrees hold in the index
+    bool m_snapEnabled;
+    bool m_snapping;
+    QHash<const WebElementItem*, QPointF> m_snapOrigins;
+    QSet<quintptr> m_snapExcluded;
+    QRectF m_snapBounds;
+    QPointF m_snapDelta;
+    QPointF m_snapOffset;
+    QList<QLineF> m_guides;
+
+    // Lazy loading state, only set while records of a mapped design are pending
+    QSharedPointer<WebDesignMapping> m_mapping;
+    QList<qint32> m_recordOfSlot;
+    QList<qsizetype> m_slotOfRecord;
+    QList<PendingRecord> m_pendingByTop;
+    QRectF m_pendingBounds;
+    qreal m_maxPendingHeight;
+    qsizetype m_pendingCount;
+    QRectF m_materializeArea;
+    bool m_materializeQueued;
+    qint64 m_frameStart;
 };
 
 #endif // WEBDESIGNSCENE_H
\ No newline at end of file
@@ -0,0 +1,488 @@
+#include "WebDesignSerializer.h"
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace {
+constexpr char kMagic[4] = {'W', 'D', 'S', 'B'};
+constexpr qsizetype kHeaderSize = 20;
+constexpr qsizetype kParentOffset = 4 * sizeof(double) + 5 * sizeof(quint32);
+constexpr qsizetype kComponentOffset = kParentOffset + sizeof(qint32);
+constexpr qsizetype kRecordSize = kComponentOffset + sizeof(quint32) + sizeof(qint32) + sizeof(quint32);
+constexpr qsizetype kAttributeSize = 3 * sizeof(quint32);
+// The last word of a record holds the overrides in its low byte and flags above.
+// Readers that only know the overrides drop the flags.
+constexpr qsizetype kFlagsOffset = kComponentOffset + sizeof(quint32) + sizeof(qint32);
+constexpr quint32 kHiddenFlag = 1u << 8;
+
+qsizetype recordSize(quint16 version)
+{
+    // Version 1 had no parent index, version 2 no component reference
+    if (version < 2) return kParentOffset;
+    if (version < 3) return kComponentOffset;
+    return kRecordSize;
+}
+
+template<typename T>
+void put(char *&out, T value)
+{
+    qToLittleEndian(value, out);
+    out += sizeof(T);
+}
+
+void putDouble(char *&out, double value)
+{
+    put(out, std::bit_cast<quint64>(value));
+}
+
+template<typename T>
+T get(const char *&in)
+{
+    T value = qFromLittleEndian<T>(in);
+    in += sizeof(T);
+    return value;
+}
+
+double getDouble(const char *&in)
+{
+    return std::bit_cast<double>(get<quint64>(in));
+}
+
+bool fail(QString *errorString, const QString &message)
+{
+    if (errorString) *errorString = message;
+    return false;
+}
+}
+
+void WebDesignDocument::removeElement(qsizetype index)
+{
+    const WebElementData removed = elements.at(index);
+    elements.removeAt(index);
+    for (WebElementData &element : elements) {
+        if (element.parent == index) {
+            element.parent = removed.parent;
+            element.x += removed.x;
+            element.y += removed.y;
+        }
+        // Indices behind the removed element shift down with the elements
+        if (element.parent > index)
+            --element.parent;
+    }
+}
+
+bool WebDesignSerializer::read(const QString &fileName, WebDesignDocument *document,
+                               Format *format, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(errorString, file.errorString());
+
+    QByteArray data = file.readAll();
+    const Format detected = detectFormat(data);
+    const bool parsed = detected == BinaryFormat
+        ? fromBinary(data, document, errorString)
+        : fromJson(data, document, errorString);
+    // A failed load leaves the caller's format alone
+    if (parsed && format) *format = detected;
+    return parsed;
+}
+
+bool WebDesignSerializer::write(const QString &fileName, const WebDesignDocument &document,
+                                Format format, QString *errorString)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return fail(errorString, file.errorString());
+
+    QByteArray data = format == BinaryFormat ? toBinary(document) : toJson(document);
+    if (file.write(data) != data.size() || !file.commit())
+        return fail(errorString, file.errorString());
+    return true;
+}
+
+WebDesignSerializer::Format WebDesignSerializer::detectFormat(const QByteArray &data)
+{
+    return data.startsWith(QByteArrayView(kMagic, sizeof(kMagic))) ? BinaryFormat : JsonFormat;
+}
+
+WebDesignSerializer::Format WebDesignSerializer::detectFileFormat(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return JsonFormat;
+    return detectFormat(file.read(sizeof(kMagic)));
+}
+
+QByteArray WebDesignSerializer::toJson(const WebDesignDocument &document)
+{
+    QJsonArray elements;
+    for (const WebElementData &element : document.elements)
+        elements.append(element.toJson());
+
+    QJsonObject project;
+    project["elements"] = elements;
+    project["properties"] = document.properties;
+    return QJsonDocument(project).toJson();
+}
+
+bool WebDesignSerializer::fromJson(const QByteArray &data, WebDesignDocument *document, QString *errorString)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (doc.isNull())
+        return fail(errorString, parseError.errorString());
+
+    QJsonObject project = doc.object();
+    const QJsonArray elements = project["elements"].toArray();
+
+    document->elements.clear();
+    document->elements.reserve(elements.size());
+    for (const QJsonValue &element : elements)
+        document->elements.append(WebElementData::fromJson(element.toObject()));
+    document->properties = project["properties"].toObject();
+    return true;
+}
+
+QByteArray WebDesignSerializer::toBinary(const WebDesignDocument &document)
+{
+    // Intern every string so repeated types and classes are stored once
+    QHash<QString, quint32> indices;
+    QList<QString> strings;
+    QList<std::array<quint32, 5>> references;
+    qsizetype stringBytes = 0;
+
+    auto intern = [&](const QString &value) {
+        auto it = indices.constFind(value);
+        if (it != indices.constEnd()) return it.value();
+
+        quint32 index = quint32(strings.size());
+        indices.insert(value, index);
+        strings.append(value);
+        stringBytes += sizeof(quint32) + value.size() * sizeof(char16_t);
+        return index;
+    };
+
+    QList<std::array<quint32, 3>> attributes;
+    references.reserve(document.elements.size());
+    for (qsizetype i = 0; i < document.elements.size(); ++i) {
+        const WebElementData &element = document.elements.at(i);
+        references.append(std::array<quint32, 5>{intern(element.type), intern(element.id), intern(element.cls),
+                                                 intern(element.text), intern(element.style)});
+        for (const WebAttribute &attribute : element.attributes)
+            attributes.append(std::array<quint32, 3>{quint32(i), quint32(attribute.field), intern(attribute.value)});
+    }
+
+    QByteArray properties = QJsonDocument(document.properties).toJson(QJsonDocument::Compact);
+
+    QByteArray data(kHeaderSize + stringBytes + document.elements.size() * kRecordSize
+                    + sizeof(quint32) + attributes.size() * kAttributeSize + properties.size(),
+                    Qt::Uninitialized);
+    char *out = data.data();
+
+    std::copy(std::begin(kMagic), std::end(kMagic), out);
+    out += sizeof(kMagic);
+    put<quint16>(out, BinaryVersion);
+    put<quint16>(out, 0);
+    put<quint32>(out, quint32(strings.size()));
+    put<quint32>(out, quint32(document.elements.size()));
+    put<quint32>(out, quint32(properties.size()));
+
+    for (const QString &value : std::as_const(strings)) {
+        put<quint32>(out, quint32(value.size()));
+        qToLittleEndian<quint16>(value.utf16(), value.size(), out);
+        out += value.size() * sizeof(char16_t);
+    }
+
+    for (qsizetype i = 0; i < document.elements.size(); ++i) {
+        const WebElementData &element = document.elements.at(i);
+        putDouble(out, element.x);
+        putDouble(out, element.y);
+        putDouble(out, element.width);
+        putDouble(out, element.height);
+        for (quint32 index : references.at(i))
+            put<quint32>(out, index);
+        put<qint32>(out, element.parent);
+        put<quint32>(out, element.component);
+        put<qint32>(out, element.part);
+        put<quint32>(out, element.overrides | (element.hidden ? kHiddenFlag : 0));
+    }
+
+    put<quint32>(out, quint32(attributes.size()));
+    for (const auto &attribute : std::as_const(attributes)) {
+        for (quint32 value : attribute)
+            put<quint32>(out, value);
+    }
+
+    std::copy(properties.cbegin(), properties.cend(), out);
+    return data;
+}
+
+bool WebDesignSerializer::fromBinary(const QByteArray &data, WebDesignDocument *document, QString *errorString)
+{
+    const char *in = data.constData();
+    const char *end = in + data.size();
+
+    if (data.size() < kHeaderSize || detectFormat(data) != BinaryFormat)
+        return fail(errorString, QObject::tr("Not a binary design file"));
+    in += sizeof(kMagic);
+
+    quint16 version = get<quint16>(in);
+    if (version > BinaryVersion)
+        return fail(errorString, QObject::tr("Unsupported design file version %1").arg(version));
+    get<quint16>(in);
+
+    quint32 stringCount = get<quint32>(in);
+    quint32 elementCount = get<quint32>(in);
+    quint32 propertiesSize = get<quint32>(in);
+
+    const QString truncated = QObject::tr("Design file is truncated");
+    if (stringCount > quint64(end - in) / sizeof(quint32))
+        return fail(errorString, truncated);
+
+    QList<QString> strings;
+    strings.reserve(stringCount);
+    for (quint32 i = 0; i < stringCount; ++i) {
+        if (end - in < qsizetype(sizeof(quint32)))
+            return fail(errorString, truncated);
+
+        quint32 length = get<quint32>(in);
+        if (length > quint64(end - in) / sizeof(char16_t))
+            return fail(errorString, truncated);
+
+        QString value(length, Qt::Uninitialized);
+        qFromLittleEndian<quint16>(in, length, value.data());
+        in += length * sizeof(char16_t);
+        strings.append(value);
+    }
+
+    const qsizetype elementSize = recordSize(version);
+    if (elementCount > quint64(end - in) / elementSize)
+        return fail(errorString, truncated);
+
+    document->elements.clear();
+    document->elements.reserve(elementCount);
+    for (quint32 i = 0; i < elementCount; ++i) {
+        WebElementData element;
+        element.x = getDouble(in);
+        element.y = getDouble(in);
+        element.width = getDouble(in);
+        element.height = getDouble(in);
+
+        std::array<quint32, 5> references;
+        for (quint32 &index : references) {
+            index = get<quint32>(in);
+            if (index >= stringCount)
+                return fail(errorString, QObject::tr("Design file is corrupted"));
+        }
+
+        // Copies share the table's string data, so repeated values cost no extra memory
+        element.type = strings.at(references[0]);
+        element.id = strings.at(references[1]);
+        element.cls = strings.at(references[2]);
+        element.text = strings.at(references[3]);
+        element.style = strings.at(references[4]);
+        if (version >= 2)
+            element.parent = get<qint32>(in);
+        if (version >= 3) {
+            element.component = get<quint32>(in);
+            element.part = get<qint32>(in);
+            const quint32 flags = get<quint32>(in);
+            element.overrides = quint8(flags);
+            element.hidden = flags & kHiddenFlag;
+        }
+        document->elements.append(element);
+    }
+
+    if (version >= 4) {
+        if (end - in < qsizetype(sizeof(quint32)))
+            return fail(errorString, truncated);
+        quint32 attributeCount = get<quint32>(in);
+        if (attributeCount > quint64(end - in) / kAttributeSize)
+            return fail(errorString, truncated);
+        for (quint32 i = 0; i < attributeCount; ++i) {
+            quint32 record = get<quint32>(in);
+            quint32 field = get<quint32>(in);
+            quint32 index = get<quint32>(in);
+            if (record >= elementCount || index >= stringCount)
+                return fail(errorString, QObject::tr("Design file is corrupted"));
+            // Fields written by a newer version are skipped
+            if (field > quint32(WebElementField::Style) && field < WebElementFieldCount)
+                document->elements[record].setValue(WebElementField(field), strings.at(index));
+        }
+    }
+
+    if (propertiesSize > quint64(end - in))
+        return fail(errorString, truncated);
+
+    QByteArray properties = QByteArray::fromRawData(in, propertiesSize);
+    document->properties = QJsonDocument::fromJson(properties).object();
+    return true;
+}
+
+bool WebDesignMapping::open(const QString &fileName, QString *errorString)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(errorString, m_file.errorString());
+
+    qint64 size = m_file.size();
+    if (size < kHeaderSize)
+        return fail(errorString, QObject::tr("Not a binary design file"));
+
+    uchar *map = m_file.map(0, size);
+    if (!map)
+        return fail(errorString, m_file.errorString());
+
+    const char *in = reinterpret_cast<const char*>(map);
+    const char *end = in + size;
+    if (!std::equal(std::begin(kMagic), std::end(kMagic), in))
+        return fail(errorString, QObject::tr("Not a binary design file"));
+    in += sizeof(kMagic);
+
+    quint16 version = get<quint16>(in);
+    if (version > WebDesignSerializer::BinaryVersion)
+        return fail(errorString, QObject::tr("Unsupported design file version %1").arg(version));
+    get<quint16>(in);
+
+    quint32 stringCount = get<quint32>(in);
+    quint32 elementCount = get<quint32>(in);
+    quint32 propertiesSize = get<quint32>(in);
+
+    const QString truncated = QObject::tr("Design file is truncated");
+    if (stringCount > quint64(end - in) / sizeof(quint32))
+        return fail(errorString, truncated);
+
+    // Only remember where each string starts, decoding happens on first use
+    m_stringData.reserve(stringCount);
+    for (quint32 i = 0; i < stringCount; ++i) {
+        if (end - in < qsizetype(sizeof(quint32)))
+            return fail(errorString, truncated);
+
+        m_stringData.append(reinterpret_cast<const uchar*>(in));
+        quint32 length = get<quint32>(in);
+        if (length > quint64(end - in) / sizeof(char16_t))
+            return fail(errorString, truncated);
+        in += length * sizeof(char16_t);
+    }
+    m_strings.resize(stringCount);
+    m_decoded.assign(stringCount, false);
+
+    m_recordSize = recordSize(version);
+    if (elementCount > quint64(end - in) / m_recordSize)
+        return fail(errorString, truncated);
+    m_records = reinterpret_cast<const uchar*>(in);
+    m_elementCount = elementCount;
+    in += elementCount * m_recordSize;
+
+    if (version >= 2) {
+        for (quint32 record = 0; record < elementCount && !m_nested; ++record) {
+            const char *parent = reinterpret_cast<const char*>(m_records + record * m_recordSize) + kParentOffset;
+            m_nested = get<qint32>(parent) >= 0;
+        }
+    }
+
+    if (version >= 4) {
+        if (end - in < qsizetype(sizeof(quint32)))
+            return fail(errorString, truncated);
+        quint32 attributeCount = get<quint32>(in);
+        if (attributeCount > quint64(end - in) / kAttributeSize)
+            return fail(errorString, truncated);
+        m_attributes = reinterpret_cast<const uchar*>(in);
+        m_attributeCount = attributeCount;
+        in += attributeCount * kAttributeSize;
+    }
+
+    if (propertiesSize > quint64(end - in))
+        return fail(errorString, truncated);
+    m_properties = QJsonDocument::fromJson(QByteArray::fromRawData(in, propertiesSize)).object();
+    return true;
+}
+
+bool WebDesignMapping::isHidden(qsizetype record) const
+{
+    if (m_recordSize <= kComponentOffset) return false;
+    const char *in = reinterpret_cast<const char*>(m_records + record * m_recordSize) + kFlagsOffset;
+    return get<quint32>(in) & kHiddenFlag;
+}
+
+QRectF WebDesignMapping::geometry(qsizetype record) const
+{
+    const char *in = reinterpret_cast<const char*>(m_records + record * m_recordSize);
+    qreal x = getDouble(in);
+    qreal y = getDouble(in);
+    qreal width = getDouble(in);
+    qreal height = getDouble(in);
+    return QRectF(x, y, width, height);
+}
+
+WebElementData WebDesignMapping::element(qsizetype record) const
+{
+    const char *in = reinterpret_cast<const char*>(m_records + record * m_recordSize);
+
+    WebElementData element;
+    element.x = getDouble(in);
+    element.y = getDouble(in);
+    element.width = getDouble(in);
+    element.height = getDouble(in);
+    element.type = string(get<quint32>(in));
+    element.id = string(get<quint32>(in));
+    element.cls = string(get<quint32>(in));
+    element.text = string(get<quint32>(in));
+    element.style = string(get<quint32>(in));
+    if (m_recordSize > kParentOffset)
+        element.parent = get<qint32>(in);
+    if (m_recordSize > kComponentOffset) {
+        element.component = get<quint32>(in);
+        element.part = get<qint32>(in);
+        const quint32 flags = get<quint32>(in);
+        element.overrides = quint8(flags);
+        element.hidden = flags & kHiddenFlag;
+    }
+
+    // Attributes are ordered by record, find the first one of this record
+    auto recordOf = [this](quint32 i) {
+        const char *entry = reinterpret_cast<const char*>(m_attributes + i * kAttributeSize);
+        return get<quint32>(entry);
+    };
+    quint32 low = 0;
+    quint32 high = m_attributeCount;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        if (recordOf(middle) < quint32(record))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (quint32 i = low; i < m_attributeCount && recordOf(i) == quint32(record); ++i) {
+        const char *entry = reinterpret_cast<const char*>(m_attributes + i * kAttributeSize) + sizeof(quint32);
+        quint32 field = get<quint32>(entry);
+        quint32 index = get<quint32>(entry);
+        if (field > quint32(WebElementField::Style) && field < WebElementFieldCount)
+            element.setValue(WebElementField(field), string(index));
+    }
+    return element;
+}
+
+QString WebDesignMapping::string(quint32 index) const
+{
+    if (index >= quint32(m_strings.size()))
+        return QString();
+
+    if (!m_decoded[index]) {
+        const char *in = reinterpret_cast<const char*>(m_stringData.at(index));
+        quint32 length = get<quint32>(in);
+
+        QString value(length, Qt::Uninitialized);
+        qFromLittleEndian<quint16>(in, length, value.data());
+        m_strings[index] = value;
+        m_decoded[index] = true;
+    }
+    return m_strings.at(index);
+}
@@ -0,0 +1,104 @@
+#ifndef WEBDESIGNSERIALIZER_H
+#define WEBDESIGNSERIALIZER_H
+
+#include "WebElementData.h"
+#include <QByteArray>
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <vector>
+
+struct WebDesignDocument
+{
+    QList<WebElementData> elements;
+    QJsonObject properties;
+
+    // Removes one element. Its children move up to its parent and keep their
+    // place on the page, the same way the canvas handles a removal.
+    void removeElement(qsizetype index);
+};
+
+// Reads and writes .webdesign files. Two encodings share the extension:
+//
+//  - JSON, the original human-readable format.
+//  - Binary, a little-endian layout made for fast loading:
+//      header   magic "WDSB", quint16 version, quint16 reserved,
+//               quint32 string count, quint32 element count,
+//               quint32 properties size
+//      strings  quint32 length + UTF-16 code units, each distinct value once
+//      records  fixed 68 byte element records: x, y, width, height as
+//               doubles, then type, id, class, text and style string indices,
+//               the parent element index as qint32 (-1 at the top level) and
+//               the component id, part and overridden fields of instances.
+//               Bit 8 of the overrides word marks elements hidden on the
+//               canvas.
+//               Version 1 records are 52 bytes, without the parent, version 2
+//               records 56 bytes, without the component.
+//      attrs    since version 4: quint32 count, then the fields beyond style
+//               (href, src, alt) as quint32 record, field and string index,
+//               ordered by record
+//      trailer  global properties as compact JSON
+//
+// Readers tell the formats apart by the magic bytes.
+class WebDesignSerializer
+{
+public:
+    enum Format {
+        JsonFormat,
+        BinaryFormat
+    };
+
+    static constexpr quint16 BinaryVersion = 4;
+
+    static bool read(const QString &fileName, WebDesignDocument *document,
+                     Format *format = nullptr, QString *errorString = nullptr);
+    static bool write(const QString &fileName, const WebDesignDocument &document,
+                      Format format, QString *errorString = nullptr);
+
+    static Format detectFormat(const QByteArray &data);
+    // Looks at the first bytes only; unreadable files count as JSON
+    static Format detectFileFormat(const QString &fileName);
+
+    static QByteArray toJson(const WebDesignDocument &document);
+    static bool fromJson(const QByteArray &data, WebDesignDocument *document, QString *errorString = nullptr);
+    static QByteArray toBinary(const WebDesignDocument &document);
+    static bool fromBinary(const QByteArray &data, WebDesignDocument *document, QString *errorString = nullptr);
+};
+
+// Read-only view of a binary design file through a memory mapping. Opening
+// only validates the layout and indexes the string table; element records
+// are decoded one at a time when they are asked for.
+class WebDesignMapping
+{
+public:
+    bool open(const QString &fileName, QString *errorString = nullptr);
+    QString fileName() const { return m_file.fileName(); }
+
+    qsizetype elementCount() const { return m_elementCount; }
+    // Nested elements are placed relative to their parent, not in canvas coordinates
+    bool isNested() const { return m_nested; }
+    QRectF geometry(qsizetype record) const;
+    bool isHidden(qsizetype record) const;
+    WebElementData element(qsizetype record) const;
+    QJsonObject properties() const { return m_properties; }
+
+private:
+    QString string(quint32 index) const;
+
+    QFile m_file;
+    const uchar *m_records = nullptr;
+    qsizetype m_recordSize = 0;
+    quint32 m_elementCount = 0;
+    const uchar *m_attributes = nullptr;
+    quint32 m_attributeCount = 0;
+    bool m_nested = false;
+    QList<const uchar*> m_stringData;
+    // Decoded strings are kept so every element shares one copy of a value
+    mutable QList<QString> m_strings;
+    mutable std::vector<bool> m_decoded;
+    QJsonObject m_properties;
+};
+
+#endif // WEBDESIGNSERIALIZER_H
@@ -0,0 +1,122 @@
+#include "WebEdgeIndex.h"
+#include <QSet>
+
+void WebEdgeIndex::clear()
+{
+    m_edges[Horizontal].clear();
+    m_edges[Vertical].clear();
+    m_rects.clear();
+}
+
+void WebEdgeIndex::edgesOf(const QRectF &rect, Axis axis, qreal edges[3])
+{
+    if (axis == Horizontal) {
+        edges[0] = rect.left();
+        edges[1] = rect.right();
+        edges[2] = rect.center().x();
+    } else {
+        edges[0] = rect.top();
+        edges[1] = rect.bottom();
+        edges[2] = rect.center().y();
+    }
+}
+
+void WebEdgeIndex::rebuild(const QList<Entry> &entries)
+{
+    clear();
+    m_rects.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        if (!entry.rect.isNull())
+            m_rects.insert(entry.key, entry.rect);
+    }
+
+    for (int axis : {Horizontal, Vertical}) {
+        QList<Edge> &edges = m_edges[axis];
+        edges.reserve(m_rects.size() * 3);
+        for (auto it = m_rects.cbegin(); it != m_rects.cend(); ++it) {
+            qreal positions[3];
+            edgesOf(it.value(), Axis(axis), positions);
+            for (qreal position : positions)
+                edges.append(Edge{position, it.key()});
+        }
+        std::sort(edges.begin(), edges.end());
+    }
+}
+
+void WebEdgeIndex::update(const QList<Entry> &entries)
+{
+    if (entries.size() <= UpdateInPlaceLimit) {
+        for (const Entry &entry : entries) {
+            auto it = m_rects.find(entry.key);
+            if (it != m_rects.end()) {
+                if (it.value() == entry.rect) continue;
+                removeEdges(entry.key, it.value());
+                m_rects.erase(it);
+            }
+            if (!entry.rect.isNull()) {
+                insertEdges(entry.key, entry.rect);
+                m_rects.insert(entry.key, entry.rect);
+            }
+        }
+        return;
+    }
+
+    // Shifting the lists once per edge would make a large batch quadratic,
+    // the changed edges are filtered out and merged back in one pass instead
+    QSet<quintptr> changed;
+    changed.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        changed.insert(entry.key);
+        if (entry.rect.isNull())
+            m_rects.remove(entry.key);
+        else
+            m_rects.insert(entry.key, entry.rect);
+    }
+
+    for (int axis : {Horizontal, Vertical}) {
+        QList<Edge> &edges = m_edges[axis];
+        edges.removeIf([&](const Edge &edge) { return changed.contains(edge.key); });
+
+        const qsizetype kept = edges.size();
+        for (quintptr key : std::as_const(changed)) {
+            auto it = m_rects.constFind(key);
+            if (it == m_rects.cend()) continue;
+
+            qreal positions[3];
+            edgesOf(it.value(), Axis(axis), positions);
+            for (qreal position : positions)
+                edges.append(Edge{position, key});
+        }
+        std::sort(edges.begin() + kept, edges.end());
+        std::inplace_merge(edges.begin(), edges.begin() + kept, edges.end());
+    }
+}
+
+void WebEdgeIndex::insertEdges(quintptr key, const QRectF &rect)
+{
+    for (int axis : {Horizontal, Vertical}) {
+        QList<Edge> &edges = m_edges[axis];
+        qreal positions[3];
+        edgesOf(rect, Axis(axis), positions);
+        for (qreal position : positions) {
+            const Edge edge{position, key};
+            edges.insert(std::upper_bound(edges.begin(), edges.end(), edge), edge);
+        }
+    }
+}
+
+void WebEdgeIndex::removeEdges(quintptr key, const QRectF &rect)
+{
+    // The positions are computed exactly as they were on insertion
+    for (int axis : {Horizontal, Vertical}) {
+        QList<Edge> &edges = m_edges[axis];
+        qreal positions[3];
+        edgesOf(rect, Axis(axis), positions);
+        for (qreal position : positions) {
+            auto [first, last] = std::equal_range(edges.begin(), edges.end(), Edge{position, 0});
+            auto it = std::find_if(first, last, [key](const Edge &edge) { return edge.key == key; });
+            if (it != last)
+                edges.erase(it);
+        }
+    }
+}
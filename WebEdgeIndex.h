@@ -0,0 +1,104 @@
+#ifndef WEBEDGEINDEX_H
+#define WEBEDGEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QtGlobal>
+#include <algorithm>
+#include <limits>
+
+// Left, center and right of every rectangle, and top, middle and bottom,
+// each axis kept as one sorted list. The edge nearest to a coordinate is a
+// binary search away, so snapping stays cheap however large the design is.
+//
+// Rectangles are identified by an opaque key. Changed rectangles are
+// updated in place; a batch of many is merged in one pass instead.
+class WebEdgeIndex
+{
+public:
+    enum Axis { Horizontal, Vertical };
+
+    struct Entry
+    {
+        quintptr key;
+        // A null rectangle removes the key
+        QRectF rect;
+    };
+
+    struct Match
+    {
+        qreal position = 0;
+        qreal distance = std::numeric_limits<qreal>::infinity();
+        quintptr key = 0;
+
+        bool isValid() const { return distance != std::numeric_limits<qreal>::infinity(); }
+    };
+
+    qsizetype size() const { return m_rects.size(); }
+    bool contains(quintptr key) const { return m_rects.contains(key); }
+    QRectF rect(quintptr key) const { return m_rects.value(key); }
+
+    void clear();
+    // Replaces everything, sorting once
+    void rebuild(const QList<Entry> &entries);
+    void update(const QList<Entry> &entries);
+    void insert(quintptr key, const QRectF &rect) { update({Entry{key, rect}}); }
+    void remove(quintptr key) { update({Entry{key, QRectF()}}); }
+
+    // Edge on axis nearest to position, no farther than tolerance, of a key
+    // that skip(key) does not reject
+    template<typename Skip>
+    Match nearest(Axis axis, qreal position, qreal tolerance, Skip skip) const;
+    Match nearest(Axis axis, qreal position, qreal tolerance) const
+    {
+        return nearest(axis, position, tolerance, [](quintptr) { return false; });
+    }
+
+    // Both edges and the center of a rectangle along an axis
+    static void edgesOf(const QRectF &rect, Axis axis, qreal edges[3]);
+
+private:
+    struct Edge
+    {
+        qreal position;
+        quintptr key;
+
+        bool operator<(const Edge &other) const { return position < other.position; }
+    };
+
+    // Up to this many changes are applied one by one
+    static constexpr qsizetype UpdateInPlaceLimit = 16;
+
+    void insertEdges(quintptr key, const QRectF &rect);
+    void removeEdges(quintptr key, const QRectF &rect);
+
+    QList<Edge> m_edges[2];
+    QHash<quintptr, QRectF> m_rects;
+};
+
+template<typename Skip>
+WebEdgeIndex::Match WebEdgeIndex::nearest(Axis axis, qreal position, qreal tolerance, Skip skip) const
+{
+    // Walk outwards from the insertion point, skipped keys only lengthen the walk
+    const QList<Edge> &edges = m_edges[axis];
+    const auto split = std::lower_bound(edges.cbegin(), edges.cend(), Edge{position, 0});
+
+    Match match;
+    for (auto it = split; it != edges.cend() && it->position - position <= tolerance; ++it) {
+        if (skip(it->key)) continue;
+        match = Match{it->position, it->position - position, it->key};
+        break;
+    }
+    for (auto it = split; it != edges.cbegin();) {
+        --it;
+        const qreal distance = position - it->position;
+        if (distance > tolerance || distance >= match.distance) break;
+        if (skip(it->key)) continue;
+        match = Match{it->position, distance, it->key};
+        break;
+    }
+    return match;
+}
+
+#endif // WEBEDGEINDEX_H
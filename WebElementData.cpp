@@ -0,0 +1,144 @@
+#include "WebElementData.h"
+#include "WebStringPool.h"
+#include <bit>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr QLatin1StringView kFieldNames[WebElementFieldCount] = {
+    "id"_L1, "class"_L1, "text"_L1, "style"_L1, "href"_L1, "src"_L1, "alt"_L1
+};
+
+const QString &emptyString()
+{
+    static const QString empty;
+    return empty;
+}
+}
+
+QLatin1StringView webElementFieldName(WebElementField field)
+{
+    return kFieldNames[int(field)];
+}
+
+qsizetype WebElementFields::indexOf(WebElementField field) const
+{
+    // Values are stored in field order, a field's slot is the number of set fields before it
+    return std::popcount(uint(m_set & (bit(field) - 1)));
+}
+
+const QString &WebElementFields::value(WebElementField field) const
+{
+    return has(field) ? m_values.at(indexOf(field)) : emptyString();
+}
+
+void WebElementFields::setValue(WebElementField field, const QString &value)
+{
+    const qsizetype index = indexOf(field);
+    if (value.isEmpty()) {
+        if (!has(field)) return;
+        m_values.removeAt(index);
+        m_set &= quint8(~bit(field));
+        return;
+    }
+
+    // Classes and styles repeat across elements, ids and text rarely do
+    const bool token = field == WebElementField::Class || field == WebElementField::Style;
+    const QString stored = token ? WebStringPool::intern(value) : value;
+    if (has(field)) {
+        m_values[index] = stored;
+    } else {
+        m_values.insert(index, stored);
+        m_set |= bit(field);
+    }
+}
+
+QString WebElementData::value(WebElementField field) const
+{
+    switch (field) {
+    case WebElementField::Id: return id;
+    case WebElementField::Class: return cls;
+    case WebElementField::Text: return text;
+    case WebElementField::Style: return style;
+    default:
+        break;
+    }
+    for (const WebAttribute &attribute : attributes) {
+        if (attribute.field == field)
+            return attribute.value;
+    }
+    return QString();
+}
+
+void WebElementData::setValue(WebElementField field, const QString &value)
+{
+    switch (field) {
+    case WebElementField::Id: id = value; return;
+    case WebElementField::Class: cls = value; return;
+    case WebElementField::Text: text = value; return;
+    case WebElementField::Style: style = value; return;
+    default:
+        break;
+    }
+
+    auto it = attributes.begin();
+    while (it != attributes.end() && it->field < field)
+        ++it;
+    const bool found = it != attributes.end() && it->field == field;
+    if (value.isEmpty()) {
+        if (found) attributes.erase(it);
+    } else if (found) {
+        it->value = value;
+    } else {
+        attributes.insert(it, WebAttribute{field, value});
+    }
+}
+
+QJsonObject WebElementData::toJson() const
+{
+    QJsonObject json;
+    json["type"] = type;
+    json["x"] = x;
+    json["y"] = y;
+    json["width"] = width;
+    json["height"] = height;
+    json["id"] = id;
+    json["class"] = cls;
+    json["text"] = text;
+    json["style"] = style;
+    for (const WebAttribute &attribute : attributes)
+        json[webElementFieldName(attribute.field)] = attribute.value;
+    if (parent >= 0)
+        json["parent"] = parent;
+    if (hidden)
+        json["hidden"] = true;
+    if (isInstance()) {
+        json["component"] = qint64(component);
+        json["part"] = part;
+        json["overrides"] = overrides;
+    }
+    return json;
+}
+
+WebElementData WebElementData::fromJson(const QJsonObject &json)
+{
+    // Every parsed value is a string of its own, the repeating ones are interned
+    WebElementData data;
+    data.type = WebStringPool::intern(json["type"].toString());
+    data.x = json["x"].toDouble();
+    data.y = json["y"].toDouble();
+    data.width = json["width"].toDouble();
+    data.height = json["height"].toDouble();
+    data.id = json["id"].toString();
+    data.cls = WebStringPool::intern(json["class"].toString());
+    data.text = json["text"].toString();
+    data.style = WebStringPool::intern(json["style"].toString());
+    for (int field = int(WebElementField::Href); field < WebElementFieldCount; ++field)
+        data.setValue(WebElementField(field), json[kFieldNames[field]].toString());
+    data.parent = json["parent"].toInt(-1);
+    data.hidden = json["hidden"].toBool();
+    data.component = quint32(json["component"].toInteger());
+    data.part = json["part"].toInt(-1);
+    data.overrides = quint8(json["overrides"].toInt());
+    return data;
+}
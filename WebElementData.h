@@ -0,0 +1,91 @@
+#ifndef WEBELEMENTDATA_H
+#define WEBELEMENTDATA_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QSharedData>
+#include <QString>
+
+// Properties of an element that are edited as text. Fields after Style are
+// HTML attributes only some types use; new ones are added at the end.
+enum class WebElementField : quint8 {
+    Id,
+    Class,
+    Text,
+    Style,
+    Href,
+    Src,
+    Alt
+};
+
+constexpr int WebElementFieldCount = int(WebElementField::Alt) + 1;
+
+// Attribute name of a field in HTML and in the JSON format
+QLatin1StringView webElementFieldName(WebElementField field);
+
+// The text properties of an element, stored compactly: only fields that are
+// set take room, in one array ordered by field. Class and style values are
+// interned (see WebStringPool). Items hold the fields through a
+// QSharedDataPointer, so the instances of a component share one copy with
+// the component and only detach once they change a field.
+class WebElementFields : public QSharedData
+{
+public:
+    bool has(WebElementField field) const { return m_set & bit(field); }
+    const QString &value(WebElementField field) const;
+    // An empty value removes the field
+    void setValue(WebElementField field, const QString &value);
+    qsizetype size() const { return m_values.size(); }
+
+private:
+    static constexpr quint8 bit(WebElementField field) { return quint8(1u << int(field)); }
+    qsizetype indexOf(WebElementField field) const;
+
+    QList<QString> m_values;
+    quint8 m_set = 0;
+};
+
+// A field beyond the four every element has
+struct WebAttribute
+{
+    WebElementField field;
+    QString value;
+};
+
+// Plain copy of an element's properties. Strings are implicitly shared, so a
+// snapshot is cheap to take and safe to hand to a worker thread.
+struct WebElementData
+{
+    QString type;
+    QString id;
+    QString cls;
+    QString text;
+    QString style;
+    qreal x = 0;
+    qreal y = 0;
+    qreal width = 0;
+    qreal height = 0;
+    // Index of the enclosing element in the same list, -1 at the top level.
+    // Nested elements are positioned relative to that element.
+    qint32 parent = -1;
+    // Instances of a component name it and the part of it they are, and
+    // mark the fields they set themselves with fieldBit(). 0 is no component.
+    quint32 component = 0;
+    qint32 part = -1;
+    quint8 overrides = 0;
+    // Hidden on the canvas, with its subtree. HTML is written all the same.
+    bool hidden = false;
+    // Href, src and alt when set, ordered by field
+    QList<WebAttribute> attributes;
+
+    QString value(WebElementField field) const;
+    void setValue(WebElementField field, const QString &value);
+
+    bool isInstance() const { return component != 0; }
+    static constexpr quint8 fieldBit(WebElementField field) { return quint8(1u << int(field)); }
+
+    QJsonObject toJson() const;
+    static WebElementData fromJson(const QJsonObject &json);
+};
+
+#endif // WEBELEMENTDATA_H
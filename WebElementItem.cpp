@@ -1,121 +1,434 @@
 #include "WebElementItem.h"
+#include "WebDesignScene.h"
+#include "WebProfiler.h"
+#include "WebStyleEngine.h"
+#include "WebStringPool.h"
 #include <QPainter>
 #include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QCache>
+#include <QStaticText>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+
+namespace {
+// Below this scale handles and labels are too small to be useful
+constexpr qreal kDetailLevelOfDetail = 0.5;
+constexpr qreal kHandleSize = 8.0;
+constexpr qreal kMinimumSize = 20.0;
+
+// Pens and brushes are shared by every element instead of being built per paint
+struct PaintResources
+{
+    QPen normalPen{Qt::black, 1};
+    QPen selectedPen{Qt::blue, 2, Qt::DashLine};
+    QPen handlePen{Qt::black, 1};
+    QBrush handleBrush{Qt::white};
+    QBrush fill[size_t(WebElementKind::Unknown) + 1];
+    QBrush selectedFill[size_t(WebElementKind::Unknown) + 1];
+
+    PaintResources()
+    {
+        for (size_t i = 0; i <= size_t(WebElementKind::Unknown); ++i) {
+            QColor color = QColor::fromRgb(WebElementTypeInfo::of(WebElementKind(i)).color);
+            fill[i] = QBrush(color);
+            selectedFill[i] = QBrush(color.lighter(110));
+        }
+    }
+};
+
+const PaintResources &paintResources()
+{
+    static const PaintResources resources;
+    return resources;
+}
+
+// Most labels repeat (type names, button captions), so laid out labels are
+// shared through one cache instead of every element owning a text document
+constexpr int kLabelCacheSize = 4096;
+
+const QStaticText &labelFor(const QString &text, const QFont *font)
+{
+    static QCache<QString, QStaticText> cache(kLabelCacheSize);
+
+    // A label is laid out for one font, styled labels are cached per font
+    const QString key = font ? text + QChar(0) + font->key() : text;
+    QStaticText *label = cache.object(key);
+    if (!label) {
+        QString display = text;
+        display.replace(u'\n', QChar::LineSeparator);
+
+        label = new QStaticText(display);
+        label->setTextFormat(Qt::PlainText);
+        label->setPerformanceHint(QStaticText::AggressiveCaching);
+        if (font)
+            label->prepare(QTransform(), *font);
+        cache.insert(key, label);
+    }
+    return *label;
+}
+}
 
 WebElementItem::WebElementItem(const QString &type, QGraphicsItem *parent)
-    : QGraphicsRectItem(parent), m_type(type)
+    : QGraphicsRectItem(parent), m_kind(WebElementTypeInfo::kindOf(type)), m_type(WebStringPool::intern(type)),
+      m_fields(new WebElementFields)
 {
     setFlag(QGraphicsItem::ItemIsMovable, true);
     setFlag(QGraphicsItem::ItemIsSelectable, true);
     setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
     
     // Default properties
-    m_id = "";
-    m_class = "";
-    m_text = type;
-    m_style = "";
+    m_fields->setValue(WebElementField::Text, type);
     
     // Set initial size based on type
-    if (type == "Container" || type == "Section" || type == "Article") {
-        setRect(0, 0, 300, 200);
-    } else if (type.startsWith("Heading")) {
-        setRect(0, 0, 400, 60);
-    } else if (type == "Text" || type == "Paragraph") {
-        setRect(0, 0, 400, 100);
-    } else if (type == "Button") {
-        setRect(0, 0, 120, 40);
-    } else if (type == "Image") {
-        setRect(0, 0, 200, 150);
-    } else {
-        setRect(0, 0, 200, 80);
-    }
-    
-    m_textItem = new QGraphicsTextItem(m_text, this);
-    m_textItem->setPos(10, 10);
-    m_textItem->setTextInteractionFlags(Qt::TextEditorInteraction);
+    setRect(QRectF(QPointF(0, 0), WebElementTypeInfo::of(m_kind).defaultSize));
     
     updateDisplay();
 }
 
+WebElementData WebElementItem::elementData() const
+{
+    const WebElementFields &fields = *m_fields;
+    WebElementData data{m_type, fields.value(WebElementField::Id), fields.value(WebElementField::Class),
+                        fields.value(WebElementField::Text), fields.value(WebElementField::Style)};
+    for (int field = int(WebElementField::Href); field < WebElementFieldCount; ++field) {
+        if (fields.has(WebElementField(field)))
+            data.attributes.append(WebAttribute{WebElementField(field), fields.value(WebElementField(field))});
+    }
+    data.x = pos().x();
+    data.y = pos().y();
+    data.width = rect().width();
+    data.height = rect().height();
+    data.component = m_component;
+    data.part = m_part;
+    data.overrides = m_overrides;
+    // Hidden by itself, not because a container is
+    data.hidden = !isVisibleTo(parentItem());
+    return data;
+}
+
+void WebElementItem::setElementData(const WebElementData &data)
+{
+    setGeometry(QRectF(data.x, data.y, data.width, data.height));
+    WebElementFields *fields = new WebElementFields;
+    fields->setValue(WebElementField::Id, data.id);
+    fields->setValue(WebElementField::Class, data.cls);
+    fields->setValue(WebElementField::Text, data.text);
+    fields->setValue(WebElementField::Style, data.style);
+    for (const WebAttribute &attribute : data.attributes)
+        fields->setValue(attribute.field, attribute.value);
+    m_fields.reset(fields);
+    m_master.reset();
+    m_component = 0;
+    m_part = -1;
+    m_overrides = 0;
+    setVisible(!data.hidden);
+
+    updateDisplay();
+}
+
+void WebElementItem::setComponent(quint32 component, qint32 part, quint8 overrides,
+                                  const QSharedDataPointer<WebElementFields> &master)
+{
+    m_component = master ? component : 0;
+    m_part = master ? part : -1;
+    m_overrides = master ? overrides : 0;
+    m_master = master;
+    applyMaster();
+    updateDisplay();
+}
+
+void WebElementItem::followComponent(const QSharedDataPointer<WebElementFields> &master)
+{
+    if (!isInstance() || !master) return;
+    m_master = master;
+    applyMaster();
+    updateDisplay();
+}
+
+void WebElementItem::clearOverrides()
+{
+    if (!isInstance()) return;
+    m_overrides = 0;
+    applyMaster();
+    updateDisplay();
+}
+
+void WebElementItem::applyMaster()
+{
+    if (!m_master) return;
+
+    // Only an instance with overrides holds fields of its own
+    const QSharedDataPointer<WebElementFields> own = m_fields;
+    m_fields = m_master;
+    for (int field = 0; field < WebElementFieldCount; ++field) {
+        if (m_overrides & WebElementData::fieldBit(WebElementField(field)))
+            m_fields->setValue(WebElementField(field), own.constData()->value(WebElementField(field)));
+    }
+}
+
+bool WebElementItem::setField(WebElementField field, const QString &value)
+{
+    // Reading through constData() keeps a shared copy shared
+    if (m_fields.constData()->value(field) == value) return false;
+
+    if (m_master) {
+        const quint8 bit = WebElementData::fieldBit(field);
+        if (value == m_master.constData()->value(field))
+            m_overrides &= quint8(~bit);
+        else
+            m_overrides |= bit;
+        if (m_overrides == 0) {
+            m_fields = m_master;
+            return true;
+        }
+    }
+    m_fields->setValue(field, value);
+    return true;
+}
+
+void WebElementItem::setId(const QString &id)
+{
+    if (setField(WebElementField::Id, id))
+        notifyChanged();
+}
+
+void WebElementItem::setClass(const QString &cls)
+{
+    if (setField(WebElementField::Class, cls))
+        notifyChanged();
+}
+
+void WebElementItem::setText(const QString &text)
+{
+    if (setField(WebElementField::Text, text))
+        updateDisplay();
+}
+
+void WebElementItem::setStyle(const QString &style)
+{
+    if (setField(WebElementField::Style, style))
+        notifyChanged();
+}
+
+void WebElementItem::setElementField(WebElementField field, const QString &value)
+{
+    if (!setField(field, value)) return;
+    // Only the text is drawn
+    if (field == WebElementField::Text)
+        updateDisplay();
+    else
+        notifyChanged();
+}
+
+void WebElementItem::setComputedStyle(std::shared_ptr<const WebElementStyle> style)
+{
+    if (style == m_computedStyle) return;
+    // Sizes and border widths move the bounds
+    prepareGeometryChange();
+    const QRectF before = displayRect();
+    m_computedStyle = std::move(style);
+    update();
+
+    WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene());
+    if (designScene && displayRect() != before)
+        designScene->invalidateEdges(this);
+}
+
+QRectF WebElementItem::displayRect() const
+{
+    QRectF rect = this->rect();
+    if (!m_computedStyle) return rect;
+
+    const WebStyle &style = m_computedStyle->computed;
+    if (style.has(WebStyle::Width))
+        rect.setWidth(qMax(style.width, 1.0));
+    if (style.has(WebStyle::Height))
+        rect.setHeight(qMax(style.height, 1.0));
+    return rect;
+}
+
+QRectF WebElementItem::boundingRect() const
+{
+    // Room for half of the widest pen, the selection outline or the CSS border
+    qreal penWidth = 2;
+    if (m_computedStyle && m_computedStyle->hasBorder())
+        penWidth = qMax(penWidth, m_computedStyle->border.widthF());
+    const qreal margin = penWidth / 2;
+    return displayRect().adjusted(-margin, -margin, margin, margin);
+}
+
+QPainterPath WebElementItem::shape() const
+{
+    QPainterPath path;
+    path.addRect(displayRect());
+    return path;
+}
+
 QJsonObject WebElementItem::toJson() const
 {
-    QJsonObject json;
-    json["type"] = m_type;
-    json["x"] = pos().x();
-    json["y"] = pos().y();
-    json["width"] = rect().width();
-    json["height"] = rect().height();
-    json["id"] = m_id;
-    json["class"] = m_class;
-    json["text"] = m_text;
-    json["style"] = m_style;
-    return json;
+    return elementData().toJson();
 }
 
 void WebElementItem::fromJson(const QJsonObject &json)
 {
-    setPos(json["x"].toDouble(), json["y"].toDouble());
-    setRect(0, 0, json["width"].toDouble(), json["height"].toDouble());
-    m_id = json["id"].toString();
-    m_class = json["class"].toString();
-    m_text = json["text"].toString();
-    m_style = json["style"].toString();
-    
-    updateDisplay();
+    setElementData(WebElementData::fromJson(json));
+}
+
+void WebElementItem::setGeometry(const QRectF &geometry)
+{
+    // Resize before moving so the position change reports the final bounds
+    bool resized = geometry.size() != rect().size();
+    setRect(QRectF(QPointF(0, 0), geometry.size()));
+    setPos(geometry.topLeft());
+
+    WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene());
+    if (resized && designScene)
+        designScene->notifyGeometryChanged(this);
+}
+
+int WebElementItem::handleAt(const QPointF &pos) const
+{
+    const QRectF rect = displayRect();
+    const QPointF corners[] = {
+        rect.topLeft(),
+        rect.topRight() - QPointF(kHandleSize, 0),
+        rect.bottomLeft() - QPointF(0, kHandleSize),
+        rect.bottomRight() - QPointF(kHandleSize, kHandleSize),
+    };
+    for (int handle = TopLeft; handle <= BottomRight; ++handle) {
+        if (QRectF(corners[handle], QSizeF(kHandleSize, kHandleSize)).contains(pos))
+            return handle;
+    }
+    return NoHandle;
+}
+
+void WebElementItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    // Handles are only drawn, and only grabbed, on selected elements
+    m_resizeHandle = isSelected() && event->button() == Qt::LeftButton ? handleAt(event->pos()) : NoHandle;
+    if (m_resizeHandle == NoHandle) {
+        QGraphicsRectItem::mousePressEvent(event);
+        return;
+    }
+    event->accept();
+}
+
+void WebElementItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (m_resizeHandle == NoHandle) {
+        QGraphicsRectItem::mouseMoveEvent(event);
+        return;
+    }
+
+    // The corner opposite to the handle stays where it is
+    QRectF geometry = this->geometry();
+    const QPointF point = mapToParent(event->pos());
+    if (m_resizeHandle == TopLeft || m_resizeHandle == BottomLeft)
+        geometry.setLeft(qMin(point.x(), geometry.right() - kMinimumSize));
+    else
+        geometry.setRight(qMax(point.x(), geometry.left() + kMinimumSize));
+    if (m_resizeHandle == TopLeft || m_resizeHandle == TopRight)
+        geometry.setTop(qMin(point.y(), geometry.bottom() - kMinimumSize));
+    else
+        geometry.setBottom(qMax(point.y(), geometry.top() + kMinimumSize));
+    setGeometry(geometry);
+}
+
+void WebElementItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (m_resizeHandle == NoHandle) {
+        QGraphicsRectItem::mouseReleaseEvent(event);
+        return;
+    }
+    m_resizeHandle = NoHandle;
+    event->accept();
+}
+
+QVariant WebElementItem::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    // Dragging snaps, a resize moves the item too but keeps the corner under the mouse
+    if (change == ItemPositionChange && !isResizing()) {
+        if (WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene()))
+            return designScene->snapPosition(this, value.toPointF());
+    }
+    if (change == ItemPositionHasChanged) {
+        if (WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene()))
+            designScene->notifyGeometryChanged(this);
+    }
+    return QGraphicsRectItem::itemChange(change, value);
 }
 
 void WebElementItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
     Q_UNUSED(widget);
-    
-    QColor fillColor = typeToColor(m_type);
-    if (isSelected()) {
-        fillColor = fillColor.lighter(110);
-        painter->setPen(QPen(Qt::blue, 2, Qt::DashLine));
-    } else {
-        painter->setPen(QPen(Qt::black, 1));
+    const WebProfileScope scope("item/paint");
+
+    const PaintResources &resources = paintResources();
+    const size_t kind = size_t(m_kind);
+    const bool selected = option->state.testFlag(QStyle::State_Selected);
+    const QRectF rect = displayRect();
+    const WebElementStyle *style = m_computedStyle.get();
+
+    // CSS replaces the type's colors; the selection outline still wins over the border
+    const QPen &outline = style && style->hasBorder() ? style->border : resources.normalPen;
+    painter->setPen(selected ? resources.selectedPen : outline);
+    if (style && style->hasFill())
+        painter->setBrush(selected ? style->selectedFill : style->fill);
+    else
+        painter->setBrush(selected ? resources.selectedFill[kind] : resources.fill[kind]);
+    painter->drawRect(rect);
+
+    // Labels and handles are unreadable when zoomed far out
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) < kDetailLevelOfDetail)
+        return;
+
+    const QString &text = m_fields.constData()->value(WebElementField::Text);
+    if (!text.isEmpty()) {
+        const bool styledFont = style && style->hasFont();
+        const QStaticText &label = labelFor(text, styledFont ? &style->font : nullptr);
+        const QPointF origin = rect.topLeft() + labelOffset();
+        const bool overflows = !rect.contains(QRectF(origin, label.size()));
+
+        if (overflows || styledFont) {
+            painter->save();
+            if (overflows)
+                painter->setClipRect(rect, Qt::IntersectClip);
+            if (styledFont)
+                painter->setFont(style->font);
+        }
+        painter->setPen(style && style->hasTextColor() ? style->text : resources.normalPen);
+        painter->drawStaticText(origin, label);
+        if (overflows || styledFont)
+            painter->restore();
     }
-    
-    painter->setBrush(fillColor);
-    painter->drawRect(rect());
-    
+
     // Draw resize handles if selected
-    if (isSelected()) {
-        painter->setBrush(Qt::white);
-        painter->setPen(QPen(Qt::black, 1));
-        
-        const qreal handleSize = 8.0;
-        QRectF rect = this->rect();
-        
-        // Top-left
-        painter->drawRect(QRectF(rect.topLeft(), QSizeF(handleSize, handleSize)));
-        // Top-right
-        painter->drawRect(QRectF(rect.topRight() - QPointF(handleSize, 0), 
-                         QSizeF(handleSize, handleSize)));
-        // Bottom-left
-        painter->drawRect(QRectF(rect.bottomLeft() - QPointF(0, handleSize), 
-                         QSizeF(handleSize, handleSize)));
-        // Bottom-right
-        painter->drawRect(QRectF(rect.bottomRight() - QPointF(handleSize, handleSize), 
-                         QSizeF(handleSize, handleSize)));
-    }
+    if (!selected)
+        return;
+
+    painter->setPen(resources.handlePen);
+    painter->setBrush(resources.handleBrush);
+
+    const QSizeF handle(kHandleSize, kHandleSize);
+    const QRectF handles[] = {
+        QRectF(rect.topLeft(), handle),
+        QRectF(rect.topRight() - QPointF(kHandleSize, 0), handle),
+        QRectF(rect.bottomLeft() - QPointF(0, kHandleSize), handle),
+        QRectF(rect.bottomRight() - QPointF(kHandleSize, kHandleSize), handle),
+    };
+    painter->drawRects(handles, 4);
 }
 
 void WebElementItem::updateDisplay()
 {
-    m_textItem->setPlainText(m_text);
     update();
+    notifyChanged();
 }
 
-QColor WebElementItem::typeToColor(const QString &type) const
+void WebElementItem::notifyChanged()
 {
-    if (type == "Container") return QColor(230, 230, 250);
-    if (type == "Section") return QColor(230, 250, 230);
-    if (type == "Article") return QColor(250, 230, 230);
-    if (type.startsWith("Heading")) return QColor(255, 200, 200);
-    if (type == "Text" || type == "Paragraph") return QColor(200, 230, 255);
-    if (type == "Button") return QColor(200, 255, 200);
-    if (type == "Image") return QColor(255, 255, 200);
-    if (type == "Form") return QColor(220, 220, 220);
-    return QColor(240, 240, 240);
-}
\ No newline at end of file
+    // Id, class and style are not drawn, so those setters skip the repaint
+    if (WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene()))
+        designScene->notifyElementChanged(this);
+}
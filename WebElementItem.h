@@ -1,8 +1,14 @@
 #ifndef WEBELEMENTITEM_H
 #define WEBELEMENTITEM_H
 
+#include "WebElementData.h"
+#include "WebElementType.h"
 #include <QGraphicsRectItem>
 #include <QJsonObject>
+#include <QSharedDataPointer>
+#include <memory>
+
+struct WebElementStyle;
 
 class WebElementItem : public QGraphicsRectItem
 {
@@ -10,32 +16,93 @@ public:
     WebElementItem(const QString &type, QGraphicsItem *parent = nullptr);
 
     QString elementType() const { return m_type; }
-    QString elementId() const { return m_id; }
-    QString elementClass() const { return m_class; }
-    QString elementText() const { return m_text; }
-    QString elementStyle() const { return m_style; }
+    WebElementKind elementKind() const { return m_kind; }
+    QString elementId() const { return m_fields->value(WebElementField::Id); }
+    QString elementClass() const { return m_fields->value(WebElementField::Class); }
+    QString elementText() const { return m_fields->value(WebElementField::Text); }
+    QString elementStyle() const { return m_fields->value(WebElementField::Style); }
+    // Any field, including the attributes only some types use such as href
+    QString elementField(WebElementField field) const { return m_fields->value(field); }
+
+    // The parent index is left at -1, only the scene knows the parent's slot.
+    // Setting the data makes the element a plain one, see setComponent.
+    WebElementData elementData() const;
+    void setElementData(const WebElementData &data);
+
+    // Instances of a component share the fields of its part and only hold
+    // their own copy once they override one; setting a field back to the
+    // master's value drops the override
+    bool isInstance() const { return m_component != 0; }
+    quint32 component() const { return m_component; }
+    qint32 componentPart() const { return m_part; }
+    quint8 overrides() const { return m_overrides; }
+    // A null master turns the element into a plain one with the values it shows
+    void setComponent(quint32 component, qint32 part, quint8 overrides,
+                      const QSharedDataPointer<WebElementFields> &master);
+    // Takes a new master copy of the part, keeping the overridden fields
+    void followComponent(const QSharedDataPointer<WebElementFields> &master);
+    // Makes the shown values the master's, e.g. once they were pushed to the component
+    void clearOverrides();
+
+    // Elements are only ever parented to other elements
+    WebElementItem *parentElement() const { return static_cast<WebElementItem*>(parentItem()); }
+    bool hasChildElements() const { return !childItems().isEmpty(); }
+    bool canContain() const { return WebElementTypeInfo::of(m_kind).container; }
+
+    // Position and size in the parent's coordinates, the scene's for top level elements
+    QRectF geometry() const { return QRectF(pos(), rect().size()); }
+    void setGeometry(const QRectF &geometry);
 
-    void setId(const QString &id) { m_id = id; updateDisplay(); }
-    void setClass(const QString &cls) { m_class = cls; updateDisplay(); }
-    void setText(const QString &text) { m_text = text; updateDisplay(); }
-    void setStyle(const QString &style) { m_style = style; updateDisplay(); }
+    void setId(const QString &id);
+    void setClass(const QString &cls);
+    void setText(const QString &text);
+    void setStyle(const QString &style);
+    void setElementField(WebElementField field, const QString &value);
+
+    // Resolved CSS, set by WebStyleEngine; null paints the type's default look
+    const std::shared_ptr<const WebElementStyle> &computedStyle() const { return m_computedStyle; }
+    void setComputedStyle(std::shared_ptr<const WebElementStyle> style);
+    // The box as drawn, CSS width and height replace the size on the canvas
+    QRectF displayRect() const;
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
 
     QJsonObject toJson() const;
     void fromJson(const QJsonObject &json);
 
+    static QPointF labelOffset() { return QPointF(10, 10); }
+
+    // A corner handle is being dragged
+    bool isResizing() const { return m_resizeHandle != NoHandle; }
+
 protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
 private:
     void updateDisplay();
-    QColor typeToColor(const QString &type) const;
+    void notifyChanged();
+    bool setField(WebElementField field, const QString &value);
+    void applyMaster();
+    int handleAt(const QPointF &pos) const;
+
+    // Corner handles in paint order: top left, top right, bottom left, bottom right
+    enum { NoHandle = -1, TopLeft, TopRight, BottomLeft, BottomRight };
 
+    WebElementKind m_kind;
     QString m_type;
-    QString m_id;
-    QString m_class;
-    QString m_text;
-    QString m_style;
-    QGraphicsTextItem *m_textItem;
+    QSharedDataPointer<WebElementFields> m_fields;
+    // Only set on instances
+    QSharedDataPointer<WebElementFields> m_master;
+    quint32 m_component = 0;
+    qint32 m_part = -1;
+    quint8 m_overrides = 0;
+    int m_resizeHandle = NoHandle;
+    std::shared_ptr<const WebElementStyle> m_computedStyle;
 };
 
 #endif // WEBELEMENTITEM_H
\ No newline at end of file
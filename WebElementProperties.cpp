@@ -1,5 +1,8 @@
 #include "WebElementProperties.h"
 #include "WebElementItem.h"
+#include "WebDesignScene.h"
+#include "WebDesignCommands.h"
+#include "WebHtmlWriter.h"
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QLabel>
@@ -7,10 +10,33 @@
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QGroupBox>
+#include <QTimer>
+#include <QSignalBlocker>
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace {
+// The attributes beyond the common fields only mean something to some types
+bool takesField(WebElementKind kind, WebElementField field)
+{
+    switch (field) {
+    case WebElementField::Href: return kind == WebElementKind::Link;
+    case WebElementField::Src:
+    case WebElementField::Alt: return kind == WebElementKind::Image;
+    default: return true;
+    }
+}
+}
 
 WebElementProperties::WebElementProperties(QWidget *parent)
-    : QWidget(parent), m_currentElement(nullptr)
+    : QWidget(parent), m_pendingFields(0)
 {
+    m_commitTimer = new QTimer(this);
+    m_commitTimer->setSingleShot(true);
+    m_commitTimer->setInterval(CommitDelayMs);
+    connect(m_commitTimer, &QTimer::timeout, this, &WebElementProperties::commitPendingChanges);
+
     setupUi();
 }
 
@@ -19,11 +45,11 @@ void WebElementProperties::setupUi()
     QVBoxLayout *layout = new QVBoxLayout(this);
     
     // Element properties
-    QGroupBox *elementGroup = new QGroupBox(tr("Element Properties"));
+    m_elementGroup = new QGroupBox(tr("Element Properties"));
     QFormLayout *formLayout = new QFormLayout;
     
     m_typeCombo = new QComboBox;
-    m_typeCombo->addItems({"div", "section", "article", "h1", "h2", "h3", "p", "button", "img", "a", "ul", "input", "textarea", "form"});
+    m_typeCombo->addItems({"div", "section", "article", "h1", "h2", "h3", "p", "button", "img", "a", "ul", "input", "textarea", "form", "footer", "nav"});
     formLayout->addRow(tr("Tag:"), m_typeCombo);
     
     m_idEdit = new QLineEdit;
@@ -39,9 +65,18 @@ void WebElementProperties::setupUi()
     m_styleEdit = new QTextEdit;
     m_styleEdit->setMaximumHeight(100);
     formLayout->addRow(tr("Style:"), m_styleEdit);
+
+    m_hrefEdit = new QLineEdit;
+    formLayout->addRow(tr("Link:"), m_hrefEdit);
+
+    m_srcEdit = new QLineEdit;
+    formLayout->addRow(tr("Source:"), m_srcEdit);
+
+    m_altEdit = new QLineEdit;
+    formLayout->addRow(tr("Alt text:"), m_altEdit);
     
-    elementGroup->setLayout(formLayout);
-    layout->addWidget(elementGroup);
+    m_elementGroup->setLayout(formLayout);
+    layout->addWidget(m_elementGroup);
     
     // Global CSS
     QGroupBox *cssGroup = new QGroupBox(tr("Global CSS"));
@@ -55,76 +90,213 @@ void WebElementProperties::setupUi()
     layout->addWidget(cssGroup);
     
     // Connect signals
-    connect(m_typeCombo, &QComboBox::currentTextChanged, this, &WebElementProperties::onPropertyChanged);
-    connect(m_idEdit, &QLineEdit::textEdited, this, &WebElementProperties::onPropertyChanged);
-    connect(m_classEdit, &QLineEdit::textEdited, this, &WebElementProperties::onPropertyChanged);
-    connect(m_textEdit, &QTextEdit::textChanged, this, &WebElementProperties::onPropertyChanged);
-    connect(m_styleEdit, &QTextEdit::textChanged, this, &WebElementProperties::onPropertyChanged);
-    connect(m_globalCssEdit, &QTextEdit::textChanged, this, &WebElementProperties::onPropertyChanged);
+    connect(m_idEdit, &QLineEdit::textEdited, this, &WebElementProperties::onIdEdited);
+    connect(m_classEdit, &QLineEdit::textEdited, this, &WebElementProperties::onClassEdited);
+    connect(m_textEdit, &QTextEdit::textChanged, this, &WebElementProperties::onTextChanged);
+    connect(m_styleEdit, &QTextEdit::textChanged, this, &WebElementProperties::onStyleChanged);
+    for (QLineEdit *edit : {m_hrefEdit, m_srcEdit, m_altEdit})
+        connect(edit, &QLineEdit::textEdited, this, &WebElementProperties::onAttributeEdited);
+    connect(m_globalCssEdit, &QTextEdit::textChanged, this, &WebElementProperties::onGlobalCssChanged);
 }
 
 void WebElementProperties::setCurrentElement(QGraphicsItem *item)
 {
-    m_currentElement = dynamic_cast<WebElementItem*>(item);
+    WebElementItem *element = dynamic_cast<WebElementItem*>(item);
+    setSelection(element ? QList<WebElementItem*>{element} : QList<WebElementItem*>());
+}
+
+void WebElementProperties::setSelection(const QList<WebElementItem*> &elements)
+{
+    if (elements == m_elements) return;
+
+    // Pending edits belong to the previous selection
+    commitPendingChanges();
+
+    m_elements = elements;
     updateForm();
 }
 
+void WebElementProperties::removeElement(WebElementItem *item)
+{
+    if (!isEditing(item)) return;
+
+    // Pending edits cannot be committed while the scene is removing elements, they are dropped
+    m_pendingFields &= GlobalCssField;
+    m_elements.removeAll(item);
+    if (m_elements.isEmpty())
+        clear();
+    else
+        updateForm();
+}
+
 void WebElementProperties::clear()
 {
-    m_currentElement = nullptr;
+    // The element may already be gone, drop its pending edits but keep global CSS ones
+    m_pendingFields &= GlobalCssField;
+    m_elements.clear();
+    m_elementGroup->setTitle(tr("Element Properties"));
+
+    const QSignalBlocker typeBlocker(m_typeCombo);
+    const QSignalBlocker textBlocker(m_textEdit);
+    const QSignalBlocker styleBlocker(m_styleEdit);
     m_typeCombo->setCurrentIndex(0);
     m_idEdit->clear();
     m_classEdit->clear();
     m_textEdit->clear();
     m_styleEdit->clear();
+    m_hrefEdit->clear();
+    m_srcEdit->clear();
+    m_altEdit->clear();
+}
+
+void WebElementProperties::refresh()
+{
+    // Reload the form after the element was edited elsewhere, e.g. on the canvas
+    commitPendingChanges();
+    updateForm();
 }
 
 void WebElementProperties::updateForm()
 {
-    if (!m_currentElement) {
+    if (m_elements.isEmpty()) {
         m_typeCombo->setEnabled(false);
         m_idEdit->setEnabled(false);
         m_classEdit->setEnabled(false);
         m_textEdit->setEnabled(false);
         m_styleEdit->setEnabled(false);
+        m_hrefEdit->setEnabled(false);
+        m_srcEdit->setEnabled(false);
+        m_altEdit->setEnabled(false);
         return;
     }
-    
+
+    // IDs are unique, they are only edited one element at a time
+    const bool several = m_elements.size() > 1;
+    m_elementGroup->setTitle(several ? tr("%n Elements", nullptr, int(m_elements.size())) : tr("Element Properties"));
     m_typeCombo->setEnabled(true);
-    m_idEdit->setEnabled(true);
+    m_idEdit->setEnabled(!several);
     m_classEdit->setEnabled(true);
     m_textEdit->setEnabled(true);
     m_styleEdit->setEnabled(true);
-    
-    // Map element type to HTML tag
-    QString type = m_currentElement->elementType();
-    QString tag = "div";
-    if (type.startsWith("Heading")) tag = "h" + QString(type.back());
-    else if (type == "Text") tag = "p";
-    else if (type == "Button") tag = "button";
-    else if (type == "Image") tag = "img";
-    else if (type == "Link") tag = "a";
-    else if (type == "List") tag = "ul";
-    else if (type == "Input") tag = "input";
-    else if (type == "Textarea") tag = "textarea";
-    else if (type == "Form") tag = "form";
-    
-    m_typeCombo->setCurrentText(tag);
-    m_idEdit->setText(m_currentElement->elementId());
-    m_classEdit->setText(m_currentElement->elementClass());
-    m_textEdit->setPlainText(m_currentElement->elementText());
-    m_styleEdit->setPlainText(m_currentElement->elementStyle());
+
+    // The value all elements share, nothing when they differ
+    auto common = [this](auto value) -> std::optional<QString> {
+        const QString first = value(m_elements.constFirst());
+        for (const WebElementItem *element : std::as_const(m_elements)) {
+            if (value(element) != first)
+                return std::nullopt;
+        }
+        return first;
+    };
+    const auto tag = common([](const WebElementItem *e) { return WebHtmlWriter::tagForType(e->elementType()); });
+    const auto cls = common([](const WebElementItem *e) { return e->elementClass(); });
+    const auto text = common([](const WebElementItem *e) { return e->elementText(); });
+    const auto style = common([](const WebElementItem *e) { return e->elementStyle(); });
+
+    // Filling the form must not echo back into the element
+    const QSignalBlocker typeBlocker(m_typeCombo);
+    const QSignalBlocker textBlocker(m_textEdit);
+    const QSignalBlocker styleBlocker(m_styleEdit);
+
+    const QString mixed = tr("Multiple values");
+    if (tag)
+        m_typeCombo->setCurrentText(*tag);
+    else
+        m_typeCombo->setCurrentIndex(-1);
+    m_idEdit->setText(several ? QString() : m_elements.constFirst()->elementId());
+    m_classEdit->setText(cls.value_or(QString()));
+    m_classEdit->setPlaceholderText(cls ? QString() : mixed);
+    m_textEdit->setPlainText(text.value_or(QString()));
+    m_textEdit->setPlaceholderText(text ? QString() : mixed);
+    m_styleEdit->setPlainText(style.value_or(QString()));
+    m_styleEdit->setPlaceholderText(style ? QString() : mixed);
+
+    // An attribute is only editable when every selected element takes it
+    const std::pair<QLineEdit*, WebElementField> attributes[] = {
+        {m_hrefEdit, WebElementField::Href}, {m_srcEdit, WebElementField::Src}, {m_altEdit, WebElementField::Alt}
+    };
+    for (const auto &attribute : attributes) {
+        QLineEdit *edit = attribute.first;
+        const WebElementField field = attribute.second;
+        const bool takes = std::all_of(m_elements.cbegin(), m_elements.cend(), [field](const WebElementItem *e) {
+            return takesField(e->elementKind(), field);
+        });
+        const auto value = common([field](const WebElementItem *e) { return e->elementField(field); });
+        edit->setEnabled(takes);
+        edit->setText(takes ? value.value_or(QString()) : QString());
+        edit->setPlaceholderText(takes && !value ? mixed : QString());
+    }
 }
 
-void WebElementProperties::onPropertyChanged()
+void WebElementProperties::onIdEdited()
 {
-    if (!m_currentElement) return;
-    
-    m_currentElement->setId(m_idEdit->text());
-    m_currentElement->setClass(m_classEdit->text());
-    m_currentElement->setText(m_textEdit->toPlainText());
-    m_currentElement->setStyle(m_styleEdit->toPlainText());
-    
+    markPending(IdField);
+}
+
+void WebElementProperties::onClassEdited()
+{
+    markPending(ClassField);
+}
+
+void WebElementProperties::onTextChanged()
+{
+    markPending(TextField);
+}
+
+void WebElementProperties::onStyleChanged()
+{
+    markPending(StyleField);
+}
+
+void WebElementProperties::onAttributeEdited()
+{
+    const QObject *edit = sender();
+    markPending(edit == m_hrefEdit ? HrefField : edit == m_srcEdit ? SrcField : AltField);
+}
+
+void WebElementProperties::onGlobalCssChanged()
+{
+    markPending(GlobalCssField);
+}
+
+void WebElementProperties::markPending(PendingField field)
+{
+    m_pendingFields |= field;
+    m_commitTimer->start();
+}
+
+void WebElementProperties::commitPendingChanges()
+{
+    m_commitTimer->stop();
+    if (!m_pendingFields) return;
+
+    int fields = m_pendingFields;
+    m_pendingFields = 0;
+
+    if (!m_elements.isEmpty()) {
+        // Edits go through the scene so they are recorded, one undo step per commit
+        // however many elements are selected. Only edited fields are written.
+        WebDesignScene *scene = qobject_cast<WebDesignScene*>(m_elements.constFirst()->scene());
+        scene->undoStack()->beginMacro(tr("Edit Properties"));
+        if ((fields & IdField) && m_elements.size() == 1)
+            scene->setElementProperty(m_elements.constFirst(), WebElementField::Id, m_idEdit->text());
+        if (fields & ClassField)
+            scene->setElementsProperty(m_elements, WebElementField::Class, m_classEdit->text());
+        if (fields & TextField)
+            scene->setElementsProperty(m_elements, WebElementField::Text, m_textEdit->toPlainText());
+        if (fields & StyleField)
+            scene->setElementsProperty(m_elements, WebElementField::Style, m_styleEdit->toPlainText());
+        if (fields & HrefField)
+            scene->setElementsProperty(m_elements, WebElementField::Href, m_hrefEdit->text());
+        if (fields & SrcField)
+            scene->setElementsProperty(m_elements, WebElementField::Src, m_srcEdit->text());
+        if (fields & AltField)
+            scene->setElementsProperty(m_elements, WebElementField::Alt, m_altEdit->text());
+        scene->undoStack()->endMacro();
+    } else if (!(fields & GlobalCssField)) {
+        return;
+    }
+
     emit propertiesChanged();
 }
 
@@ -140,37 +312,6 @@ QString WebElementProperties::getGlobalCss() const
     return m_globalCssEdit->toPlainText();
 }
 
-QString WebElementProperties::generateHtml(const QJsonObject &element) const
-{
-    QString tag = element["type"].toString();
-    QString id = element["id"].toString();
-    QString cls = element["class"].toString();
-    QString text = element["text"].toString();
-    QString style = element["style"].toString();
-    
-    QString html = "<" + tag;
-    
-    if (!id.isEmpty()) html += " id=\"" + id + "\"";
-    if (!cls.isEmpty()) html += " class=\"" + cls + "\"";
-    if (!style.isEmpty()) html += " style=\"" + style + "\"";
-    
-    if (tag == "img") {
-        html += " src=\"placeholder.png\"";
-        html += " alt=\"" + text + "\"";
-        html += " />";
-    } else if (tag == "input") {
-        html += " type=\"text\"";
-        html += " value=\"" + text + "\"";
-        html += " />";
-    } else {
-        html += ">";
-        html += text;
-        html += "</" + tag + ">";
-    }
-    
-    return html;
-}
-
 void WebElementProperties::setGlobalProperties(const QJsonObject &props) {
     if (props.contains("global_css")) {
         m_globalCssEdit->setPlainText(props["global_css"].toString());
@@ -6,6 +6,8 @@
 #include <QGraphicsItem>
 
 class WebElementItem;
+class QGroupBox;
+class QTimer;
 class QLineEdit;
 class QComboBox;
 class QTextEdit;
@@ -18,30 +20,66 @@ public:
     explicit WebElementProperties(QWidget *parent = nullptr);
     void setGlobalProperties(const QJsonObject &props);
     void setCurrentElement(QGraphicsItem *item);
+    // Edits apply to every element of the selection. A field shows a value
+    // only when all elements agree on it.
+    void setSelection(const QList<WebElementItem*> &elements);
+    WebElementItem *currentElement() const { return m_elements.isEmpty() ? nullptr : m_elements.constFirst(); }
+    const QList<WebElementItem*> &selection() const { return m_elements; }
+    bool isEditing(const WebElementItem *item) const { return m_elements.contains(item); }
+    // Lets go of an element that is about to be deleted
+    void removeElement(WebElementItem *item);
     void clear();
 
     QJsonObject getGlobalProperties() const;
     QString getGlobalCss() const;
 
-    QString generateHtml(const QJsonObject &element) const;
+public slots:
+    void commitPendingChanges();
+    void refresh();
 
     signals:
         void propertiesChanged();
 
 private slots:
-    void onPropertyChanged();
+    void onIdEdited();
+    void onClassEdited();
+    void onTextChanged();
+    void onStyleChanged();
+    void onAttributeEdited();
+    void onGlobalCssChanged();
 
 private:
+    enum PendingField {
+        IdField = 0x1,
+        ClassField = 0x2,
+        TextField = 0x4,
+        StyleField = 0x8,
+        GlobalCssField = 0x10,
+        HrefField = 0x20,
+        SrcField = 0x40,
+        AltField = 0x80
+    };
+
+    // Edits arriving within this window are folded into a single commit
+    static constexpr int CommitDelayMs = 150;
+
     void setupUi();
     void updateForm();
+    void markPending(PendingField field);
 
-    WebElementItem *m_currentElement;
+    QList<WebElementItem*> m_elements;
+    int m_pendingFields;
+    QTimer *m_commitTimer;
 
+    QGroupBox *m_elementGroup;
     QComboBox *m_typeCombo;
     QLineEdit *m_idEdit;
     QLineEdit *m_classEdit;
     QTextEdit *m_textEdit;
     QTextEdit *m_styleEdit;
+    QLineEdit *m_hrefEdit;
+    QLineEdit *m_srcEdit;
+    QLineEdit *m_altEdit;
     QTextEdit *m_globalCssEdit;
 };
 
@@ -0,0 +1,40 @@
+#include "WebElementTree.h"
+
+WebElementTree::WebElementTree(const QList<WebElementData> &elements)
+    : m_parent(elements.size(), -1), m_firstChild(elements.size(), -1),
+      m_nextSibling(elements.size(), -1), m_firstRoot(-1)
+{
+    const qsizetype count = elements.size();
+    for (qsizetype i = 0; i < count; ++i) {
+        const qint32 parent = elements.at(i).parent;
+        if (parent >= 0 && parent < count && parent != i)
+            m_parent[i] = parent;
+    }
+
+    // A damaged file can make an element its own ancestor, the element that
+    // closes such a loop becomes top level. Every element is passed once.
+    enum : quint8 { Unvisited, OnPath, Done };
+    QList<quint8> state(count, Unvisited);
+    for (qsizetype i = 0; i < count; ++i) {
+        qsizetype node = i;
+        qsizetype last = -1;
+        while (node >= 0 && state.at(node) == Unvisited) {
+            state[node] = OnPath;
+            last = node;
+            node = m_parent.at(node);
+        }
+        if (node >= 0 && state.at(node) == OnPath)
+            m_parent[last] = -1;
+
+        for (node = i; node >= 0 && state.at(node) == OnPath; node = m_parent.at(node))
+            state[node] = Done;
+    }
+
+    // Linking back to front leaves every sibling list in index order
+    for (qsizetype i = count - 1; i >= 0; --i) {
+        const qsizetype parent = m_parent.at(i);
+        qsizetype &head = parent >= 0 ? m_firstChild[parent] : m_firstRoot;
+        m_nextSibling[i] = head;
+        head = i;
+    }
+}
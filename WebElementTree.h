@@ -0,0 +1,57 @@
+#ifndef WEBELEMENTTREE_H
+#define WEBELEMENTTREE_H
+
+#include "WebElementData.h"
+#include <QList>
+
+// Parent/child structure of a flat element list. Elements name their parent
+// by index; the tree turns that into first-child/next-sibling links once, so
+// a whole design is walked in document order in O(n) time with a stack no
+// deeper than the nesting. Siblings keep their order in the list.
+class WebElementTree
+{
+public:
+    explicit WebElementTree(const QList<WebElementData> &elements);
+
+    qsizetype size() const { return m_parent.size(); }
+    // Validated parent, -1 for top level elements and for broken references
+    qsizetype parentOf(qsizetype index) const { return m_parent.at(index); }
+    bool hasChildren(qsizetype index) const { return m_firstChild.at(index) >= 0; }
+
+    // Calls enter(index, hasChildren) for every element in document order,
+    // and leave(index) after the last descendant of every element with children
+    template<typename Enter, typename Leave>
+    void walk(Enter enter, Leave leave) const;
+
+private:
+    QList<qsizetype> m_parent;
+    QList<qsizetype> m_firstChild;
+    QList<qsizetype> m_nextSibling;
+    qsizetype m_firstRoot;
+};
+
+template<typename Enter, typename Leave>
+void WebElementTree::walk(Enter enter, Leave leave) const
+{
+    // Open ancestors of the current element, innermost last
+    QList<qsizetype> open;
+    qsizetype node = m_firstRoot;
+    while (node >= 0) {
+        const bool children = m_firstChild.at(node) >= 0;
+        enter(node, children);
+        if (children) {
+            open.append(node);
+            node = m_firstChild.at(node);
+            continue;
+        }
+
+        node = m_nextSibling.at(node);
+        while (node < 0 && !open.isEmpty()) {
+            const qsizetype parent = open.takeLast();
+            leave(parent);
+            node = m_nextSibling.at(parent);
+        }
+    }
+}
+
+#endif // WEBELEMENTTREE_H
@@ -0,0 +1,63 @@
+#include "WebElementType.h"
+#include <iterator>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr quint32 rgb(quint32 red, quint32 green, quint32 blue)
+{
+    return 0xff000000u | (red << 16) | (green << 8) | blue;
+}
+
+constexpr quint32 kContainerColor = rgb(230, 230, 250);
+constexpr quint32 kHeadingColor = rgb(255, 200, 200);
+constexpr quint32 kTextColor = rgb(200, 230, 255);
+constexpr quint32 kDefaultColor = rgb(240, 240, 240);
+
+constexpr QSizeF kBlockSize(300, 200);
+constexpr QSizeF kHeadingSize(400, 60);
+constexpr QSizeF kTextSize(400, 100);
+constexpr QSizeF kDefaultSize(200, 80);
+
+// Indexed by WebElementKind
+const WebElementTypeInfo kTypeInfo[] = {
+    {"Container"_L1, "div"_L1, kContainerColor, kBlockSize, true},
+    {"Text"_L1, "p"_L1, kTextColor, kTextSize, false},
+    {"Paragraph"_L1, "p"_L1, kTextColor, kTextSize, false},
+    {"Heading 1"_L1, "h1"_L1, kHeadingColor, kHeadingSize, false},
+    {"Heading 2"_L1, "h2"_L1, kHeadingColor, kHeadingSize, false},
+    {"Heading 3"_L1, "h3"_L1, kHeadingColor, kHeadingSize, false},
+    {"Heading 4"_L1, "h4"_L1, kHeadingColor, kHeadingSize, false},
+    {"Heading 5"_L1, "h5"_L1, kHeadingColor, kHeadingSize, false},
+    {"Heading 6"_L1, "h6"_L1, kHeadingColor, kHeadingSize, false},
+    {"Image"_L1, "img"_L1, rgb(255, 255, 200), QSizeF(200, 150), false},
+    {"Button"_L1, "button"_L1, rgb(200, 255, 200), QSizeF(120, 40), false},
+    {"Link"_L1, "a"_L1, kDefaultColor, kDefaultSize, false},
+    {"List"_L1, "ul"_L1, kDefaultColor, kDefaultSize, false},
+    {"Input"_L1, "input"_L1, kDefaultColor, kDefaultSize, false},
+    {"Textarea"_L1, "textarea"_L1, kDefaultColor, kDefaultSize, false},
+    {"Form"_L1, "form"_L1, rgb(220, 220, 220), kDefaultSize, true},
+    {"Section"_L1, "section"_L1, rgb(230, 250, 230), kBlockSize, true},
+    {"Article"_L1, "article"_L1, rgb(250, 230, 230), kBlockSize, true},
+    {"Footer"_L1, "footer"_L1, kDefaultColor, kDefaultSize, false},
+    {"Navigation"_L1, "nav"_L1, kDefaultColor, kDefaultSize, false},
+    {QLatin1StringView(), "div"_L1, kDefaultColor, kDefaultSize, false},
+};
+
+static_assert(std::size(kTypeInfo) == size_t(WebElementKind::Unknown) + 1,
+              "kTypeInfo must have one entry per WebElementKind");
+}
+
+WebElementKind WebElementTypeInfo::kindOf(QStringView type)
+{
+    for (size_t i = 0; i < size_t(WebElementKind::Unknown); ++i) {
+        if (type == kTypeInfo[i].name)
+            return WebElementKind(i);
+    }
+    return WebElementKind::Unknown;
+}
+
+const WebElementTypeInfo &WebElementTypeInfo::of(WebElementKind kind)
+{
+    return kTypeInfo[size_t(kind)];
+}
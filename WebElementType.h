@@ -0,0 +1,46 @@
+#ifndef WEBELEMENTTYPE_H
+#define WEBELEMENTTYPE_H
+
+#include <QSizeF>
+#include <QString>
+
+enum class WebElementKind : quint8 {
+    Container,
+    Text,
+    Paragraph,
+    Heading1,
+    Heading2,
+    Heading3,
+    Heading4,
+    Heading5,
+    Heading6,
+    Image,
+    Button,
+    Link,
+    List,
+    Input,
+    Textarea,
+    Form,
+    Section,
+    Article,
+    Footer,
+    Navigation,
+    Unknown
+};
+
+// Static description of an element type, looked up once per element instead
+// of comparing type names on every paint or export. Part of the core library,
+// so it only depends on QtCore.
+struct WebElementTypeInfo
+{
+    QLatin1StringView name;
+    QLatin1StringView tag;
+    quint32 color; // 0xAARRGGBB, the same layout as QRgb
+    QSizeF defaultSize;
+    bool container; // can hold child elements
+
+    static WebElementKind kindOf(QStringView type);
+    static const WebElementTypeInfo &of(WebElementKind kind);
+};
+
+#endif // WEBELEMENTTYPE_H
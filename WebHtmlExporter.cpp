@@ -0,0 +1,172 @@
+#include "WebHtmlExporter.h"
+#include "WebComponent.h"
+#include "WebElementTree.h"
+#include "WebProject.h"
+#include <QDir>
+#include <QFileInfo>
+#include <cstring>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr auto kHeadOpen = "<!DOCTYPE html>\n<html>\n<head>\n<title>Generated Page</title>\n"
+                           "<style>\n"
+                           "body { font-family: Arial, sans-serif; margin: 20px; }\n"_L1;
+constexpr auto kHeadClose = "\n</style>\n</head>\n<body>\n"_L1;
+constexpr auto kFooter = "\n</body>\n</html>"_L1;
+}
+
+WebHtmlExporter::WebHtmlExporter(const QString &fileName, qsizetype bufferSize)
+    : m_file(fileName), m_buffer(bufferSize, Qt::Uninitialized), m_used(0),
+      m_encoder(QStringEncoder::Utf8)
+{
+}
+
+bool WebHtmlExporter::begin(const QString &globalCss)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    write(kHeadOpen);
+    write(globalCss);
+    write(kHeadClose);
+    return true;
+}
+
+void WebHtmlExporter::writeElement(const WebElementData &element)
+{
+    m_writer.clear();
+    m_writer.writeElement(element);
+    write(m_writer.html());
+    write("\n"_L1);
+}
+
+void WebHtmlExporter::writeElements(const QList<WebElementData> &elements)
+{
+    // One walk over the tree, end tags are written once the last descendant is out
+    const WebElementTree tree(elements);
+    tree.walk([&](qsizetype index, bool hasChildren) {
+        m_writer.clear();
+        if (hasChildren)
+            m_writer.writeStartTag(elements.at(index));
+        else
+            m_writer.writeElement(elements.at(index));
+        write(m_writer.html());
+        write("\n"_L1);
+    }, [&](qsizetype index) {
+        m_writer.clear();
+        m_writer.writeEndTag(elements.at(index).type);
+        write(m_writer.html());
+        write("\n"_L1);
+    });
+}
+
+bool WebHtmlExporter::finish()
+{
+    write(kFooter);
+
+    if (!flush()) {
+        m_file.cancelWriting();
+        return false;
+    }
+    if (!m_file.commit()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString WebHtmlExporter::documentHeader(const QString &globalCss)
+{
+    QString header;
+    header.reserve(kHeadOpen.size() + globalCss.size() + kHeadClose.size());
+    header += kHeadOpen;
+    header += globalCss;
+    header += kHeadClose;
+    return header;
+}
+
+QString WebHtmlExporter::documentFooter()
+{
+    return QString(kFooter);
+}
+
+QString WebHtmlExporter::siteDirectory(const QString &htmlFile)
+{
+    const QFileInfo info(htmlFile);
+    return info.dir().filePath(info.completeBaseName());
+}
+
+bool WebHtmlExporter::exportDesign(const QString &designFile, const QString &htmlFile, QString *errorString)
+{
+    // Projects of several pages are saved in their own formats, WebProject reads all of them
+    WebProject project;
+    if (!WebProject::read(designFile, &project, nullptr, errorString))
+        return false;
+
+    // One thread, the batch converter already runs an export per core
+    if (project.pageCount() > 1)
+        return project.exportSite(siteDirectory(htmlFile), errorString, 1);
+
+    QString error;
+    const QList<WebElementData> elements = project.elements(0, &error);
+    if (!error.isEmpty()) {
+        if (errorString) *errorString = error;
+        return false;
+    }
+
+    // Instances take the fields they do not override from the components saved with the design
+    const WebComponentLibrary &components = project.components();
+
+    WebHtmlExporter exporter(htmlFile);
+    if (!exporter.begin(project.properties().value("global_css").toString() + components.styleSheet())) {
+        if (errorString) *errorString = exporter.errorString();
+        return false;
+    }
+
+    exporter.writeElements(components.exportElements(elements));
+
+    if (!exporter.finish()) {
+        if (errorString) *errorString = exporter.errorString();
+        return false;
+    }
+    return true;
+}
+
+void WebHtmlExporter::write(QStringView text)
+{
+    qsizetype required = m_encoder.requiredSpace(text.size());
+    if (m_used + required > m_buffer.size()) {
+        flush();
+        if (required > m_buffer.size())
+            m_buffer.resize(required);
+    }
+
+    char *end = m_encoder.appendToBuffer(m_buffer.data() + m_used, text);
+    m_used = end - m_buffer.constData();
+}
+
+void WebHtmlExporter::write(QLatin1StringView text)
+{
+    // Markup literals are plain ASCII, which is already valid UTF-8
+    if (m_used + text.size() > m_buffer.size()) {
+        flush();
+        if (text.size() > m_buffer.size())
+            m_buffer.resize(text.size());
+    }
+
+    std::memcpy(m_buffer.data() + m_used, text.data(), text.size());
+    m_used += text.size();
+}
+
+bool WebHtmlExporter::flush()
+{
+    if (m_used == 0) return m_error.isEmpty();
+
+    if (m_file.write(m_buffer.constData(), m_used) != m_used && m_error.isEmpty())
+        m_error = m_file.errorString();
+    m_used = 0;
+    return m_error.isEmpty();
+}
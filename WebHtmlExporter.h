@@ -0,0 +1,51 @@
+#ifndef WEBHTMLEXPORTER_H
+#define WEBHTMLEXPORTER_H
+
+#include "WebHtmlWriter.h"
+#include <QByteArray>
+#include <QList>
+#include <QSaveFile>
+#include <QString>
+#include <QStringEncoder>
+
+struct WebElementData;
+
+// Streams a generated page to disk. Text is encoded to UTF-8 straight into a
+// fixed-size buffer that is flushed to a QSaveFile, so the whole document is
+// never held in memory, and the target file is only replaced on success.
+class WebHtmlExporter
+{
+public:
+    explicit WebHtmlExporter(const QString &fileName, qsizetype bufferSize = 64 * 1024);
+
+    bool begin(const QString &globalCss);
+    void writeElement(const WebElementData &element);
+    // Writes a whole design, nesting children inside their containers
+    void writeElements(const QList<WebElementData> &elements);
+    bool finish();
+
+    QString errorString() const { return m_error; }
+
+    static QString documentHeader(const QString &globalCss);
+    static QString documentFooter();
+
+    // Headless conversion of a saved design, used by the --export command line mode.
+    // A project of several pages is exported as a site into siteDirectory(htmlFile).
+    static bool exportDesign(const QString &designFile, const QString &htmlFile, QString *errorString = nullptr);
+    // The HTML file name without its suffix, "out/home.html" becomes "out/home"
+    static QString siteDirectory(const QString &htmlFile);
+
+private:
+    void write(QStringView text);
+    void write(QLatin1StringView text);
+    bool flush();
+
+    QSaveFile m_file;
+    QByteArray m_buffer;
+    qsizetype m_used;
+    QStringEncoder m_encoder;
+    WebHtmlWriter m_writer;
+    QString m_error;
+};
+
+#endif // WEBHTMLEXPORTER_H
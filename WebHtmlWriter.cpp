@@ -0,0 +1,142 @@
+#include "WebHtmlWriter.h"
+#include "WebElementData.h"
+#include "WebElementType.h"
+#include <utility>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// Room for the tag twice plus the fixed attribute names and quotes
+constexpr qsizetype kMarkupOverhead = 64;
+// Name, equals sign and quotes of an attribute beyond the fixed ones
+constexpr qsizetype kAttributeOverhead = 8;
+}
+
+WebHtmlWriter::WebHtmlWriter(qsizetype capacity)
+{
+    m_buffer.reserve(capacity);
+}
+
+void WebHtmlWriter::writeElement(const WebElementData &element)
+{
+    ensureCapacity(estimateSize(element));
+
+    QLatin1StringView tag = writeOpenTag(element);
+    if (tag == "img"_L1) {
+        // Images without a source or alternative text of their own get the defaults
+        if (element.value(WebElementField::Src).isEmpty())
+            m_buffer += " src=\"placeholder.png\""_L1;
+        if (element.value(WebElementField::Alt).isEmpty())
+            writeAttribute("alt"_L1, element.text);
+        m_buffer += " />"_L1;
+    } else if (tag == "input"_L1) {
+        m_buffer += " type=\"text\""_L1;
+        writeAttribute("value"_L1, element.text);
+        m_buffer += " />"_L1;
+    } else {
+        m_buffer += u'>';
+        m_buffer += element.text;
+        m_buffer += "</"_L1;
+        m_buffer += tag;
+        m_buffer += u'>';
+    }
+}
+
+void WebHtmlWriter::writeStartTag(const WebElementData &element)
+{
+    ensureCapacity(estimateSize(element));
+
+    writeOpenTag(element);
+    m_buffer += u'>';
+    m_buffer += element.text;
+}
+
+void WebHtmlWriter::writeEndTag(QStringView type)
+{
+    QLatin1StringView tag = tagForType(type);
+    ensureCapacity(tag.size() + 3);
+
+    m_buffer += "</"_L1;
+    m_buffer += tag;
+    m_buffer += u'>';
+}
+
+QString WebHtmlWriter::elementHtml(const WebElementData &element)
+{
+    WebHtmlWriter writer(estimateSize(element));
+    writer.writeElement(element);
+    return writer.takeHtml();
+}
+
+QString WebHtmlWriter::takeHtml()
+{
+    QString html = std::move(m_buffer);
+    m_buffer = QString();
+    return html;
+}
+
+QLatin1StringView WebHtmlWriter::tagForType(QStringView type)
+{
+    return WebElementTypeInfo::of(WebElementTypeInfo::kindOf(type)).tag;
+}
+
+qsizetype WebHtmlWriter::estimateSize(const WebElementData &element)
+{
+    qsizetype size = kMarkupOverhead + element.id.size() + element.cls.size()
+                     + element.style.size() + element.text.size();
+    for (const WebAttribute &attribute : element.attributes)
+        size += kAttributeOverhead + attribute.value.size();
+    return size;
+}
+
+void WebHtmlWriter::appendEscaped(QString &out, QStringView value)
+{
+    // Copy runs of safe characters and substitute entities in the same pass
+    qsizetype runStart = 0;
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        QLatin1StringView entity;
+        switch (value[i].unicode()) {
+        case u'&': entity = "&amp;"_L1; break;
+        case u'<': entity = "&lt;"_L1; break;
+        case u'>': entity = "&gt;"_L1; break;
+        case u'"': entity = "&quot;"_L1; break;
+        default: continue;
+        }
+        out += value.sliced(runStart, i - runStart);
+        out += entity;
+        runStart = i + 1;
+    }
+    out += value.sliced(runStart);
+}
+
+QLatin1StringView WebHtmlWriter::writeOpenTag(const WebElementData &element)
+{
+    // Tag and attributes without the closing bracket, void elements add their own attributes
+    QLatin1StringView tag = tagForType(element.type);
+    m_buffer += u'<';
+    m_buffer += tag;
+
+    if (!element.id.isEmpty()) writeAttribute("id"_L1, element.id);
+    if (!element.cls.isEmpty()) writeAttribute("class"_L1, element.cls);
+    if (!element.style.isEmpty()) writeAttribute("style"_L1, element.style);
+    for (const WebAttribute &attribute : element.attributes)
+        writeAttribute(webElementFieldName(attribute.field), attribute.value);
+    return tag;
+}
+
+void WebHtmlWriter::writeAttribute(QLatin1StringView name, QStringView value)
+{
+    m_buffer += u' ';
+    m_buffer += name;
+    m_buffer += "=\""_L1;
+    appendEscaped(m_buffer, value);
+    m_buffer += u'"';
+}
+
+void WebHtmlWriter::ensureCapacity(qsizetype extra)
+{
+    // Grow geometrically, reserving the exact size per element would reallocate every time
+    qsizetype required = m_buffer.size() + extra;
+    if (required > m_buffer.capacity())
+        m_buffer.reserve(qMax(required, m_buffer.capacity() * 2));
+}
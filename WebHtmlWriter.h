@@ -0,0 +1,40 @@
+#ifndef WEBHTMLWRITER_H
+#define WEBHTMLWRITER_H
+
+#include <QString>
+#include <QStringView>
+
+struct WebElementData;
+
+// Builds element markup into one reusable buffer. Tag names and attribute
+// names are Latin-1 literals and attribute values are escaped while they are
+// copied, so writing an element costs no temporary strings.
+class WebHtmlWriter
+{
+public:
+    explicit WebHtmlWriter(qsizetype capacity = 1024);
+
+    void writeElement(const WebElementData &element);
+    // An element with children is written in two parts around them
+    void writeStartTag(const WebElementData &element);
+    void writeEndTag(QStringView type);
+
+    const QString &html() const { return m_buffer; }
+    QString takeHtml();
+    void clear() { m_buffer.resize(0); }
+
+    // Markup of a single element, for callers that do not reuse a writer
+    static QString elementHtml(const WebElementData &element);
+    static QLatin1StringView tagForType(QStringView type);
+    static qsizetype estimateSize(const WebElementData &element);
+    static void appendEscaped(QString &out, QStringView value);
+
+private:
+    QLatin1StringView writeOpenTag(const WebElementData &element);
+    void writeAttribute(QLatin1StringView name, QStringView value);
+    void ensureCapacity(qsizetype extra);
+
+    QString m_buffer;
+};
+
+#endif // WEBHTMLWRITER_H
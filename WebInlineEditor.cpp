@@ -0,0 +1,75 @@
+#include "WebInlineEditor.h"
+#include "WebElementItem.h"
+#include "WebDesignScene.h"
+#include "WebDesignCommands.h"
+#include <QKeyEvent>
+#include <QPainter>
+#include <QTextCursor>
+
+WebInlineEditor::WebInlineEditor(QGraphicsItem *parent)
+    : QGraphicsTextItem(parent), m_target(nullptr)
+{
+    setTextInteractionFlags(Qt::TextEditorInteraction);
+    setZValue(1);
+    hide();
+}
+
+void WebInlineEditor::attach(WebElementItem *target)
+{
+    if (m_target) finish(true);
+
+    m_target = target;
+    setPos(target->scenePos() + WebElementItem::labelOffset());
+    setTextWidth(qMax<qreal>(target->rect().width() - 2 * WebElementItem::labelOffset().x(), 20));
+    setPlainText(target->elementText());
+    show();
+    setFocus(Qt::MouseFocusReason);
+
+    QTextCursor cursor = textCursor();
+    cursor.select(QTextCursor::Document);
+    setTextCursor(cursor);
+}
+
+void WebInlineEditor::finish(bool accept)
+{
+    WebElementItem *target = m_target;
+    if (!target) return;
+
+    // Clear first, hiding the editor drops focus and would finish again
+    m_target = nullptr;
+    hide();
+
+    if (accept) {
+        if (WebDesignScene *designScene = qobject_cast<WebDesignScene*>(scene()))
+            designScene->setElementProperty(target, WebElementField::Text, toPlainText());
+        emit textCommitted(target);
+    }
+    setPlainText(QString());
+}
+
+void WebInlineEditor::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    // Cover the element's own label while it is being edited
+    painter->fillRect(boundingRect(), Qt::white);
+    QGraphicsTextItem::paint(painter, option, widget);
+}
+
+void WebInlineEditor::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape) {
+        finish(false);
+        return;
+    }
+    if ((event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter)
+        && event->modifiers().testFlag(Qt::ControlModifier)) {
+        finish(true);
+        return;
+    }
+    QGraphicsTextItem::keyPressEvent(event);
+}
+
+void WebInlineEditor::focusOutEvent(QFocusEvent *event)
+{
+    QGraphicsTextItem::focusOutEvent(event);
+    finish(true);
+}
@@ -0,0 +1,34 @@
+#ifndef WEBINLINEEDITOR_H
+#define WEBINLINEEDITOR_H
+
+#include <QGraphicsTextItem>
+
+class WebElementItem;
+
+// The one text editor of a scene. It is attached on top of the element being
+// edited and detached again when editing ends, so elements themselves only
+// carry their text as a string.
+class WebInlineEditor : public QGraphicsTextItem
+{
+    Q_OBJECT
+
+public:
+    explicit WebInlineEditor(QGraphicsItem *parent = nullptr);
+
+    WebElementItem *target() const { return m_target; }
+    void attach(WebElementItem *target);
+    void finish(bool accept);
+
+    signals:
+        void textCommitted(WebElementItem *target);
+
+protected:
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void focusOutEvent(QFocusEvent *event) override;
+
+private:
+    WebElementItem *m_target;
+};
+
+#endif // WEBINLINEEDITOR_H
@@ -0,0 +1,35 @@
+#include "WebOffsetTree.h"
+
+void WebOffsetTree::assign(const QList<qsizetype> &lengths)
+{
+    m_tree = lengths;
+    const qsizetype count = m_tree.size();
+    for (qsizetype node = 1; node <= count; ++node) {
+        qsizetype parent = node + (node & -node);
+        if (parent <= count)
+            m_tree[parent - 1] += m_tree[node - 1];
+    }
+}
+
+void WebOffsetTree::append(qsizetype length)
+{
+    // The new node covers a range that ends in it, the rest of the range is already summed
+    const qsizetype node = m_tree.size() + 1;
+    m_tree.append(length + offset(node - 1) - offset(node - (node & -node)));
+}
+
+void WebOffsetTree::add(qsizetype index, qsizetype delta)
+{
+    if (delta == 0) return;
+
+    for (qsizetype node = index + 1; node <= m_tree.size(); node += node & -node)
+        m_tree[node - 1] += delta;
+}
+
+qsizetype WebOffsetTree::offset(qsizetype index) const
+{
+    qsizetype sum = 0;
+    for (qsizetype node = index; node > 0; node -= node & -node)
+        sum += m_tree.at(node - 1);
+    return sum;
+}
@@ -0,0 +1,27 @@
+#ifndef WEBOFFSETTREE_H
+#define WEBOFFSETTREE_H
+
+#include <QList>
+#include <QtGlobal>
+
+// Fenwick tree over a list of lengths, such as the fragments of the HTML
+// preview. The offset an entry starts at and a change to one length both
+// cost O(log n), where a plain list of offsets would shift every later one.
+class WebOffsetTree
+{
+public:
+    qsizetype size() const { return m_tree.size(); }
+    void clear() { m_tree.clear(); }
+
+    // Replaces everything, built in linear time
+    void assign(const QList<qsizetype> &lengths);
+    void append(qsizetype length);
+    void add(qsizetype index, qsizetype delta);
+    // Sum of the lengths before index, index may be size()
+    qsizetype offset(qsizetype index) const;
+
+private:
+    QList<qsizetype> m_tree;
+};
+
+#endif // WEBOFFSETTREE_H
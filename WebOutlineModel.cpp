@@ -0,0 +1,330 @@
+#include "WebOutlineModel.h"
+#include "WebDesignScene.h"
+#include "WebElementData.h"
+#include "WebElementItem.h"
+#include "WebProfiler.h"
+#include <algorithm>
+#include <utility>
+
+using namespace Qt::StringLiterals;
+
+WebOutlineModel::WebOutlineModel(WebDesignScene *scene, QObject *parent)
+    : QAbstractItemModel(parent), m_scene(scene)
+{
+    connectScene();
+}
+
+WebOutlineModel::~WebOutlineModel()
+{
+    qDeleteAll(m_nodes);
+}
+
+void WebOutlineModel::setScene(WebDesignScene *scene)
+{
+    if (scene == m_scene) return;
+
+    disconnect(m_scene, nullptr, this, nullptr);
+    m_scene = scene;
+    connectScene();
+    reset();
+}
+
+void WebOutlineModel::connectScene()
+{
+    connect(m_scene, &WebDesignScene::elementAdded, this, &WebOutlineModel::onElementAdded);
+    connect(m_scene, &WebDesignScene::elementRemoved, this, &WebOutlineModel::onElementRemoved);
+    connect(m_scene, &WebDesignScene::elementChanged, this, &WebOutlineModel::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementTextEdited, this, &WebOutlineModel::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementParentChanged, this, &WebOutlineModel::onElementParentChanged);
+    connect(m_scene, &WebDesignScene::elementMaterialized, this, &WebOutlineModel::onElementMaterialized);
+    // Loads add elements with signals blocked, the tree is collected again
+    connect(m_scene, &WebDesignScene::sceneCleared, this, &WebOutlineModel::reset);
+    connect(m_scene, &WebDesignScene::sceneLoaded, this, &WebOutlineModel::reset);
+}
+
+void WebOutlineModel::reset()
+{
+    beginResetModel();
+    qDeleteAll(m_nodes);
+    m_nodes.clear();
+    m_root.children.clear();
+    m_root.populated = false;
+    m_root.fetched = 0;
+    endResetModel();
+}
+
+WebOutlineModel::Node *WebOutlineModel::nodeOf(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<Node*>(index.internalPointer()) : &m_root;
+}
+
+QModelIndex WebOutlineModel::indexOfNode(Node *node) const
+{
+    return node == &m_root ? QModelIndex() : createIndex(node->row, 0, node);
+}
+
+qsizetype WebOutlineModel::slotOf(const Node *node) const
+{
+    return m_scene->slotOfKey(node->key);
+}
+
+void WebOutlineModel::populate(Node *node) const
+{
+    if (node->populated) return;
+    const WebProfileScope scope("outline/populate");
+    node->populated = true;
+
+    // Top level: every slot without a parent, pending records included
+    QList<quintptr> keys;
+    if (node == &m_root) {
+        for (qsizetype slot = 0; slot < m_scene->elementCount(); ++slot) {
+            const WebElementItem *item = m_scene->elementAt(slot);
+            if (!item || !item->parentElement())
+                keys.append(m_scene->elementKey(slot));
+        }
+    } else {
+        const WebElementItem *item = m_scene->elementAt(slotOf(node));
+        QList<std::pair<qsizetype, quintptr>> bySlot;
+        const QList<QGraphicsItem*> children = item ? item->childItems() : QList<QGraphicsItem*>();
+        for (QGraphicsItem *child : children) {
+            const WebElementItem *element = dynamic_cast<WebElementItem*>(child);
+            const qsizetype slot = element ? m_scene->slotOf(element) : -1;
+            if (slot >= 0)
+                bySlot.append({slot, quintptr(element)});
+        }
+        std::sort(bySlot.begin(), bySlot.end());
+        for (const auto &entry : std::as_const(bySlot))
+            keys.append(entry.second);
+    }
+
+    node->children.reserve(keys.size());
+    for (quintptr key : std::as_const(keys)) {
+        Node *child = new Node;
+        child->key = key;
+        child->parent = node;
+        child->row = int(node->children.size());
+        node->children.append(child);
+        m_nodes.insert(key, child);
+    }
+}
+
+QModelIndex WebOutlineModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const Node *node = nodeOf(parent);
+    if (column != 0 || row < 0 || row >= node->fetched)
+        return QModelIndex();
+    return createIndex(row, column, node->children.at(row));
+}
+
+QModelIndex WebOutlineModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) return QModelIndex();
+    return indexOfNode(nodeOf(child)->parent);
+}
+
+int WebOutlineModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return 0;
+    return nodeOf(parent)->fetched;
+}
+
+int WebOutlineModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return 1;
+}
+
+bool WebOutlineModel::hasChildren(const QModelIndex &parent) const
+{
+    // Answered without collecting the children, the view asks for every visible row
+    const Node *node = nodeOf(parent);
+    if (node == &m_root)
+        return m_scene->elementCount() > 0;
+    if (node->populated)
+        return !node->children.isEmpty();
+    const WebElementItem *item = m_scene->elementAt(slotOf(node));
+    return item && item->hasChildElements();
+}
+
+QVariant WebOutlineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::ToolTipRole))
+        return QVariant();
+
+    const qsizetype slot = slotOf(nodeOf(index));
+    if (slot < 0) return QVariant();
+    const WebElementData element = m_scene->elementDataAt(slot);
+    if (role == Qt::ToolTipRole)
+        return element.text;
+
+    // "Button #signup  Sign up", the text shortened to one line
+    QString label = element.type;
+    if (!element.id.isEmpty())
+        label += u" #"_s + element.id;
+    QString text = element.text.simplified();
+    if (!text.isEmpty()) {
+        if (text.size() > LabelTextLength)
+            text = text.first(LabelTextLength) + QChar(0x2026);
+        label += u"  "_s + text;
+    }
+    return label;
+}
+
+bool WebOutlineModel::canFetchMore(const QModelIndex &parent) const
+{
+    Node *node = nodeOf(parent);
+    populate(node);
+    return node->fetched < node->children.size();
+}
+
+void WebOutlineModel::fetchMore(const QModelIndex &parent)
+{
+    Node *node = nodeOf(parent);
+    populate(node);
+    fetchUpTo(node, qMin<int>(node->fetched + FetchBatch, int(node->children.size())) - 1);
+}
+
+void WebOutlineModel::fetchUpTo(Node *node, int row)
+{
+    if (row < node->fetched) return;
+    beginInsertRows(indexOfNode(node), node->fetched, row);
+    node->fetched = row + 1;
+    endInsertRows();
+}
+
+QModelIndex WebOutlineModel::indexOf(WebElementItem *item)
+{
+    if (!item || m_scene->slotOf(item) < 0) return QModelIndex();
+
+    QList<WebElementItem*> ancestors;
+    for (WebElementItem *element = item; element; element = element->parentElement())
+        ancestors.prepend(element);
+
+    // Every level is collected and fetched down to the element's row
+    Node *parent = &m_root;
+    for (WebElementItem *element : std::as_const(ancestors)) {
+        populate(parent);
+        Node *node = m_nodes.value(quintptr(element));
+        if (!node) return QModelIndex();
+        fetchUpTo(parent, node->row);
+        parent = node;
+    }
+    return indexOfNode(parent);
+}
+
+WebElementItem *WebOutlineModel::elementAt(const QModelIndex &index)
+{
+    if (!index.isValid()) return nullptr;
+    const qsizetype slot = slotOf(nodeOf(index));
+    return slot < 0 ? nullptr : m_scene->materializeElement(slot);
+}
+
+void WebOutlineModel::insertNode(Node *parent, Node *node)
+{
+    // Children are in document order, a new element usually goes last
+    const qsizetype slot = slotOf(node);
+    auto it = std::upper_bound(parent->children.cbegin(), parent->children.cend(), slot,
+                               [this](qsizetype value, const Node *child) { return value < slotOf(child); });
+    const int row = int(it - parent->children.cbegin());
+
+    // Rows beyond what the view fetched are handed out later, unless everything was fetched
+    const bool shown = row < parent->fetched || parent->fetched == parent->children.size();
+    if (shown)
+        beginInsertRows(indexOfNode(parent), row, row);
+    node->parent = parent;
+    parent->children.insert(row, node);
+    for (qsizetype i = row; i < parent->children.size(); ++i)
+        parent->children.at(i)->row = int(i);
+    m_nodes.insert(node->key, node);
+    if (shown) {
+        ++parent->fetched;
+        endInsertRows();
+    }
+}
+
+void WebOutlineModel::takeNode(Node *node)
+{
+    Node *parent = node->parent;
+    const int row = node->row;
+    const bool shown = row < parent->fetched;
+    if (shown)
+        beginRemoveRows(indexOfNode(parent), row, row);
+    parent->children.removeAt(row);
+    for (qsizetype i = row; i < parent->children.size(); ++i)
+        parent->children.at(i)->row = int(i);
+    node->parent = nullptr;
+    if (shown) {
+        --parent->fetched;
+        endRemoveRows();
+    }
+}
+
+void WebOutlineModel::deleteNode(Node *node)
+{
+    for (Node *child : std::as_const(node->children))
+        deleteNode(child);
+    m_nodes.remove(node->key);
+    delete node;
+}
+
+void WebOutlineModel::onElementAdded(WebElementItem *item)
+{
+    // Parents nobody looked at list the element once they are populated
+    WebElementItem *parentItem = item->parentElement();
+    Node *parent = parentItem ? m_nodes.value(quintptr(parentItem)) : &m_root;
+    if (!parent) return;
+
+    if (!parent->populated) {
+        // Populating picks the element up; a first child has to be announced so the row can expand
+        populate(parent);
+        if (parent->children.size() == 1 && parent != &m_root)
+            fetchUpTo(parent, 0);
+        return;
+    }
+
+    Node *node = new Node;
+    node->key = quintptr(item);
+    insertNode(parent, node);
+}
+
+void WebOutlineModel::onElementRemoved(WebElementItem *item)
+{
+    // Its children were moved to its parent before, see WebDesignScene::removeElement
+    Node *node = m_nodes.value(quintptr(item));
+    if (!node) return;
+    takeNode(node);
+    deleteNode(node);
+}
+
+void WebOutlineModel::onElementChanged(WebElementItem *item)
+{
+    Node *node = m_nodes.value(quintptr(item));
+    if (!node || node->row >= node->parent->fetched) return;
+    const QModelIndex index = indexOfNode(node);
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::ToolTipRole});
+}
+
+void WebOutlineModel::onElementParentChanged(WebElementItem *item)
+{
+    // The subtree is collected again under its new parent when that is expanded
+    if (Node *node = m_nodes.value(quintptr(item))) {
+        takeNode(node);
+        deleteNode(node);
+    }
+    onElementAdded(item);
+}
+
+void WebOutlineModel::onElementMaterialized(qsizetype slot, WebElementItem *item)
+{
+    if (!m_root.populated) return;
+
+    // Pending records are top level, their rows are in slot order
+    auto it = std::lower_bound(m_root.children.cbegin(), m_root.children.cend(), slot,
+                               [this](const Node *child, qsizetype value) { return slotOf(child) < value; });
+    if (it == m_root.children.cend() || slotOf(*it) != slot) return;
+
+    Node *node = *it;
+    m_nodes.remove(node->key);
+    node->key = quintptr(item);
+    m_nodes.insert(node->key, node);
+}
@@ -0,0 +1,84 @@
+#ifndef WEBOUTLINEMODEL_H
+#define WEBOUTLINEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+
+class WebDesignScene;
+class WebElementItem;
+
+// The element tree of a page as a model for the outline's QTreeView.
+// Nothing is built up front: the children of a node are collected the first
+// time the view asks for them and handed out in batches through fetchMore(),
+// so a page of 100k top-level elements costs the view one batch of rows.
+// Records of a mapped design are listed without being materialized.
+//
+// Nodes are identified by WebDesignScene::elementKey(), which stays valid
+// while other elements are added and removed.
+class WebOutlineModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit WebOutlineModel(WebDesignScene *scene, QObject *parent = nullptr);
+    ~WebOutlineModel() override;
+
+    // Follows another scene, e.g. when a different page of the project is opened
+    void setScene(WebDesignScene *scene);
+
+    // Index of an element, fetching the rows up to it and up to its ancestors
+    QModelIndex indexOf(WebElementItem *item);
+    // Element of a row, created first if its record was pending
+    WebElementItem *elementAt(const QModelIndex &index);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // Rows handed to the view per fetchMore()
+    static constexpr int FetchBatch = 256;
+    // Longest text shown in a row
+    static constexpr int LabelTextLength = 40;
+
+private:
+    struct Node
+    {
+        quintptr key = 0;
+        Node *parent = nullptr;
+        // In document order; the view only knows the first fetched of them
+        QList<Node*> children;
+        bool populated = false;
+        int fetched = 0;
+        int row = 0;
+    };
+
+    void connectScene();
+    void reset();
+    Node *nodeOf(const QModelIndex &index) const;
+    QModelIndex indexOfNode(Node *node) const;
+    qsizetype slotOf(const Node *node) const;
+    void populate(Node *node) const;
+    void fetchUpTo(Node *node, int row);
+    void insertNode(Node *parent, Node *node);
+    void takeNode(Node *node);
+    void deleteNode(Node *node);
+
+    void onElementAdded(WebElementItem *item);
+    void onElementRemoved(WebElementItem *item);
+    void onElementChanged(WebElementItem *item);
+    void onElementParentChanged(WebElementItem *item);
+    void onElementMaterialized(qsizetype slot, WebElementItem *item);
+
+    WebDesignScene *m_scene;
+    // Populating happens while the view reads the model, hence mutable
+    mutable Node m_root;
+    mutable QHash<quintptr, Node*> m_nodes;
+};
+
+#endif // WEBOUTLINEMODEL_H
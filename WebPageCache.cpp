@@ -0,0 +1,63 @@
+#include "WebPageCache.h"
+#include "WebDesignScene.h"
+#include "WebProfiler.h"
+#include "WebProject.h"
+
+WebPageCache::WebPageCache(qsizetype capacity, QObject *parent)
+    : QObject(parent), m_capacity(qMax<qsizetype>(2, capacity))
+{
+}
+
+WebDesignScene *WebPageCache::acquire(const WebProject &project, qsizetype index)
+{
+    const quint32 id = project.page(index).id;
+    for (qsizetype i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).pageId == id) {
+            m_entries.move(i, 0);
+            return m_entries.constFirst().scene;
+        }
+    }
+
+    const WebProfileScope scope("pages/load");
+    WebDesignScene *scene = new WebDesignScene(this);
+    scene->setComponentLibrary(&project.components());
+    scene->loadElements(project.elements(index));
+    m_entries.prepend(Entry{id, scene});
+
+    // The scene that was shown before stays second, at least two scenes are kept
+    while (m_entries.size() > m_capacity)
+        release(m_entries.takeLast().scene);
+    return scene;
+}
+
+QList<WebDesignScene*> WebPageCache::scenes() const
+{
+    QList<WebDesignScene*> scenes;
+    scenes.reserve(m_entries.size());
+    for (const Entry &entry : m_entries)
+        scenes.append(entry.scene);
+    return scenes;
+}
+
+void WebPageCache::remove(quint32 pageId)
+{
+    for (qsizetype i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).pageId == pageId) {
+            release(m_entries.takeAt(i).scene);
+            return;
+        }
+    }
+}
+
+void WebPageCache::clear()
+{
+    for (const Entry &entry : std::as_const(m_entries))
+        release(entry.scene);
+    m_entries.clear();
+}
+
+void WebPageCache::release(WebDesignScene *scene)
+{
+    // Views and engines may still point at it until the next scene is bound
+    scene->deleteLater();
+}
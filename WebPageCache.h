@@ -0,0 +1,51 @@
+#ifndef WEBPAGECACHE_H
+#define WEBPAGECACHE_H
+
+#include <QList>
+#include <QObject>
+
+class WebDesignScene;
+class WebProject;
+
+// Scenes of the most recently opened pages. Going back to a cached page is
+// immediate and keeps its undo history; older scenes are deleted and their
+// pages live on as blobs in the project, to be loaded again when opened.
+// Pages are tracked by WebPage::id, so removing a page does not confuse them.
+class WebPageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WebPageCache(qsizetype capacity = DefaultCapacity, QObject *parent = nullptr);
+
+    // Scene of the page at index, loaded from its blob unless it is cached.
+    // The page becomes the most recently used one, which is never evicted.
+    // The scene binds its instances to the project's component library.
+    WebDesignScene *acquire(const WebProject &project, qsizetype index);
+
+    // Deletes the scene of a page, e.g. once the page is removed
+    void remove(quint32 pageId);
+    void clear();
+
+    qsizetype count() const { return m_entries.size(); }
+    // Every cached scene, most recently used first
+    QList<WebDesignScene*> scenes() const;
+    qsizetype capacity() const { return m_capacity; }
+
+    static constexpr qsizetype DefaultCapacity = 4;
+
+private:
+    struct Entry
+    {
+        quint32 pageId;
+        WebDesignScene *scene;
+    };
+
+    static void release(WebDesignScene *scene);
+
+    // Most recently used first
+    QList<Entry> m_entries;
+    qsizetype m_capacity;
+};
+
+#endif // WEBPAGECACHE_H
@@ -0,0 +1,148 @@
+#include "WebPerformanceDock.h"
+#include "WebDesignScene.h"
+#include "WebProfiler.h"
+#include "WebUndoStack.h"
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+QString formatMs(qint64 ns)
+{
+    return QString::number(double(ns) / 1e6, 'f', 2) + " ms";
+}
+
+// "avg / max (calls)" of one profiler scope over the last update interval
+QString formatTimings(const WebProfiler::Stats &stats)
+{
+    if (stats.calls == 0)
+        return QObject::tr("idle");
+    return QObject::tr("%1 avg / %2 max (%3 calls)")
+        .arg(formatMs(stats.totalNs / stats.calls), formatMs(stats.maxNs))
+        .arg(stats.calls);
+}
+}
+
+WebPerformanceDock::WebPerformanceDock(WebDesignScene *scene, QWidget *parent)
+    : QDockWidget(tr("Performance"), parent), m_scene(scene)
+{
+    setObjectName("performanceDock");
+
+    QWidget *content = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(content);
+    QFormLayout *form = new QFormLayout;
+
+    m_frameLabel = new QLabel;
+    form->addRow(tr("Canvas frame:"), m_frameLabel);
+    m_paintLabel = new QLabel;
+    form->addRow(tr("Item paints:"), m_paintLabel);
+    m_refreshLabel = new QLabel;
+    form->addRow(tr("Preview refresh:"), m_refreshLabel);
+    m_rebuildLabel = new QLabel;
+    form->addRow(tr("Preview rebuild:"), m_rebuildLabel);
+    m_elementsLabel = new QLabel;
+    form->addRow(tr("Elements:"), m_elementsLabel);
+    m_memoryLabel = new QLabel;
+    form->addRow(tr("Memory:"), m_memoryLabel);
+    m_traceLabel = new QLabel;
+    form->addRow(tr("Trace:"), m_traceLabel);
+    layout->addLayout(form);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    m_traceButton = new QPushButton(tr("Record Trace"));
+    m_traceButton->setCheckable(true);
+    buttons->addWidget(m_traceButton);
+    m_saveTraceButton = new QPushButton(tr("Save Trace..."));
+    m_saveTraceButton->setEnabled(false);
+    buttons->addWidget(m_saveTraceButton);
+    layout->addLayout(buttons);
+    layout->addStretch();
+    setWidget(content);
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(UpdateIntervalMs);
+    connect(m_updateTimer, &QTimer::timeout, this, &WebPerformanceDock::updateStats);
+    connect(m_traceButton, &QPushButton::toggled, this, &WebPerformanceDock::toggleTracing);
+    connect(m_saveTraceButton, &QPushButton::clicked, this, &WebPerformanceDock::saveTrace);
+}
+
+void WebPerformanceDock::showEvent(QShowEvent *event)
+{
+    QDockWidget::showEvent(event);
+    WebProfiler::instance().setEnabled(true);
+    m_updateTimer->start();
+    updateStats();
+}
+
+void WebPerformanceDock::hideEvent(QHideEvent *event)
+{
+    QDockWidget::hideEvent(event);
+    m_updateTimer->stop();
+    WebProfiler::instance().setEnabled(false);
+}
+
+void WebPerformanceDock::updateStats()
+{
+    WebProfiler &profiler = WebProfiler::instance();
+    const QHash<const char*, WebProfiler::Stats> stats = profiler.takeStats();
+    auto statsOf = [&stats](const char *name) {
+        // Scope names are literals, but the same literal may have several addresses
+        for (auto it = stats.cbegin(); it != stats.cend(); ++it) {
+            if (qstrcmp(it.key(), name) == 0)
+                return it.value();
+        }
+        return WebProfiler::Stats();
+    };
+
+    const WebProfiler::Stats frames = statsOf("scene/frame");
+    const WebProfiler::Stats paints = statsOf("item/paint");
+    m_frameLabel->setText(formatTimings(frames));
+    m_paintLabel->setText(frames.calls
+        ? tr("%1 per frame, %2 total").arg(paints.calls / frames.calls).arg(formatMs(paints.totalNs))
+        : tr("idle"));
+    m_refreshLabel->setText(formatTimings(statsOf("preview/refresh")));
+    m_rebuildLabel->setText(formatTimings(statsOf("preview/rebuild")));
+
+    const qsizetype total = m_scene->elementCount();
+    m_elementsLabel->setText(tr("%1 (%2 on canvas)").arg(total).arg(total - m_scene->pendingElementCount()));
+
+    QLocale locale;
+    qint64 heap = WebProfiler::memoryInUse();
+    QString memory = heap >= 0 ? tr("%1 heap").arg(locale.formattedDataSize(heap)) : tr("heap unknown");
+    memory += tr(", %1 undo history").arg(locale.formattedDataSize(m_scene->undoStack()->memoryUsage()));
+    m_memoryLabel->setText(memory);
+
+    m_traceLabel->setText(profiler.isTracing()
+        ? tr("recording, %1 events").arg(profiler.traceEventCount())
+        : tr("%1 events").arg(profiler.traceEventCount()));
+}
+
+void WebPerformanceDock::toggleTracing(bool tracing)
+{
+    WebProfiler::instance().setTracing(tracing);
+    m_traceButton->setText(tracing ? tr("Stop Trace") : tr("Record Trace"));
+    m_saveTraceButton->setEnabled(!tracing && WebProfiler::instance().traceEventCount() > 0);
+    updateStats();
+}
+
+void WebPerformanceDock::saveTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(
+        this,
+        tr("Save Trace"),
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/webdesigner-trace.json",
+        tr("Chrome Trace Files (*.json)"));
+
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!WebProfiler::instance().writeTrace(fileName, &error))
+        QMessageBox::warning(this, tr("Error"), tr("Could not save file: %1").arg(error));
+}
@@ -0,0 +1,49 @@
+#ifndef WEBPERFORMANCEDOCK_H
+#define WEBPERFORMANCEDOCK_H
+
+#include <QDockWidget>
+
+class QLabel;
+class QPushButton;
+class QTimer;
+class WebDesignScene;
+
+// Live numbers from WebProfiler: frame time, preview timings, item counts
+// and memory. Profiling is only switched on while the dock is visible or a
+// trace is being recorded.
+class WebPerformanceDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit WebPerformanceDock(WebDesignScene *scene, QWidget *parent = nullptr);
+
+    void setScene(WebDesignScene *scene) { m_scene = scene; }
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void updateStats();
+    void toggleTracing(bool tracing);
+    void saveTrace();
+
+private:
+    static constexpr int UpdateIntervalMs = 500;
+
+    WebDesignScene *m_scene;
+    QTimer *m_updateTimer;
+
+    QLabel *m_frameLabel;
+    QLabel *m_paintLabel;
+    QLabel *m_refreshLabel;
+    QLabel *m_rebuildLabel;
+    QLabel *m_elementsLabel;
+    QLabel *m_memoryLabel;
+    QLabel *m_traceLabel;
+    QPushButton *m_traceButton;
+    QPushButton *m_saveTraceButton;
+};
+
+#endif // WEBPERFORMANCEDOCK_H
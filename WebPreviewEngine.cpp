@@ -0,0 +1,321 @@
+#include "WebPreviewEngine.h"
+#include "WebDesignScene.h"
+#include "WebElementItem.h"
+#include "WebElementProperties.h"
+#include "WebHtmlExporter.h"
+#include "WebHtmlWriter.h"
+#include "WebProfiler.h"
+#include "WebElementTree.h"
+#include <QTextEdit>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtConcurrent/QtConcurrentRun>
+
+WebPreviewEngine::WebPreviewEngine(WebDesignScene *scene, WebElementProperties *properties,
+                                   QTextEdit *view, QObject *parent)
+    : QObject(parent), m_scene(scene), m_properties(properties), m_view(view),
+      m_nextRevision(0), m_refreshPending(false), m_rebuildPending(false)
+{
+    // The preview is rewritten programmatically, keeping undo history would only grow memory
+    m_view->setUndoRedoEnabled(false);
+
+    connectScene();
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, &WebPreviewEngine::onGenerationFinished);
+
+    rebuild();
+}
+
+void WebPreviewEngine::setScene(WebDesignScene *scene)
+{
+    if (scene == m_scene) return;
+
+    disconnect(m_scene, nullptr, this, nullptr);
+    m_scene = scene;
+    connectScene();
+    // Fragments still being generated belong to the old scene, their items are no longer indexed
+    rebuild();
+}
+
+void WebPreviewEngine::connectScene()
+{
+    connect(m_scene, &WebDesignScene::elementAdded, this, &WebPreviewEngine::onElementAdded);
+    connect(m_scene, &WebDesignScene::elementRemoved, this, &WebPreviewEngine::onElementRemoved);
+    connect(m_scene, &WebDesignScene::elementChanged, this, &WebPreviewEngine::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementMaterialized, this, &WebPreviewEngine::onElementMaterialized);
+    connect(m_scene, &WebDesignScene::elementParentChanged, this, &WebPreviewEngine::scheduleRebuild);
+    connect(m_scene, &WebDesignScene::sceneCleared, this, &WebPreviewEngine::rebuild);
+    connect(m_scene, &WebDesignScene::sceneLoaded, this, &WebPreviewEngine::rebuild);
+}
+
+WebPreviewEngine::~WebPreviewEngine()
+{
+    m_watcher.waitForFinished();
+}
+
+QString WebPreviewEngine::documentHtml() const
+{
+    QString html = m_header;
+    for (const Fragment &fragment : m_fragments) {
+        if (fragment.inDocument)
+            html += fragmentText(fragment);
+    }
+    html += WebHtmlExporter::documentFooter();
+    return html;
+}
+
+void WebPreviewEngine::refresh()
+{
+    const WebProfileScope scope("preview/refresh");
+    m_refreshPending = false;
+
+    QString header = headerHtml();
+    if (header != m_header) {
+        replaceRange(0, m_header.size(), header);
+        m_header = header;
+    }
+
+    // One batch at a time, whatever gets dirty meanwhile is picked up when it lands.
+    // A pending rebuild regenerates everything anyway.
+    if (m_rebuildPending || m_dirty.isEmpty() || m_watcher.isRunning()) return;
+
+    QList<GenerationJob> jobs;
+    QList<WebElementData> snapshot;
+    jobs.reserve(m_dirty.size());
+    snapshot.reserve(m_dirty.size());
+    for (WebElementItem *item : std::as_const(m_dirty)) {
+        qsizetype index = m_index.value(item, -1);
+        if (index < 0) continue;
+
+        jobs.append(GenerationJob{item, m_fragments.at(index).revision, item->hasChildElements(), QString()});
+        snapshot.append(item->elementData());
+    }
+    m_dirty.clear();
+
+    m_watcher.setFuture(QtConcurrent::run(&WebPreviewEngine::generateFragments, jobs, snapshot));
+}
+
+void WebPreviewEngine::onGenerationFinished()
+{
+    const WebProfileScope scope("preview/apply");
+    if (m_rebuildPending) return;
+    const QList<GenerationJob> results = m_watcher.result();
+
+    QTextCursor batch(m_view->document());
+    batch.beginEditBlock();
+
+    for (const GenerationJob &result : results) {
+        qsizetype index = m_index.value(result.item, -1);
+        if (index < 0) continue;
+
+        // Edited again, removed or rebuilt since the snapshot was taken
+        Fragment &fragment = m_fragments[index];
+        if (fragment.revision != result.revision) continue;
+        if (fragment.inDocument && result.html == fragment.html) continue;
+
+        qsizetype offset = fragmentOffset(index);
+        qsizetype oldLength = fragmentLength(fragment);
+        fragment.html = result.html;
+        fragment.inDocument = true;
+        replaceRange(offset, oldLength, fragmentText(fragment));
+        m_offsets.add(index, fragmentLength(fragment) - oldLength);
+    }
+
+    batch.endEditBlock();
+
+    if (!m_dirty.isEmpty())
+        scheduleRefresh();
+}
+
+QList<WebPreviewEngine::GenerationJob> WebPreviewEngine::generateFragments(const QList<GenerationJob> &jobs,
+                                                                           const QList<WebElementData> &snapshot)
+{
+    const WebProfileScope scope("preview/generate");
+    QList<GenerationJob> results = jobs;
+    WebHtmlWriter writer;
+    for (qsizetype i = 0; i < results.size(); ++i) {
+        if (results.at(i).hasChildren)
+            writer.writeStartTag(snapshot.at(i));
+        else
+            writer.writeElement(snapshot.at(i));
+        results[i].html = writer.takeHtml();
+    }
+    return results;
+}
+
+void WebPreviewEngine::rebuild()
+{
+    const WebProfileScope scope("preview/rebuild");
+    m_refreshPending = false;
+    m_rebuildPending = false;
+    m_dirty.clear();
+    m_header = headerHtml();
+
+    const QList<WebElementData> elements = m_scene->snapshot();
+    const WebElementTree tree(elements);
+    m_fragments.clear();
+    m_fragments.reserve(elements.size());
+    m_pendingFragments.clear();
+    WebHtmlWriter writer;
+    tree.walk([&](qsizetype slot, bool hasChildren) {
+        if (hasChildren)
+            writer.writeStartTag(elements.at(slot));
+        else
+            writer.writeElement(elements.at(slot));
+
+        // Slots of a mapped design have no item yet, they are bound when materialized.
+        // Nested designs are written in tree order, so the slot is remembered.
+        Fragment fragment;
+        fragment.item = m_scene->elementAt(slot);
+        if (!fragment.item)
+            m_pendingFragments.insert(slot, m_fragments.size());
+        fragment.html = writer.takeHtml();
+        fragment.revision = ++m_nextRevision;
+        fragment.inDocument = true;
+        m_fragments.append(fragment);
+    }, [&](qsizetype slot) {
+        // The walk leaves a container right after its last descendant, the latest fragment
+        writer.writeEndTag(elements.at(slot).type);
+        m_fragments.last().trailer += writer.takeHtml() + QLatin1Char('\n');
+    });
+    rebuildIndex();
+
+    m_view->setPlainText(documentHtml());
+}
+
+void WebPreviewEngine::onElementAdded(WebElementItem *item)
+{
+    // Only a top level element is appended at the end of the document
+    if (m_rebuildPending) return;
+    if (item->parentElement()) {
+        scheduleRebuild();
+        return;
+    }
+
+    // Empty until its fragment is generated
+    m_offsets.append(0);
+
+    Fragment fragment;
+    fragment.item = item;
+    fragment.revision = ++m_nextRevision;
+    m_fragments.append(fragment);
+    m_index.insert(item, m_fragments.size() - 1);
+
+    m_dirty.insert(item);
+    scheduleRefresh();
+}
+
+void WebPreviewEngine::onElementRemoved(WebElementItem *item, qsizetype slot)
+{
+    if (m_rebuildPending) return;
+    qsizetype index = m_index.value(item, -1);
+    if (index < 0) return;
+
+    // Its children were moved out before, but a nested element may carry end tags of its ancestors
+    const Fragment &fragment = m_fragments.at(index);
+    if (item->parentElement() || !fragment.trailer.isEmpty()) {
+        scheduleRebuild();
+        return;
+    }
+    if (fragment.inDocument)
+        replaceRange(fragmentOffset(index), fragmentLength(fragment), QString());
+
+    m_fragments.removeAt(index);
+    m_dirty.remove(item);
+    rebuildIndex();
+
+    // Later slots and fragments move up by one
+    if (!m_pendingFragments.isEmpty()) {
+        QHash<qsizetype, qsizetype> pending;
+        pending.reserve(m_pendingFragments.size());
+        for (auto it = m_pendingFragments.cbegin(); it != m_pendingFragments.cend(); ++it)
+            pending.insert(it.key() - (it.key() > slot), it.value() - (it.value() > index));
+        m_pendingFragments = std::move(pending);
+    }
+}
+
+void WebPreviewEngine::onElementMaterialized(qsizetype slot, WebElementItem *item)
+{
+    // A pending rebuild finds the item in the scene
+    if (m_rebuildPending) return;
+
+    auto it = m_pendingFragments.constFind(slot);
+    if (it == m_pendingFragments.cend()) {
+        scheduleRebuild();
+        return;
+    }
+    m_fragments[it.value()].item = item;
+    m_index.insert(item, it.value());
+    m_pendingFragments.erase(it);
+}
+
+void WebPreviewEngine::onElementChanged(WebElementItem *item)
+{
+    if (m_rebuildPending) return;
+    qsizetype index = m_index.value(item, -1);
+    if (index < 0) return;
+
+    m_fragments[index].revision = ++m_nextRevision;
+    m_dirty.insert(item);
+    scheduleRefresh();
+}
+
+QString WebPreviewEngine::headerHtml() const
+{
+    return WebHtmlExporter::documentHeader(m_properties->getGlobalCss());
+}
+
+qsizetype WebPreviewEngine::fragmentLength(const Fragment &fragment) const
+{
+    return fragment.inDocument ? fragment.html.size() + 1 + fragment.trailer.size() : 0;
+}
+
+QString WebPreviewEngine::fragmentText(const Fragment &fragment)
+{
+    return fragment.html + QLatin1Char('\n') + fragment.trailer;
+}
+
+qsizetype WebPreviewEngine::fragmentOffset(qsizetype index) const
+{
+    return m_header.size() + m_offsets.offset(index);
+}
+
+void WebPreviewEngine::replaceRange(qsizetype start, qsizetype length, const QString &text)
+{
+    QTextCursor cursor(m_view->document());
+    cursor.setPosition(start);
+    cursor.setPosition(start + length, QTextCursor::KeepAnchor);
+    cursor.insertText(text);
+}
+
+void WebPreviewEngine::scheduleRefresh()
+{
+    if (m_refreshPending) return;
+
+    m_refreshPending = true;
+    QMetaObject::invokeMethod(this, &WebPreviewEngine::refresh, Qt::QueuedConnection);
+}
+
+void WebPreviewEngine::scheduleRebuild()
+{
+    // Structural changes come in groups (a drag onto a container, children
+    // moving out of a removed one), they are rebuilt once
+    if (m_rebuildPending) return;
+
+    m_rebuildPending = true;
+    QMetaObject::invokeMethod(this, &WebPreviewEngine::rebuild, Qt::QueuedConnection);
+}
+
+void WebPreviewEngine::rebuildIndex()
+{
+    qsizetype count = m_fragments.size();
+    m_index.clear();
+    m_index.reserve(count);
+    QList<qsizetype> lengths(count);
+
+    for (qsizetype i = 0; i < count; ++i) {
+        if (WebElementItem *item = m_fragments.at(i).item)
+            m_index.insert(item, i);
+        lengths[i] = fragmentLength(m_fragments.at(i));
+    }
+    m_offsets.assign(lengths);
+}
@@ -0,0 +1,103 @@
+#ifndef WEBPREVIEWENGINE_H
+#define WEBPREVIEWENGINE_H
+
+#include "WebOffsetTree.h"
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+class QTextEdit;
+class WebDesignScene;
+class WebElementItem;
+class WebElementProperties;
+struct WebElementData;
+
+// Keeps the HTML preview in sync with the scene by caching one fragment per
+// element and patching only the text ranges of elements that changed.
+// Fragments are generated on a worker thread from snapshots of the dirty
+// elements and spliced into the preview back on the GUI thread.
+//
+// Fragments are kept in document order. A container with children only
+// writes its start tag; its end tag trails the fragment of its last
+// descendant, so editing an element never touches the text of another.
+// Changes to the structure (nesting, moving between containers) rebuild
+// the preview once for a whole batch.
+class WebPreviewEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    WebPreviewEngine(WebDesignScene *scene, WebElementProperties *properties,
+                     QTextEdit *view, QObject *parent = nullptr);
+    ~WebPreviewEngine();
+
+    QString documentHtml() const;
+
+    // Follows another scene, e.g. when a different page of the project is opened
+    void setScene(WebDesignScene *scene);
+
+public slots:
+    void refresh();
+    void rebuild();
+
+private slots:
+    void onElementAdded(WebElementItem *item);
+    void onElementRemoved(WebElementItem *item, qsizetype slot);
+    void onElementMaterialized(qsizetype slot, WebElementItem *item);
+    void onElementChanged(WebElementItem *item);
+    void onGenerationFinished();
+    void scheduleRebuild();
+
+private:
+    struct Fragment
+    {
+        WebElementItem *item = nullptr;
+        QString html;
+        // End tags of the containers that close right after this element, each on its own line
+        QString trailer;
+        quint64 revision = 0;
+        bool inDocument = false;
+    };
+
+    struct GenerationJob
+    {
+        WebElementItem *item;
+        quint64 revision;
+        bool hasChildren;
+        QString html;
+    };
+
+    static QList<GenerationJob> generateFragments(const QList<GenerationJob> &jobs,
+                                                  const QList<WebElementData> &snapshot);
+
+    QString headerHtml() const;
+    qsizetype fragmentLength(const Fragment &fragment) const;
+    static QString fragmentText(const Fragment &fragment);
+    qsizetype fragmentOffset(qsizetype index) const;
+    void replaceRange(qsizetype start, qsizetype length, const QString &text);
+    void scheduleRefresh();
+    void rebuildIndex();
+    void connectScene();
+
+    WebDesignScene *m_scene;
+    WebElementProperties *m_properties;
+    QTextEdit *m_view;
+
+    QString m_header;
+    QList<Fragment> m_fragments;
+    // Fragment lengths, gives document offsets in O(log n)
+    WebOffsetTree m_offsets;
+    QHash<WebElementItem*, qsizetype> m_index;
+    // Fragments of mapped records that have no item yet, by their slot in the scene
+    QHash<qsizetype, qsizetype> m_pendingFragments;
+    QSet<WebElementItem*> m_dirty;
+    quint64 m_nextRevision;
+    bool m_refreshPending;
+    bool m_rebuildPending;
+    QFutureWatcher<QList<GenerationJob>> m_watcher;
+};
+
+#endif // WEBPREVIEWENGINE_H
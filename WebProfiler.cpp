@@ -0,0 +1,124 @@
+#include "WebProfiler.h"
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QThread>
+#include <utility>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+std::atomic<bool> WebProfiler::s_enabled{false};
+
+WebProfiler::WebProfiler()
+    : m_enabled(false), m_tracing(false)
+{
+    m_clock.start();
+}
+
+WebProfiler &WebProfiler::instance()
+{
+    static WebProfiler profiler;
+    return profiler;
+}
+
+void WebProfiler::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+    s_enabled.store(m_enabled || m_tracing, std::memory_order_relaxed);
+    if (!enabled)
+        m_stats.clear();
+}
+
+void WebProfiler::setTracing(bool tracing)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tracing = tracing;
+    if (tracing) {
+        m_trace.clear();
+        m_trace.reserve(MaxTraceEvents / 16);
+    }
+    s_enabled.store(m_enabled || m_tracing, std::memory_order_relaxed);
+}
+
+qsizetype WebProfiler::traceEventCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_trace.size();
+}
+
+void WebProfiler::addSample(const char *name, qint64 startNs, qint64 durationNs)
+{
+    QMutexLocker locker(&m_mutex);
+    Stats &stats = m_stats[name];
+    ++stats.calls;
+    stats.totalNs += durationNs;
+    stats.maxNs = qMax(stats.maxNs, durationNs);
+    stats.lastNs = durationNs;
+
+    if (m_tracing && m_trace.size() < MaxTraceEvents) {
+        quint64 thread = quint64(quintptr(QThread::currentThreadId()));
+        m_trace.append(TraceEvent{name, thread, startNs, durationNs});
+    }
+}
+
+void WebProfiler::addCount(const char *name, qint64 delta)
+{
+    if (!isEnabled()) return;
+
+    QMutexLocker locker(&m_mutex);
+    Stats &stats = m_stats[name];
+    stats.calls += delta;
+}
+
+QHash<const char*, WebProfiler::Stats> WebProfiler::takeStats()
+{
+    QMutexLocker locker(&m_mutex);
+    return std::exchange(m_stats, QHash<const char*, Stats>());
+}
+
+bool WebProfiler::writeTrace(const QString &fileName, QString *errorString) const
+{
+    QList<TraceEvent> events;
+    {
+        QMutexLocker locker(&m_mutex);
+        events = m_trace;
+    }
+
+    // Complete ("X") events with microsecond timestamps, the trace-event format's unit
+    QByteArray json;
+    json.reserve(events.size() * 96 + 64);
+    json += "{\"traceEvents\":[\n";
+    for (qsizetype i = 0; i < events.size(); ++i) {
+        const TraceEvent &event = events.at(i);
+        json += "{\"name\":\"";
+        json += event.name;
+        json += "\",\"ph\":\"X\",\"pid\":";
+        json += QByteArray::number(QCoreApplication::applicationPid());
+        json += ",\"tid\":";
+        json += QByteArray::number(event.thread);
+        json += ",\"ts\":";
+        json += QByteArray::number(double(event.startNs) / 1000, 'f', 3);
+        json += ",\"dur\":";
+        json += QByteArray::number(double(event.durationNs) / 1000, 'f', 3);
+        json += i + 1 < events.size() ? "},\n" : "}\n";
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}\n";
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (errorString) *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 WebProfiler::memoryInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,97 @@
+#ifndef WEBPROFILER_H
+#define WEBPROFILER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+// Collects timings of the editor's hot paths. Scopes are free while the
+// profiler is disabled (one relaxed atomic load), so they stay compiled in.
+// While enabled, every scope adds to per-name statistics that the
+// performance dock reads and resets; while tracing, every scope is also kept
+// as an event for a Chrome trace (chrome://tracing, Perfetto).
+//
+// Names must be string literals, they are stored by pointer.
+class WebProfiler
+{
+public:
+    struct Stats
+    {
+        qint64 calls = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        qint64 lastNs = 0;
+    };
+
+    static WebProfiler &instance();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    bool isTracing() const { return m_tracing; }
+    void setTracing(bool tracing);
+    qsizetype traceEventCount() const;
+    bool writeTrace(const QString &fileName, QString *errorString = nullptr) const;
+
+    void addSample(const char *name, qint64 startNs, qint64 durationNs);
+    void addCount(const char *name, qint64 delta = 1);
+
+    // Statistics gathered since the previous call
+    QHash<const char*, Stats> takeStats();
+
+    qint64 nowNs() const { return m_clock.nsecsElapsed(); }
+
+    // Heap bytes in use, or -1 where the allocator cannot tell
+    static qint64 memoryInUse();
+
+    // Trace events beyond this are dropped, about 32 MB of samples
+    static constexpr qsizetype MaxTraceEvents = 1000000;
+
+private:
+    WebProfiler();
+
+    struct TraceEvent
+    {
+        const char *name;
+        quint64 thread;
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    static std::atomic<bool> s_enabled;
+
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QHash<const char*, Stats> m_stats;
+    QList<TraceEvent> m_trace;
+    bool m_enabled;
+    bool m_tracing;
+};
+
+// Times the enclosing block under the given name
+class WebProfileScope
+{
+public:
+    explicit WebProfileScope(const char *name)
+        : m_name(name), m_start(WebProfiler::isEnabled() ? WebProfiler::instance().nowNs() : -1) {}
+
+    ~WebProfileScope()
+    {
+        if (m_start >= 0) {
+            WebProfiler &profiler = WebProfiler::instance();
+            profiler.addSample(m_name, m_start, profiler.nowNs() - m_start);
+        }
+    }
+
+    WebProfileScope(const WebProfileScope &) = delete;
+    WebProfileScope &operator=(const WebProfileScope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start;
+};
+
+#endif // WEBPROFILER_H
@@ -0,0 +1,327 @@
+#include "WebProject.h"
+#include "WebHtmlExporter.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr char kProjectMagic[4] = {'W', 'D', 'S', 'P'};
+
+bool fail(QString *errorString, const QString &message)
+{
+    if (errorString) *errorString = message;
+    return false;
+}
+
+QString defaultPageName()
+{
+    return QObject::tr("Home");
+}
+
+// Lower case letters and digits with single dashes in between, "About Us!" becomes "about-us"
+QString pageSlug(const QString &name)
+{
+    QString slug;
+    for (QChar c : name.toLower()) {
+        if (c.isLetterOrNumber())
+            slug += c;
+        else if (!slug.isEmpty() && !slug.endsWith(u'-'))
+            slug += u'-';
+    }
+    while (slug.endsWith(u'-'))
+        slug.chop(1);
+    return slug.isEmpty() ? u"page"_s : slug;
+}
+
+QList<WebElementData> elementsFromJson(const QJsonArray &array)
+{
+    QList<WebElementData> elements;
+    elements.reserve(array.size());
+    for (const QJsonValue &element : array)
+        elements.append(WebElementData::fromJson(element.toObject()));
+    return elements;
+}
+}
+
+WebProject::WebProject()
+    : m_activePage(0), m_nextId(0)
+{
+    addPage(defaultPageName());
+}
+
+void WebProject::setProperties(const QJsonObject &properties)
+{
+    m_properties = properties;
+    if (m_properties.contains("components"))
+        m_components = WebComponentLibrary::fromJson(m_properties.take("components").toArray());
+}
+
+QJsonObject WebProject::savedProperties() const
+{
+    QJsonObject properties = m_properties;
+    if (!m_components.isEmpty())
+        properties["components"] = m_components.toJson();
+    return properties;
+}
+
+qsizetype WebProject::indexOf(quint32 id) const
+{
+    for (qsizetype i = 0; i < m_pages.size(); ++i) {
+        if (m_pages.at(i).id == id)
+            return i;
+    }
+    return -1;
+}
+
+qsizetype WebProject::addPage(const QString &name, const QList<WebElementData> &elements)
+{
+    WebPage page;
+    page.id = m_nextId++;
+    page.name = name;
+    page.blob = encode(elements);
+    m_pages.append(page);
+    return m_pages.size() - 1;
+}
+
+void WebProject::removePage(qsizetype index)
+{
+    // A project always keeps one page
+    if (m_pages.size() <= 1) return;
+
+    m_pages.removeAt(index);
+    setActivePage(m_activePage > index ? m_activePage - 1 : m_activePage);
+}
+
+void WebProject::renamePage(qsizetype index, const QString &name)
+{
+    m_pages[index].name = name;
+}
+
+QList<WebElementData> WebProject::elements(qsizetype index, QString *errorString) const
+{
+    WebDesignDocument document;
+    if (!WebDesignSerializer::fromBinary(m_pages.at(index).blob, &document, errorString))
+        return {};
+    return document.elements;
+}
+
+void WebProject::setElements(qsizetype index, const QList<WebElementData> &elements)
+{
+    m_pages[index].blob = encode(elements);
+}
+
+qsizetype WebProject::byteSize() const
+{
+    qsizetype size = 0;
+    for (const WebPage &page : m_pages)
+        size += page.blob.size() + page.name.size() * qsizetype(sizeof(char16_t));
+    return size;
+}
+
+QStringList WebProject::pageFileNames() const
+{
+    QStringList fileNames;
+    QSet<QString> used;
+    for (qsizetype i = 0; i < m_pages.size(); ++i) {
+        const QString base = i == 0 ? u"index"_s : pageSlug(m_pages.at(i).name);
+        QString name = base;
+        for (int n = 2; used.contains(name); ++n)
+            name = base + u"-%1"_s.arg(n);
+        used.insert(name);
+        fileNames.append(name + u".html"_s);
+    }
+    return fileNames;
+}
+
+bool WebProject::exportSite(const QString &directory, QString *errorString, int threadCount) const
+{
+    QDir output(directory);
+    if (!output.mkpath(u"."_s))
+        return fail(errorString, QObject::tr("Could not create %1").arg(directory));
+
+    const QStringList fileNames = pageFileNames();
+    const QString css = m_properties["global_css"].toString() + m_components.styleSheet();
+
+    // Pages share nothing but the style sheet, so each is decoded, generated
+    // and written by its own worker. Every worker writes only its own error.
+    QList<QString> errors(m_pages.size());
+    QString *results = errors.data();
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+    for (qsizetype i = 0; i < m_pages.size(); ++i) {
+        pool.start([this, i, &output, &fileNames, &css, error = results + i] {
+            const QList<WebElementData> elements = this->elements(i, error);
+            if (!error->isEmpty()) return;
+
+            WebHtmlExporter exporter(output.filePath(fileNames.at(i)));
+            if (!exporter.begin(css)) {
+                *error = exporter.errorString();
+                return;
+            }
+            exporter.writeElements(m_components.exportElements(elements));
+            if (!exporter.finish())
+                *error = exporter.errorString();
+        });
+    }
+    pool.waitForDone();
+
+    for (qsizetype i = 0; i < errors.size(); ++i) {
+        if (!errors.at(i).isEmpty())
+            return fail(errorString, u"%1: %2"_s.arg(fileNames.at(i), errors.at(i)));
+    }
+    return true;
+}
+
+bool WebProject::read(const QString &fileName, WebProject *project,
+                      WebDesignSerializer::Format *format, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(errorString, file.errorString());
+    return fromData(file.readAll(), project, format, errorString);
+}
+
+bool WebProject::write(const QString &fileName, const WebProject &project,
+                       WebDesignSerializer::Format format, QString *errorString)
+{
+    // One page stays readable by everything that reads plain designs
+    if (project.pageCount() == 1) {
+        WebDesignDocument document;
+        document.elements = project.elements(0);
+        document.properties = project.savedProperties();
+        return WebDesignSerializer::write(fileName, document, format, errorString);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return fail(errorString, file.errorString());
+
+    QByteArray data = format == WebDesignSerializer::BinaryFormat ? toBinary(project) : toJson(project);
+    if (file.write(data) != data.size() || !file.commit())
+        return fail(errorString, file.errorString());
+    return true;
+}
+
+QByteArray WebProject::toJson(const WebProject &project)
+{
+    QJsonArray pages;
+    for (qsizetype i = 0; i < project.pageCount(); ++i) {
+        QJsonArray elements;
+        for (const WebElementData &element : project.elements(i))
+            elements.append(element.toJson());
+
+        QJsonObject page;
+        page["name"] = project.page(i).name;
+        page["elements"] = elements;
+        pages.append(page);
+    }
+
+    QJsonObject object;
+    object["pages"] = pages;
+    object["active_page"] = qint64(project.activePage());
+    object["properties"] = project.savedProperties();
+    return QJsonDocument(object).toJson();
+}
+
+QByteArray WebProject::toBinary(const WebProject &project)
+{
+    // Page blobs are written as they are, saving does not touch the elements
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(kProjectMagic, sizeof(kProjectMagic));
+    out << ProjectVersion << quint32(project.pageCount()) << quint32(project.activePage());
+    for (const WebPage &page : project.m_pages)
+        out << page.name << page.blob;
+    out << QJsonDocument(project.savedProperties()).toJson(QJsonDocument::Compact);
+    return data;
+}
+
+bool WebProject::fromData(const QByteArray &data, WebProject *project,
+                          WebDesignSerializer::Format *format, QString *errorString)
+{
+    WebProject result;
+    result.m_pages.clear();
+    WebDesignSerializer::Format detected = WebDesignSerializer::JsonFormat;
+
+    if (data.startsWith(QByteArrayView(kProjectMagic, sizeof(kProjectMagic)))) {
+        detected = WebDesignSerializer::BinaryFormat;
+
+        QDataStream in(data);
+        in.setVersion(QDataStream::Qt_6_0);
+        in.setByteOrder(QDataStream::LittleEndian);
+        in.skipRawData(sizeof(kProjectMagic));
+
+        quint16 version = 0;
+        quint32 count = 0;
+        quint32 active = 0;
+        in >> version >> count >> active;
+        if (version > ProjectVersion)
+            return fail(errorString, QObject::tr("Unsupported project version %1").arg(version));
+
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            WebPage page;
+            in >> page.name >> page.blob;
+            page.id = result.m_nextId++;
+            result.m_pages.append(page);
+        }
+        QByteArray properties;
+        in >> properties;
+        if (in.status() != QDataStream::Ok || result.m_pages.isEmpty())
+            return fail(errorString, QObject::tr("Truncated project file"));
+
+        result.setProperties(QJsonDocument::fromJson(properties).object());
+        result.setActivePage(active);
+    } else if (WebDesignSerializer::detectFormat(data) == WebDesignSerializer::BinaryFormat) {
+        // A plain design is a project of one page
+        detected = WebDesignSerializer::BinaryFormat;
+
+        WebDesignDocument document;
+        if (!WebDesignSerializer::fromBinary(data, &document, errorString))
+            return false;
+        result.addPage(defaultPageName(), document.elements);
+        result.setProperties(document.properties);
+    } else {
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+        if (doc.isNull())
+            return fail(errorString, parseError.errorString());
+
+        const QJsonObject object = doc.object();
+        if (object.contains("pages")) {
+            const QJsonArray pages = object["pages"].toArray();
+            for (const QJsonValue &value : pages) {
+                const QJsonObject page = value.toObject();
+                result.addPage(page["name"].toString(), elementsFromJson(page["elements"].toArray()));
+            }
+        } else {
+            result.addPage(defaultPageName(), elementsFromJson(object["elements"].toArray()));
+        }
+        if (result.m_pages.isEmpty())
+            result.addPage(defaultPageName());
+
+        result.setProperties(object["properties"].toObject());
+        result.setActivePage(object["active_page"].toInt());
+    }
+
+    *project = std::move(result);
+    if (format) *format = detected;
+    return true;
+}
+
+QByteArray WebProject::encode(const QList<WebElementData> &elements)
+{
+    WebDesignDocument document;
+    document.elements = elements;
+    return WebDesignSerializer::toBinary(document);
+}
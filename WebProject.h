@@ -0,0 +1,94 @@
+#ifndef WEBPROJECT_H
+#define WEBPROJECT_H
+
+#include "WebComponent.h"
+#include "WebDesignSerializer.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// One page of a project. A page is stored as a binary design blob (see
+// WebDesignSerializer), a few dozen bytes per element, and only turned into
+// a scene while it is being edited.
+struct WebPage
+{
+    // Stable for the session, unlike the index it survives removing other pages
+    quint32 id = 0;
+    QString name;
+    QByteArray blob;
+};
+
+// A site of several pages sharing the global properties (the site's CSS)
+// and a library of components.
+//
+// Projects with a single page are saved as a plain design file, so older
+// versions and the batch converter still read them. Larger projects use
+//  - JSON: {"pages": [{"name", "elements"}], "active_page", "properties"}
+//  - Binary: magic "WDSP", then a little-endian QDataStream of quint16
+//    version, quint32 page count and active page, every page as name and
+//    blob, and the properties as compact JSON.
+class WebProject
+{
+public:
+    // A new project has one empty page
+    WebProject();
+
+    qsizetype pageCount() const { return m_pages.size(); }
+    const WebPage &page(qsizetype index) const { return m_pages.at(index); }
+    qsizetype indexOf(quint32 id) const;
+
+    qsizetype addPage(const QString &name, const QList<WebElementData> &elements = {});
+    void removePage(qsizetype index);
+    void renamePage(qsizetype index, const QString &name);
+
+    QList<WebElementData> elements(qsizetype index, QString *errorString = nullptr) const;
+    void setElements(qsizetype index, const QList<WebElementData> &elements);
+
+    // The page that was being edited, journaled edits apply to it
+    qsizetype activePage() const { return m_activePage; }
+    void setActivePage(qsizetype index) { m_activePage = qBound<qsizetype>(0, index, m_pages.size() - 1); }
+
+    QJsonObject properties() const { return m_properties; }
+    // Components saved in the properties are taken into the library
+    void setProperties(const QJsonObject &properties);
+
+    // Components shared by every page
+    const WebComponentLibrary &components() const { return m_components; }
+    WebComponentLibrary &components() { return m_components; }
+
+    // Memory held by the page blobs
+    qsizetype byteSize() const;
+
+    // HTML file name of every page: index.html for the first, the others after their names
+    QStringList pageFileNames() const;
+    // Writes every page into directory, one page per worker thread. Zero or
+    // less uses one thread per core.
+    bool exportSite(const QString &directory, QString *errorString = nullptr, int threadCount = 0) const;
+
+    static constexpr quint16 ProjectVersion = 1;
+
+    static bool read(const QString &fileName, WebProject *project,
+                     WebDesignSerializer::Format *format = nullptr, QString *errorString = nullptr);
+    static bool write(const QString &fileName, const WebProject &project,
+                      WebDesignSerializer::Format format, QString *errorString = nullptr);
+
+    static QByteArray toJson(const WebProject &project);
+    static QByteArray toBinary(const WebProject &project);
+    static bool fromData(const QByteArray &data, WebProject *project,
+                         WebDesignSerializer::Format *format = nullptr, QString *errorString = nullptr);
+
+private:
+    static QByteArray encode(const QList<WebElementData> &elements);
+    // The properties as written to files, with the component library
+    QJsonObject savedProperties() const;
+
+    QList<WebPage> m_pages;
+    QJsonObject m_properties;
+    WebComponentLibrary m_components;
+    qsizetype m_activePage;
+    quint32 m_nextId;
+};
+
+#endif // WEBPROJECT_H
@@ -0,0 +1,484 @@
+#include "WebRenderEngine.h"
+#include "WebDesignScene.h"
+#include "WebElementItem.h"
+#include "WebElementTree.h"
+#include "WebProfiler.h"
+#include "WebStyleEngine.h"
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cmath>
+
+namespace {
+// Browser defaults for headings, relative to the body font
+constexpr qreal kHeadingScale[] = {2.0, 1.5, 1.17, 1.0, 0.83, 0.67};
+constexpr qreal kInputWidth = 200;
+constexpr int kTextareaLines = 3;
+
+bool isHeading(WebElementKind kind)
+{
+    return kind >= WebElementKind::Heading1 && kind <= WebElementKind::Heading6;
+}
+
+bool sameText(const QString &a, const QString &b)
+{
+    return a.isSharedWith(b) || a == b;
+}
+
+// Where a box paints, including the half of its border outside the rectangle
+QRectF paintRect(const QRectF &rect, const QPen &border)
+{
+    const qreal margin = border.style() == Qt::NoPen ? 1 : border.widthF() / 2 + 1;
+    return rect.adjusted(-margin, -margin, margin, margin);
+}
+}
+
+WebRenderEngine::WebRenderEngine(WebDesignScene *scene, WebStyleEngine *styles, QObject *parent)
+    : QObject(parent), m_scene(scene), m_styles(styles), m_active(false), m_layoutPending(false),
+      m_pageWidth(800), m_pageHeight(0), m_tiles(TileCacheKb), m_allDroppedAt(0), m_generation(0)
+{
+    connectScene();
+    connect(m_styles, &WebStyleEngine::elementRestyled, this, &WebRenderEngine::scheduleLayout);
+    connect(&m_watcher, &QFutureWatcherBase::resultsReadyAt, this, &WebRenderEngine::onTilesRendered);
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, &WebRenderEngine::onRenderingFinished);
+}
+
+WebRenderEngine::~WebRenderEngine()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+void WebRenderEngine::setScene(WebDesignScene *scene)
+{
+    if (scene == m_scene) return;
+
+    disconnect(m_scene, nullptr, this, nullptr);
+    m_scene = scene;
+    connectScene();
+
+    // Nothing of the previous page carries over, not even boxes to compare with
+    m_boxes.clear();
+    m_boxOf.clear();
+    invalidateAll();
+    scheduleLayout();
+}
+
+void WebRenderEngine::connectScene()
+{
+    // Positions on the canvas do not matter to the page, geometry changes are not followed
+    connect(m_scene, &WebDesignScene::elementAdded, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::elementRemoved, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::elementChanged, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::elementTextEdited, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::elementParentChanged, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::elementMaterialized, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::sceneCleared, this, &WebRenderEngine::scheduleLayout);
+    connect(m_scene, &WebDesignScene::sceneLoaded, this, &WebRenderEngine::scheduleLayout);
+}
+
+void WebRenderEngine::setActive(bool active)
+{
+    if (active == m_active) return;
+    m_active = active;
+    // Edits made while hidden are found by comparing with the last layout
+    if (m_active)
+        scheduleLayout();
+}
+
+void WebRenderEngine::setPageWidth(int width)
+{
+    width = qMax(width, 1);
+    if (width == m_pageWidth) return;
+    m_pageWidth = width;
+    scheduleLayout();
+}
+
+const QImage *WebRenderEngine::tile(int column, int row)
+{
+    return m_tiles.object(tileKey(column, row));
+}
+
+void WebRenderEngine::requestTiles(const QRect &area)
+{
+    const QRect page(0, 0, m_pageWidth, m_pageHeight);
+    const QRect wanted = area & page;
+    if (wanted.isEmpty()) return;
+
+    for (int row = wanted.top() / TileSize; row <= wanted.bottom() / TileSize; ++row) {
+        for (int column = wanted.left() / TileSize; column <= wanted.right() / TileSize; ++column) {
+            const quint64 key = tileKey(column, row);
+            if (!m_tiles.contains(key) && !m_rendering.contains(key))
+                m_requested.insert(key);
+        }
+    }
+    startRendering();
+}
+
+void WebRenderEngine::scheduleLayout()
+{
+    if (m_layoutPending) return;
+    m_layoutPending = true;
+    // A batch of edits, or a restyle following an edit, is laid out once
+    QTimer::singleShot(0, this, &WebRenderEngine::layoutPage);
+}
+
+void WebRenderEngine::layoutPage()
+{
+    m_layoutPending = false;
+    if (!m_active) return;
+
+    const WebProfileScope scope("render/layout");
+    ++m_generation;
+
+    const QList<WebElementData> elements = m_scene->snapshot();
+    const WebElementTree tree(elements);
+
+    QList<Box> boxes;
+    QHash<quintptr, qsizetype> boxOf;
+    boxes.reserve(elements.size());
+    boxOf.reserve(elements.size());
+
+    // Containers being filled, innermost last, with where their next child goes
+    struct Open
+    {
+        qsizetype box;
+        qreal left;
+        qreal width;
+        qreal cursor;
+    };
+    QList<Open> open;
+    qreal bodyCursor = BodyMargin;
+
+    tree.walk([&](qsizetype index, bool hasChildren) {
+        const WebElementData &element = elements.at(index);
+        WebElementItem *item = m_scene->elementAt(index);
+        const qreal left = open.isEmpty() ? BodyMargin : open.constLast().left;
+        const qreal available = open.isEmpty() ? m_pageWidth - 2 * BodyMargin : open.constLast().width;
+        qreal &cursor = open.isEmpty() ? bodyCursor : open.last().cursor;
+
+        Box box;
+        box.key = item ? quintptr(item) : quintptr(index) << 1 | 1;
+        box.kind = WebElementTypeInfo::kindOf(element.type);
+        box.text = element.text;
+        // An image shows its alt text, as a browser does without the picture
+        if (box.kind == WebElementKind::Image) {
+            const QString alt = element.value(WebElementField::Alt);
+            if (!alt.isEmpty())
+                box.text = alt;
+        }
+        box.style = item ? item->computedStyle() : nullptr;
+        box.container = hasChildren;
+        resolvePaint(box);
+
+        const WebStyle *css = box.style ? &box.style->computed : nullptr;
+        const bool cssWidth = css && css->has(WebStyle::Width);
+        const bool cssHeight = css && css->has(WebStyle::Height);
+        const auto previous = m_boxOf.constFind(box.key);
+        const Box *old = previous != m_boxOf.cend() ? &m_boxes.at(previous.value()) : nullptr;
+
+        // Form controls and images have a size of their own, everything else fills the container
+        qreal width = available;
+        if (cssWidth) {
+            width = qMax(css->width, 1.0);
+        } else if (box.kind == WebElementKind::Button) {
+            width = qMin(available, QFontMetricsF(box.font).horizontalAdvance(box.text) + 4 * Padding);
+        } else if (box.kind == WebElementKind::Input || box.kind == WebElementKind::Textarea) {
+            width = qMin(available, kInputWidth);
+        } else if (box.kind == WebElementKind::Image) {
+            width = qMin(available, WebElementTypeInfo::of(box.kind).defaultSize.width());
+        }
+        box.rect = QRectF(left, cursor, width, 0);
+        box.textHeight = box.kind == WebElementKind::Image ? 0 : measureText(box, old);
+
+        const bool framed = box.fill.style() != Qt::NoBrush || box.border.style() != Qt::NoPen;
+        const qreal inset = framed || hasChildren ? Padding : 0;
+        const qreal contentTop = cursor + inset;
+
+        qreal height = 0;
+        if (box.kind == WebElementKind::Image) {
+            height = WebElementTypeInfo::of(box.kind).defaultSize.height();
+        } else if (box.kind == WebElementKind::Input) {
+            height = QFontMetricsF(box.font).height() + 2 * Padding;
+        } else if (box.kind == WebElementKind::Textarea) {
+            height = qMax(box.textHeight, kTextareaLines * QFontMetricsF(box.font).height()) + 2 * Padding;
+        } else {
+            height = box.textHeight + 2 * inset;
+        }
+        if (cssHeight)
+            height = qMax(css->height, 1.0);
+        box.rect.setHeight(height);
+
+        const qsizetype boxIndex = boxes.size();
+        boxOf.insert(box.key, boxIndex);
+        boxes.append(box);
+
+        if (hasChildren) {
+            // Children start below the container's own text
+            const qreal textBlock = box.textHeight > 0 ? box.textHeight + BlockGap : 0;
+            open.append(Open{boxIndex, left + Padding, qMax(width - 2 * Padding, 1.0), contentTop + textBlock});
+        } else {
+            cursor += height + BlockGap;
+        }
+    }, [&](qsizetype) {
+        const Open container = open.takeLast();
+        Box &box = boxes[container.box];
+        const WebStyle *css = box.style ? &box.style->computed : nullptr;
+        // The gap after the last child gives way to the padding
+        if (!css || !css->has(WebStyle::Height))
+            box.rect.setBottom(qMax(container.cursor - BlockGap, box.rect.top() + Padding) + Padding);
+        qreal &cursor = open.isEmpty() ? bodyCursor : open.last().cursor;
+        cursor = box.rect.bottom() + BlockGap;
+    });
+
+    const int pageHeight = int(std::ceil(qMax(bodyCursor - BlockGap, 0.0) + BodyMargin));
+
+    // Only tiles under boxes that moved, resized or paint differently are dropped
+    QRect changed;
+    auto drop = [&](const QRectF &area) {
+        invalidate(area);
+        changed |= area.toAlignedRect();
+    };
+    for (const Box &box : std::as_const(boxes)) {
+        auto previous = m_boxOf.constFind(box.key);
+        if (previous == m_boxOf.cend()) {
+            drop(paintRect(box.rect, box.border));
+            continue;
+        }
+        const Box &old = m_boxes.at(previous.value());
+        const bool samePaint = old.kind == box.kind && old.style == box.style
+            && old.container == box.container && sameText(old.text, box.text);
+        if (samePaint && old.rect == box.rect) continue;
+
+        if (samePaint && old.rect.topLeft() == box.rect.topLeft() && old.rect.width() == box.rect.width()) {
+            // Only the bottom moved, e.g. a container whose content grew
+            QRectF strip = paintRect(box.rect, box.border);
+            strip.setTop(qMin(old.rect.bottom(), box.rect.bottom()) - box.border.widthF() - 1);
+            strip.setBottom(qMax(old.rect.bottom(), box.rect.bottom()) + box.border.widthF() + 1);
+            drop(strip);
+        } else {
+            drop(paintRect(old.rect, old.border));
+            drop(paintRect(box.rect, box.border));
+        }
+    }
+    for (const Box &old : std::as_const(m_boxes)) {
+        if (!boxOf.contains(old.key))
+            drop(paintRect(old.rect, old.border));
+    }
+
+    m_boxes = std::move(boxes);
+    m_boxOf = std::move(boxOf);
+
+    // Rows of tiles list the boxes that reach into them, in document order, which is paint order
+    m_rows = QList<QList<qsizetype>>((pageHeight + TileSize - 1) / TileSize);
+    for (qsizetype i = 0; i < m_boxes.size(); ++i) {
+        const QRectF area = paintRect(m_boxes.at(i).rect, m_boxes.at(i).border);
+        const int first = qMax(0, int(area.top()) / TileSize);
+        const int last = qMin(int(m_rows.size()) - 1, int(area.bottom()) / TileSize);
+        for (int row = first; row <= last; ++row)
+            m_rows[row].append(i);
+    }
+
+    if (pageHeight != m_pageHeight) {
+        m_pageHeight = pageHeight;
+        emit pageResized();
+    }
+    if (!changed.isEmpty())
+        emit areaChanged(changed);
+    startRendering();
+}
+
+void WebRenderEngine::resolvePaint(Box &box) const
+{
+    // What a browser shows without any CSS
+    box.font = QFont();
+    box.color = Qt::black;
+    box.fill = Qt::NoBrush;
+    box.border = QPen(Qt::NoPen);
+    if (isHeading(box.kind)) {
+        box.font.setPointSizeF(box.font.pointSizeF() * kHeadingScale[int(box.kind) - int(WebElementKind::Heading1)]);
+        box.font.setBold(true);
+    }
+    switch (box.kind) {
+    case WebElementKind::Link:
+        box.color = QColor(0, 0, 238);
+        box.font.setUnderline(true);
+        break;
+    case WebElementKind::Button:
+        box.fill = QColor(239, 239, 239);
+        box.border = QPen(QColor(118, 118, 118), 1);
+        break;
+    case WebElementKind::Input:
+    case WebElementKind::Textarea:
+        box.fill = QColor(Qt::white);
+        box.border = QPen(QColor(118, 118, 118), 1);
+        break;
+    case WebElementKind::Image:
+        box.fill = QColor(221, 221, 221);
+        box.color = QColor(100, 100, 100);
+        break;
+    default:
+        break;
+    }
+
+    const WebElementStyle *style = box.style.get();
+    if (!style) return;
+    if (style->hasFill())
+        box.fill = style->fill;
+    if (style->hasBorder())
+        box.border = style->border;
+    if (style->hasTextColor())
+        box.color = style->text.color();
+    if (style->hasFont())
+        box.font = style->font;
+}
+
+qreal WebRenderEngine::measureText(const Box &box, const Box *previous) const
+{
+    if (box.text.isEmpty()) return 0;
+
+    // Laying out text is the expensive part, a box that did not change keeps its height
+    if (previous && previous->kind == box.kind && previous->style == box.style
+        && previous->rect.width() == box.rect.width() && sameText(previous->text, box.text))
+        return previous->textHeight;
+
+    const qreal width = qMax(box.rect.width() - 2 * Padding, 1.0);
+    return QFontMetricsF(box.font).boundingRect(QRectF(0, 0, width, 1e6), Qt::TextWordWrap, box.text).height();
+}
+
+void WebRenderEngine::invalidate(const QRectF &area)
+{
+    const QRect bounds = area.toAlignedRect();
+    if (bounds.isEmpty()) return;
+
+    const int firstRow = qMax(0, bounds.top() / TileSize);
+    const int firstColumn = qMax(0, bounds.left() / TileSize);
+    for (int row = firstRow; row <= bounds.bottom() / TileSize; ++row) {
+        for (int column = firstColumn; column <= bounds.right() / TileSize; ++column) {
+            const quint64 key = tileKey(column, row);
+            m_tiles.remove(key);
+            m_droppedAt.insert(key, m_generation);
+        }
+    }
+}
+
+void WebRenderEngine::invalidateAll()
+{
+    ++m_generation;
+    m_tiles.clear();
+    m_droppedAt.clear();
+    m_allDroppedAt = m_generation;
+    emit areaChanged(QRect(0, 0, m_pageWidth, m_pageHeight));
+}
+
+void WebRenderEngine::startRendering()
+{
+    // One batch at a time; tiles asked for meanwhile go into the next one
+    if (m_watcher.isRunning() || m_requested.isEmpty() || m_layoutPending) return;
+
+    const WebProfileScope scope("render/schedule");
+    m_jobs.clear();
+    m_jobs.reserve(m_requested.size());
+    for (quint64 key : std::as_const(m_requested)) {
+        const int row = int(key >> 32);
+        const int column = int(quint32(key));
+        TileJob job{key, m_generation, QRect(column * TileSize, row * TileSize, TileSize, TileSize), {}};
+        if (row < m_rows.size()) {
+            for (qsizetype index : m_rows.at(row)) {
+                const Box &box = m_boxes.at(index);
+                if (paintRect(box.rect, box.border).intersects(job.rect))
+                    job.boxes.append(box);
+            }
+        }
+        m_jobs.append(job);
+        m_rendering.insert(key);
+    }
+    m_requested.clear();
+
+    m_watcher.setFuture(QtConcurrent::mapped(m_jobs, &WebRenderEngine::renderTile));
+}
+
+void WebRenderEngine::onTilesRendered(int begin, int end)
+{
+    QRect changed;
+    for (int i = begin; i < end; ++i) {
+        const RenderedTile rendered = m_watcher.resultAt(i);
+        m_rendering.remove(rendered.key);
+        const int row = int(rendered.key >> 32);
+        const int column = int(quint32(rendered.key));
+        changed |= QRect(column * TileSize, row * TileSize, TileSize, TileSize);
+
+        // Dropped while it was being rendered, the view asks for it again when it repaints
+        if (rendered.generation < qMax(m_allDroppedAt, m_droppedAt.value(rendered.key)))
+            continue;
+        const int costKb = int(rendered.image.sizeInBytes() / 1024);
+        m_tiles.insert(rendered.key, new QImage(rendered.image), costKb);
+    }
+    if (!changed.isEmpty())
+        emit areaChanged(changed);
+}
+
+void WebRenderEngine::onRenderingFinished()
+{
+    m_rendering.clear();
+    m_jobs.clear();
+    startRendering();
+}
+
+WebRenderEngine::RenderedTile WebRenderEngine::renderTile(const TileJob &job)
+{
+    const WebProfileScope scope("render/tile");
+    QImage image(TileSize, TileSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.translate(-job.rect.topLeft());
+    for (const Box &box : job.boxes)
+        paintBox(&painter, box);
+    painter.end();
+
+    return RenderedTile{job.key, job.generation, image};
+}
+
+void WebRenderEngine::paintBox(QPainter *painter, const Box &box)
+{
+    if (box.fill.style() != Qt::NoBrush || box.border.style() != Qt::NoPen) {
+        painter->setPen(box.border);
+        painter->setBrush(box.fill);
+        painter->drawRect(box.rect);
+    }
+
+    // Designs carry no image data, a crossed frame with the alt text (else the text) stands in
+    if (box.kind == WebElementKind::Image) {
+        painter->setPen(QPen(box.color, 1));
+        painter->drawLine(box.rect.topLeft(), box.rect.bottomRight());
+        painter->drawLine(box.rect.topRight(), box.rect.bottomLeft());
+        painter->setFont(box.font);
+        painter->drawText(box.rect, Qt::AlignCenter | Qt::TextWordWrap, box.text);
+        return;
+    }
+    if (box.text.isEmpty()) return;
+
+    // Text stays inside its box, so a box's tiles are all an edit of it touches
+    const bool framed = box.fill.style() != Qt::NoBrush || box.border.style() != Qt::NoPen;
+    const qreal inset = framed || box.container ? Padding : 0;
+    QRectF textRect(box.rect.left() + Padding, box.rect.top() + inset,
+                    qMax(box.rect.width() - 2 * Padding, 1.0), box.textHeight);
+    int flags = Qt::TextWordWrap;
+    if (box.kind == WebElementKind::Button) {
+        textRect = box.rect;
+        flags |= Qt::AlignCenter;
+    } else if (box.kind == WebElementKind::Input) {
+        textRect.setHeight(box.rect.height() - 2 * inset);
+        flags = Qt::AlignVCenter | Qt::TextSingleLine;
+    }
+
+    painter->save();
+    painter->setClipRect(box.rect, Qt::IntersectClip);
+    painter->setPen(box.color);
+    painter->setFont(box.font);
+    painter->drawText(textRect, flags, box.text);
+    painter->restore();
+}
@@ -0,0 +1,152 @@
+#ifndef WEBRENDERENGINE_H
+#define WEBRENDERENGINE_H
+
+#include "WebElementType.h"
+#include <QBrush>
+#include <QCache>
+#include <QColor>
+#include <QFont>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPen>
+#include <QRect>
+#include <QRectF>
+#include <QSet>
+#include <memory>
+
+class QPainter;
+class WebDesignScene;
+class WebElementItem;
+class WebStyleEngine;
+struct WebElementStyle;
+
+// Renders the page roughly as a browser would show the exported HTML,
+// without a browser engine. Every element is a block: blocks stack in
+// document order inside their container, take the container's width unless
+// CSS sets one, and are as tall as their CSS height, their text or their
+// children. They paint with the style WebStyleEngine computed for them.
+//
+// The page is rasterized in tiles of TileSize pixels, on worker threads,
+// and only while a view shows it. An edit lays the page out again (text is
+// only measured for boxes that changed) and compares the boxes with the
+// previous layout; only tiles under boxes that moved or paint differently
+// are dropped and rendered again.
+class WebRenderEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    WebRenderEngine(WebDesignScene *scene, WebStyleEngine *styles, QObject *parent = nullptr);
+    ~WebRenderEngine();
+
+    // Follows another scene, e.g. when a different page of the project is opened
+    void setScene(WebDesignScene *scene);
+
+    // Nothing is laid out or rendered while no view shows the page
+    bool isActive() const { return m_active; }
+    void setActive(bool active);
+
+    int pageWidth() const { return m_pageWidth; }
+    void setPageWidth(int width);
+    int pageHeight() const { return m_pageHeight; }
+    qsizetype boxCount() const { return m_boxes.size(); }
+
+    // Rendered tile at column and row, null while it is missing or outdated
+    const QImage *tile(int column, int row);
+    // Queues the missing tiles that intersect area, in page coordinates
+    void requestTiles(const QRect &area);
+    // Lays the page out now instead of on the next pass of the event loop
+    void layoutPage();
+
+    static constexpr int TileSize = 256;
+
+    signals:
+        void pageResized();
+        // Tiles covering area, in page coordinates, were rendered or dropped
+        void areaChanged(const QRect &area);
+
+private slots:
+    void scheduleLayout();
+    void onTilesRendered(int begin, int end);
+    void onRenderingFinished();
+
+private:
+    // One element as laid out, with everything needed to paint it
+    struct Box
+    {
+        // The item, or the slot with the low bit set for records of a mapped design
+        quintptr key = 0;
+        QRectF rect;
+        WebElementKind kind = WebElementKind::Unknown;
+        QString text;
+        std::shared_ptr<const WebElementStyle> style;
+        // Resolved from the style and the type's defaults
+        QBrush fill;
+        QPen border;
+        QColor color;
+        QFont font;
+        qreal textHeight = 0;
+        bool container = false;
+    };
+
+    struct TileJob
+    {
+        quint64 key;
+        quint64 generation;
+        QRect rect;
+        QList<Box> boxes;
+    };
+
+    struct RenderedTile
+    {
+        quint64 key;
+        quint64 generation;
+        QImage image;
+    };
+
+    // Gaps of the default style sheet of a browser, roughly
+    static constexpr qreal BodyMargin = 8;
+    static constexpr qreal BlockGap = 8;
+    static constexpr qreal Padding = 6;
+    // Bound of the tile cache in kilobytes
+    static constexpr int TileCacheKb = 64 * 1024;
+
+    static quint64 tileKey(int column, int row) { return quint64(quint32(row)) << 32 | quint32(column); }
+    static RenderedTile renderTile(const TileJob &job);
+    static void paintBox(QPainter *painter, const Box &box);
+
+    void connectScene();
+    void resolvePaint(Box &box) const;
+    qreal measureText(const Box &box, const Box *previous) const;
+    void invalidate(const QRectF &area);
+    void invalidateAll();
+    void startRendering();
+
+    WebDesignScene *m_scene;
+    WebStyleEngine *m_styles;
+    bool m_active;
+    bool m_layoutPending;
+    int m_pageWidth;
+    int m_pageHeight;
+
+    QList<Box> m_boxes;
+    QHash<quintptr, qsizetype> m_boxOf;
+    // Boxes reaching into each row of tiles, in paint order
+    QList<QList<qsizetype>> m_rows;
+
+    // A tile is current when it was rendered from a layout at least as new as
+    // the last one that dropped it
+    QCache<quint64, QImage> m_tiles;
+    QHash<quint64, quint64> m_droppedAt;
+    quint64 m_allDroppedAt;
+    quint64 m_generation;
+    QSet<quint64> m_requested;
+    QSet<quint64> m_rendering;
+    QList<TileJob> m_jobs;
+    QFutureWatcher<RenderedTile> m_watcher;
+};
+
+#endif // WEBRENDERENGINE_H
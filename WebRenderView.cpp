@@ -0,0 +1,74 @@
+#include "WebRenderView.h"
+#include "WebRenderEngine.h"
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+WebRenderView::WebRenderView(WebRenderEngine *engine, QWidget *parent)
+    : QAbstractScrollArea(parent), m_engine(engine)
+{
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+    verticalScrollBar()->setSingleStep(20);
+
+    connect(m_engine, &WebRenderEngine::pageResized, this, &WebRenderView::updateScrollRange);
+    connect(m_engine, &WebRenderEngine::areaChanged, this, &WebRenderView::onAreaChanged);
+}
+
+void WebRenderView::paintEvent(QPaintEvent *event)
+{
+    constexpr int tileSize = WebRenderEngine::TileSize;
+    const int offset = verticalScrollBar()->value();
+    const QRect area = event->rect().translated(0, offset);
+
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), Qt::white);
+
+    for (int row = qMax(0, area.top() / tileSize); row <= area.bottom() / tileSize; ++row) {
+        for (int column = qMax(0, area.left() / tileSize); column <= area.right() / tileSize; ++column) {
+            if (const QImage *tile = m_engine->tile(column, row))
+                painter.drawImage(column * tileSize, row * tileSize - offset, *tile);
+        }
+    }
+
+    // Asked for after painting, so tiles rendered meanwhile arrive as a new update
+    m_engine->requestTiles(area);
+}
+
+void WebRenderView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    m_engine->setPageWidth(viewport()->width());
+    updateScrollRange();
+}
+
+void WebRenderView::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
+
+void WebRenderView::showEvent(QShowEvent *event)
+{
+    QAbstractScrollArea::showEvent(event);
+    m_engine->setPageWidth(viewport()->width());
+    m_engine->setActive(true);
+}
+
+void WebRenderView::hideEvent(QHideEvent *event)
+{
+    QAbstractScrollArea::hideEvent(event);
+    m_engine->setActive(false);
+}
+
+void WebRenderView::updateScrollRange()
+{
+    QScrollBar *bar = verticalScrollBar();
+    bar->setPageStep(viewport()->height());
+    bar->setRange(0, qMax(0, m_engine->pageHeight() - viewport()->height()));
+    viewport()->update();
+}
+
+void WebRenderView::onAreaChanged(const QRect &area)
+{
+    viewport()->update(area.translated(0, -verticalScrollBar()->value()));
+}
@@ -0,0 +1,33 @@
+#ifndef WEBRENDERVIEW_H
+#define WEBRENDERVIEW_H
+
+#include <QAbstractScrollArea>
+
+class WebRenderEngine;
+
+// Shows the tiles of a WebRenderEngine. The page is as wide as the viewport;
+// only tiles in view are requested, and missing ones stay blank until the
+// engine has rendered them.
+class WebRenderView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit WebRenderView(WebRenderEngine *engine, QWidget *parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void updateScrollRange();
+    void onAreaChanged(const QRect &area);
+
+private:
+    WebRenderEngine *m_engine;
+};
+
+#endif // WEBRENDERVIEW_H
@@ -0,0 +1,297 @@
+#include "WebSearchIndex.h"
+#include "WebElementType.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// How the value of a field is cut into tokens
+enum class Split {
+    Whole,   // ids, links: the value is one token
+    Spaces,  // class lists
+    Words,   // text: runs of letters and digits
+    Style    // declarations: property names and values such as "#333" or "4px"
+};
+
+struct SearchField
+{
+    QLatin1StringView name;
+    Split split;
+};
+
+// The type, then every WebElementField in order
+constexpr SearchField kFields[] = {
+    {"type"_L1, Split::Whole},
+    {"id"_L1, Split::Whole},
+    {"class"_L1, Split::Spaces},
+    {"text"_L1, Split::Words},
+    {"style"_L1, Split::Style},
+    {"href"_L1, Split::Whole},
+    {"src"_L1, Split::Whole},
+    {"alt"_L1, Split::Words},
+};
+
+// Index into kFields, -1 for names that are no field
+int findField(QStringView name)
+{
+    for (int field = 0; field < int(std::size(kFields)); ++field) {
+        if (name.compare(kFields[field].name, Qt::CaseInsensitive) == 0)
+            return field;
+    }
+    return -1;
+}
+
+bool separates(QChar c, Split split)
+{
+    switch (split) {
+    case Split::Whole: return false;
+    case Split::Spaces: return c.isSpace();
+    case Split::Words: return !c.isLetterOrNumber();
+    case Split::Style:
+        return !c.isLetterOrNumber() && c != u'-' && c != u'#' && c != u'.' && c != u'%';
+    }
+    return false;
+}
+
+// Qualified, lower case tokens of one value
+template<typename Add>
+void splitValue(const SearchField &field, QStringView value, Add add)
+{
+    auto addWord = [&](QStringView word) {
+        if (word.isEmpty()) return;
+        QString token = field.name;
+        token += u':';
+        token += word.toString().toLower();
+        add(token);
+    };
+
+    value = value.trimmed();
+    if (field.split == Split::Whole) {
+        addWord(value);
+        return;
+    }
+    qsizetype start = 0;
+    for (qsizetype i = 0; i <= value.size(); ++i) {
+        if (i == value.size() || separates(value[i], field.split)) {
+            addWord(value.sliced(start, i - start));
+            start = i + 1;
+        }
+    }
+}
+
+QList<quintptr> intersect(const QList<quintptr> &a, const QList<quintptr> &b)
+{
+    // Every key of the shorter list is looked up in the longer one, from where the last one was found
+    const QList<quintptr> &shorter = a.size() <= b.size() ? a : b;
+    const QList<quintptr> &longer = a.size() <= b.size() ? b : a;
+    QList<quintptr> keys;
+    keys.reserve(shorter.size());
+    auto from = longer.cbegin();
+    for (quintptr key : shorter) {
+        from = std::lower_bound(from, longer.cend(), key);
+        if (from == longer.cend()) break;
+        if (*from == key)
+            keys.append(key);
+    }
+    return keys;
+}
+}
+
+void WebSearchIndex::clear()
+{
+    m_tokenIds.clear();
+    m_tokens.clear();
+    m_postings.clear();
+    m_freeIds.clear();
+    m_tokensOf.clear();
+}
+
+QList<QString> WebSearchIndex::tokensOf(const WebElementData &element)
+{
+    QList<QString> tokens;
+    auto add = [&tokens](const QString &token) { tokens.append(token); };
+
+    // The type is found by its name without spaces and by its tag
+    QString type = element.type.toLower();
+    type.remove(u' ');
+    splitValue(kFields[0], type, add);
+    splitValue(kFields[0], QString(WebElementTypeInfo::of(WebElementTypeInfo::kindOf(element.type)).tag), add);
+    for (int field = 0; field < WebElementFieldCount; ++field)
+        splitValue(kFields[field + 1], element.value(WebElementField(field)), add);
+
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    return tokens;
+}
+
+quint32 WebSearchIndex::tokenId(const QString &token)
+{
+    auto it = m_tokenIds.constFind(token);
+    if (it != m_tokenIds.constEnd()) return it.value();
+
+    if (!m_freeIds.isEmpty()) {
+        const quint32 id = m_freeIds.takeLast();
+        m_tokenIds.insert(token, id);
+        m_tokens[id] = token;
+        return id;
+    }
+    const quint32 id = quint32(m_postings.size());
+    m_tokenIds.insert(token, id);
+    m_tokens.append(token);
+    m_postings.append(QList<quintptr>());
+    return id;
+}
+
+void WebSearchIndex::releaseToken(quint32 token)
+{
+    // Words nobody holds any more are forgotten, their slot goes to the next new word
+    m_tokenIds.remove(m_tokens.at(token));
+    m_tokens[token] = QString();
+    m_postings[token] = QList<quintptr>();
+    m_freeIds.append(token);
+}
+
+void WebSearchIndex::addPosting(quint32 token, quintptr key)
+{
+    QList<quintptr> &keys = m_postings[token];
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key)
+        keys.insert(it, key);
+}
+
+void WebSearchIndex::removePosting(quint32 token, quintptr key)
+{
+    QList<quintptr> &keys = m_postings[token];
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) return;
+    keys.erase(it);
+    if (keys.isEmpty())
+        releaseToken(token);
+}
+
+void WebSearchIndex::rebuild(const QList<Entry> &entries)
+{
+    clear();
+    m_tokensOf.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        const QList<QString> tokens = tokensOf(entry.element);
+        QList<quint32> ids;
+        ids.reserve(tokens.size());
+        for (const QString &token : tokens) {
+            const quint32 id = tokenId(token);
+            ids.append(id);
+            m_postings[id].append(entry.key);
+        }
+        std::sort(ids.begin(), ids.end());
+        m_tokensOf.insert(entry.key, ids);
+    }
+    for (QList<quintptr> &keys : m_postings)
+        std::sort(keys.begin(), keys.end());
+}
+
+void WebSearchIndex::insert(quintptr key, const WebElementData &element)
+{
+    const QList<QString> tokens = tokensOf(element);
+    QList<quint32> ids;
+    ids.reserve(tokens.size());
+    for (const QString &token : tokens)
+        ids.append(tokenId(token));
+    std::sort(ids.begin(), ids.end());
+
+    // An edit changes a word or two, the long lists of shared tokens are left alone
+    const QList<quint32> old = m_tokensOf.value(key);
+    QList<quint32> removed;
+    QList<quint32> added;
+    std::set_difference(old.cbegin(), old.cend(), ids.cbegin(), ids.cend(), std::back_inserter(removed));
+    std::set_difference(ids.cbegin(), ids.cend(), old.cbegin(), old.cend(), std::back_inserter(added));
+    for (quint32 id : std::as_const(removed))
+        removePosting(id, key);
+    for (quint32 id : std::as_const(added))
+        addPosting(id, key);
+    m_tokensOf.insert(key, ids);
+}
+
+void WebSearchIndex::remove(quintptr key)
+{
+    const QList<quint32> ids = m_tokensOf.take(key);
+    for (quint32 id : ids)
+        removePosting(id, key);
+}
+
+void WebSearchIndex::rekey(quintptr from, quintptr to)
+{
+    if (from == to) return;
+    const QList<quint32> ids = m_tokensOf.take(from);
+    for (quint32 id : ids) {
+        // Adding first keeps the list from running empty and losing its token
+        addPosting(id, to);
+        removePosting(id, from);
+    }
+    m_tokensOf.insert(to, ids);
+}
+
+QList<quintptr> WebSearchIndex::postingsFor(int field, QStringView word) const
+{
+    if (field < 0) {
+        QList<quintptr> keys;
+        for (int searched = 0; searched < int(std::size(kFields)); ++searched) {
+            const QList<quintptr> found = postingsFor(searched, word);
+            if (found.isEmpty()) continue;
+            QList<quintptr> merged;
+            merged.reserve(keys.size() + found.size());
+            std::set_union(keys.cbegin(), keys.cend(), found.cbegin(), found.cend(), std::back_inserter(merged));
+            keys = std::move(merged);
+        }
+        return keys;
+    }
+
+    // A word of several tokens, e.g. text:sign-up, needs all of them
+    QList<quintptr> keys;
+    bool first = true;
+    bool missing = false;
+    splitValue(kFields[field], word, [&](const QString &token) {
+        if (missing) return;
+        auto it = m_tokenIds.constFind(token);
+        if (it == m_tokenIds.constEnd()) {
+            missing = true;
+            return;
+        }
+        keys = first ? m_postings.at(it.value()) : intersect(keys, m_postings.at(it.value()));
+        first = false;
+    });
+    return missing ? QList<quintptr>() : keys;
+}
+
+QList<quintptr> WebSearchIndex::find(QStringView query) const
+{
+    QList<QList<quintptr>> terms;
+    for (QStringView term : query.tokenize(u' ', Qt::SkipEmptyParts)) {
+        int field = -1;
+        QStringView word = term;
+        const qsizetype colon = term.indexOf(u':');
+        if (term.startsWith(u'#')) {
+            field = findField(u"id");
+            word = term.sliced(1);
+        } else if (term.startsWith(u'.')) {
+            field = findField(u"class");
+            word = term.sliced(1);
+        } else if (colon > 0 && findField(term.first(colon)) >= 0) {
+            field = findField(term.first(colon));
+            word = term.sliced(colon + 1);
+        }
+        if (word.isEmpty()) continue;
+
+        terms.append(postingsFor(field, word));
+        if (terms.constLast().isEmpty()) return {};
+    }
+    if (terms.isEmpty()) return {};
+
+    // Starting from the rarest term keeps every intersection short
+    std::sort(terms.begin(), terms.end(),
+              [](const QList<quintptr> &a, const QList<quintptr> &b) { return a.size() < b.size(); });
+    QList<quintptr> keys = terms.constFirst();
+    for (qsizetype i = 1; i < terms.size() && !keys.isEmpty(); ++i)
+        keys = intersect(keys, terms.at(i));
+    return keys;
+}
@@ -0,0 +1,67 @@
+#ifndef WEBSEARCHINDEX_H
+#define WEBSEARCHINDEX_H
+
+#include "WebElementData.h"
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Inverted index from the words of elements to the elements holding them,
+// so a query costs as much as its rarest word, not as much as the design.
+// Every token is lower case and qualified by the field it came from
+// ("type:button", "class:cta", "text:sign"); posting lists are kept sorted.
+//
+// Queries are words separated by spaces, an element has to match all of
+// them:
+//   button, cta       any field holding the word
+//   type:button       the type name or tag, e.g. "heading1" or "h1"
+//   #header, .cta     id and class, the same as id:header and class:cta
+//   text:sign         any field by name: id, class, text, style, href, src, alt
+//
+// Elements are identified by an opaque key, the same way as in WebEdgeIndex.
+class WebSearchIndex
+{
+public:
+    struct Entry
+    {
+        quintptr key;
+        WebElementData element;
+    };
+
+    qsizetype size() const { return m_tokensOf.size(); }
+    bool contains(quintptr key) const { return m_tokensOf.contains(key); }
+
+    void clear();
+    // Replaces everything, sorting every posting list once
+    void rebuild(const QList<Entry> &entries);
+    // Adds the element or replaces what was indexed for the key
+    void insert(quintptr key, const WebElementData &element);
+    void remove(quintptr key);
+    // The element keeps its tokens under another key
+    void rekey(quintptr from, quintptr to);
+
+    // Keys of the elements matching every word of the query, in key order.
+    // An empty query matches nothing.
+    QList<quintptr> find(QStringView query) const;
+
+    // Qualified tokens of an element, each once
+    static QList<QString> tokensOf(const WebElementData &element);
+
+private:
+    quint32 tokenId(const QString &token);
+    void addPosting(quint32 token, quintptr key);
+    void removePosting(quint32 token, quintptr key);
+    void releaseToken(quint32 token);
+    // Sorted keys holding the word in a field, or in any field for -1
+    QList<quintptr> postingsFor(int field, QStringView word) const;
+
+    QHash<QString, quint32> m_tokenIds;
+    // Indexed by token id; released ids have an empty token and no postings
+    QList<QString> m_tokens;
+    QList<QList<quintptr>> m_postings;
+    QList<quint32> m_freeIds;
+    QHash<quintptr, QList<quint32>> m_tokensOf;
+};
+
+#endif // WEBSEARCHINDEX_H
@@ -0,0 +1,62 @@
+#include "WebStringPool.h"
+#include <QMutex>
+#include <QSet>
+
+namespace {
+// Pools smaller than this are never pruned
+constexpr qsizetype kMinimumPruneSize = 1024;
+
+struct Pool
+{
+    QMutex mutex;
+    QSet<QString> values;
+    qsizetype pruneAt = kMinimumPruneSize;
+
+    void prune()
+    {
+        // A value only the pool holds is no longer shared, interning it again is cheap
+        for (auto it = values.begin(); it != values.end();) {
+            if (it->isDetached())
+                it = values.erase(it);
+            else
+                ++it;
+        }
+        pruneAt = qMax(kMinimumPruneSize, values.size() * 2);
+    }
+};
+
+Pool &pool()
+{
+    static Pool instance;
+    return instance;
+}
+}
+
+QString WebStringPool::intern(const QString &value)
+{
+    // Empty strings share no data anyway
+    if (value.isEmpty()) return QString();
+
+    Pool &p = pool();
+    const QMutexLocker locker(&p.mutex);
+    auto it = p.values.constFind(value);
+    if (it != p.values.constEnd()) return *it;
+
+    if (p.values.size() >= p.pruneAt)
+        p.prune();
+    return *p.values.insert(value);
+}
+
+qsizetype WebStringPool::size()
+{
+    Pool &p = pool();
+    const QMutexLocker locker(&p.mutex);
+    return p.values.size();
+}
+
+void WebStringPool::prune()
+{
+    Pool &p = pool();
+    const QMutexLocker locker(&p.mutex);
+    p.prune();
+}
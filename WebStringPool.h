@@ -0,0 +1,22 @@
+#ifndef WEBSTRINGPOOL_H
+#define WEBSTRINGPOOL_H
+
+#include <QString>
+
+// Interns the short values that repeat across a design: type names, class
+// lists and styles. Interned strings share one copy of their data, so a
+// hundred thousand "Container" elements hold one string between them.
+// Thread safe, designs are also decoded on worker threads.
+class WebStringPool
+{
+public:
+    // A string equal to value that shares the pooled copy's data
+    static QString intern(const QString &value);
+    // Distinct values currently pooled
+    static qsizetype size();
+    // Drops values nothing outside the pool refers to anymore. Also runs on
+    // its own whenever the pool has doubled since the last time.
+    static void prune();
+};
+
+#endif // WEBSTRINGPOOL_H
@@ -0,0 +1,337 @@
+#include "WebStyleEngine.h"
+#include "WebCssParser.h"
+#include "WebDesignScene.h"
+#include "WebElementItem.h"
+#include "WebProfiler.h"
+#include <QColor>
+#include <QSet>
+#include <iterator>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr quint16 kFontProperties = WebStyle::FontFamily | WebStyle::FontSize | WebStyle::FontWeight | WebStyle::FontStyle;
+// Border width when a border style is given without one, CSS "medium"
+constexpr qreal kMediumBorderWidth = 3;
+
+// The properties a style passes on to its children
+WebStyle inheritedPart(const WebStyle &style)
+{
+    WebStyle inherited;
+    inherited.inherit(style);
+    return inherited;
+}
+
+WebStyleSubject subjectOf(WebElementItem *item, const QString &id, const QString &cls, const WebStyleSubject *parent)
+{
+    return WebStyleSubject{WebElementTypeInfo::of(item->elementKind()).tag, id, cls, parent};
+}
+
+QFont resolveFont(const WebStyle &style)
+{
+    QFont font;
+    if (style.has(WebStyle::FontFamily)) {
+        // Generic families have no font of that name, the hint picks one
+        const QString family = style.fontFamily.toLower();
+        if (family == "serif"_L1) font.setStyleHint(QFont::Serif);
+        else if (family == "sans-serif"_L1) font.setStyleHint(QFont::SansSerif);
+        else if (family == "monospace"_L1) font.setStyleHint(QFont::Monospace);
+        else if (family == "cursive"_L1) font.setStyleHint(QFont::Cursive);
+        else if (family == "fantasy"_L1) font.setStyleHint(QFont::Fantasy);
+        font.setFamily(style.fontFamily);
+    }
+    if (style.has(WebStyle::FontSize))
+        font.setPixelSize(qMax(1, qRound(style.fontSize)));
+    if (style.has(WebStyle::FontWeight))
+        font.setWeight(QFont::Weight(qBound(1, int(style.fontWeight), 1000)));
+    if (style.has(WebStyle::FontStyle))
+        font.setItalic(style.italic);
+    return font;
+}
+
+std::shared_ptr<const WebElementStyle> resolve(const WebStyle &style)
+{
+    auto resolved = std::make_shared<WebElementStyle>();
+    resolved->computed = style;
+
+    if (style.has(WebStyle::BackgroundColor)) {
+        const QColor color = QColor::fromRgba(style.backgroundColor);
+        resolved->fill = QBrush(color);
+        resolved->selectedFill = QBrush(color.lighter(110));
+    }
+    if (style.has(WebStyle::Color))
+        resolved->text = QPen(QColor::fromRgba(style.color));
+
+    // As in CSS, a border needs a style; its color defaults to the text color
+    const qreal width = style.has(WebStyle::BorderWidth) ? style.borderWidth : kMediumBorderWidth;
+    if (style.has(WebStyle::BorderStyle) && style.borderStyle != WebStyle::NoBorder && width > 0) {
+        QColor color = Qt::black;
+        if (style.has(WebStyle::BorderColor))
+            color = QColor::fromRgba(style.borderColor);
+        else if (style.has(WebStyle::Color))
+            color = QColor::fromRgba(style.color);
+
+        Qt::PenStyle penStyle = Qt::SolidLine;
+        if (style.borderStyle == WebStyle::DashedBorder) penStyle = Qt::DashLine;
+        else if (style.borderStyle == WebStyle::DottedBorder) penStyle = Qt::DotLine;
+
+        resolved->border = QPen(color, width, penStyle, Qt::SquareCap, Qt::MiterJoin);
+    }
+
+    if (style.defined & kFontProperties)
+        resolved->font = resolveFont(style);
+    return resolved;
+}
+}
+
+bool WebElementStyle::hasFont() const
+{
+    return computed.defined & kFontProperties;
+}
+
+WebStyleEngine::WebStyleEngine(WebDesignScene *scene, QObject *parent)
+    : QObject(parent), m_scene(scene)
+{
+    connectScene();
+}
+
+void WebStyleEngine::setScene(WebDesignScene *scene)
+{
+    if (scene == m_scene) return;
+
+    disconnect(m_scene, nullptr, this, nullptr);
+    m_scene = scene;
+    connectScene();
+    // A cached scene kept the styles of an older sheet
+    restyleAll();
+}
+
+void WebStyleEngine::connectScene()
+{
+    connect(m_scene, &WebDesignScene::elementAdded, this, &WebStyleEngine::onElementAdded);
+    connect(m_scene, &WebDesignScene::elementMaterialized, this, [this](qsizetype, WebElementItem *item) {
+        onElementAdded(item);
+    });
+    connect(m_scene, &WebDesignScene::elementRemoved, this, &WebStyleEngine::onElementRemoved);
+    connect(m_scene, &WebDesignScene::elementChanged, this, &WebStyleEngine::onElementChanged);
+    connect(m_scene, &WebDesignScene::elementParentChanged, this, [this](WebElementItem *item) {
+        restyleFromAncestors(item);
+    });
+    connect(m_scene, &WebDesignScene::sceneCleared, this, &WebStyleEngine::onSceneCleared);
+    connect(m_scene, &WebDesignScene::sceneLoaded, this, &WebStyleEngine::restyleAll);
+}
+
+void WebStyleEngine::setStyleSheet(const QString &css)
+{
+    if (css == m_css) return;
+    const WebProfileScope scope("style/sheet");
+
+    WebStyleSheet sheet = WebCssParser::parseStyleSheet(css);
+    const QList<WebCssRule> &oldRules = m_sheet.rules();
+    const QList<WebCssRule> &newRules = sheet.rules();
+
+    // Rules are told apart by their text. While the rules both sheets share stay
+    // in the same order they cascade as before, so only the elements reachable
+    // through the key of an added or removed rule can change
+    QSet<QString> changedKeys;
+    auto shared = [&changedKeys](const QList<WebCssRule> &rules, const QList<WebCssRule> &others) {
+        QHash<QString, qsizetype> available;
+        for (const WebCssRule &rule : others)
+            ++available[rule.signature];
+
+        QStringList kept;
+        for (const WebCssRule &rule : rules) {
+            auto it = available.find(rule.signature);
+            if (it != available.end() && it.value() > 0) {
+                --it.value();
+                kept.append(rule.signature);
+            } else {
+                changedKeys.insert(WebStyleSheet::ruleKey(rule));
+            }
+        }
+        return kept;
+    };
+    const bool sameOrder = shared(oldRules, newRules) == shared(newRules, oldRules);
+
+    m_sheet = std::move(sheet);
+    m_css = css;
+
+    if (!sameOrder || changedKeys.contains(u"*"_s)) {
+        restyleAll();
+        return;
+    }
+
+    QSet<WebElementItem*> affected;
+    for (const QString &key : std::as_const(changedKeys)) {
+        auto it = m_itemsByKey.constFind(key);
+        if (it != m_itemsByKey.constEnd())
+            affected.unite(it.value());
+    }
+    for (WebElementItem *item : std::as_const(affected))
+        restyleFromAncestors(item);
+}
+
+void WebStyleEngine::restyleAll()
+{
+    const WebProfileScope scope("style/restyleAll");
+
+    m_itemsByKey.clear();
+    m_entries.clear();
+    for (qsizetype slot = 0; slot < m_scene->elementCount(); ++slot) {
+        if (WebElementItem *item = m_scene->elementAt(slot))
+            index(item);
+    }
+
+    for (qsizetype slot = 0; slot < m_scene->elementCount(); ++slot) {
+        WebElementItem *item = m_scene->elementAt(slot);
+        if (!item || item->parentElement()) continue;
+
+        const QString id = item->elementId();
+        const QString cls = item->elementClass();
+        restyle(item, subjectOf(item, id, cls, nullptr), true);
+    }
+}
+
+void WebStyleEngine::onElementAdded(WebElementItem *item)
+{
+    index(item);
+    restyleFromAncestors(item);
+}
+
+void WebStyleEngine::onElementRemoved(WebElementItem *item)
+{
+    unindex(item);
+}
+
+void WebStyleEngine::onElementChanged(WebElementItem *item)
+{
+    auto it = m_entries.constFind(item);
+    if (it != m_entries.constEnd()) {
+        // Text edits leave the style alone
+        const QStringList keys = WebStyleSheet::subjectKeys(WebElementTypeInfo::of(item->elementKind()).tag,
+                                                            item->elementId(), item->elementClass());
+        if (keys == it->keys && item->elementStyle() == it->style)
+            return;
+        unindex(item);
+    }
+    onElementAdded(item);
+}
+
+void WebStyleEngine::onSceneCleared()
+{
+    m_itemsByKey.clear();
+    m_entries.clear();
+}
+
+void WebStyleEngine::index(WebElementItem *item)
+{
+    IndexEntry entry;
+    entry.keys = WebStyleSheet::subjectKeys(WebElementTypeInfo::of(item->elementKind()).tag,
+                                            item->elementId(), item->elementClass());
+    entry.style = item->elementStyle();
+    for (const QString &key : std::as_const(entry.keys))
+        m_itemsByKey[key].insert(item);
+    m_entries.insert(item, entry);
+}
+
+void WebStyleEngine::unindex(WebElementItem *item)
+{
+    auto it = m_entries.find(item);
+    if (it == m_entries.end()) return;
+
+    for (const QString &key : std::as_const(it->keys)) {
+        auto bucket = m_itemsByKey.find(key);
+        if (bucket == m_itemsByKey.end()) continue;
+        bucket->remove(item);
+        if (bucket->isEmpty())
+            m_itemsByKey.erase(bucket);
+    }
+    m_entries.erase(it);
+}
+
+void WebStyleEngine::restyleFromAncestors(WebElementItem *item)
+{
+    // Descendant and child selectors look up the chain, so every ancestor gets a subject
+    QList<WebElementItem*> path;
+    for (WebElementItem *ancestor = item; ancestor; ancestor = ancestor->parentElement())
+        path.prepend(ancestor);
+
+    QStringList ids;
+    QStringList classes;
+    QList<WebStyleSubject> subjects;
+    ids.reserve(path.size());
+    classes.reserve(path.size());
+    // Reserved up front, subjects point at the one before them
+    subjects.reserve(path.size());
+    for (qsizetype i = 0; i < path.size(); ++i) {
+        ids.append(path.at(i)->elementId());
+        classes.append(path.at(i)->elementClass());
+        subjects.append(subjectOf(path.at(i), ids.constLast(), classes.constLast(),
+                                  i > 0 ? &subjects.at(i - 1) : nullptr));
+    }
+    restyle(item, subjects.constLast(), false);
+}
+
+void WebStyleEngine::restyle(WebElementItem *item, const WebStyleSubject &subject, bool wholeSubtree)
+{
+    // Cascade, then the style attribute, then what the parent passes on
+    WebStyle style = m_sheet.computeStyle(subject);
+    style.merge(inlineStyle(item->elementStyle()));
+    if (WebElementItem *parent = item->parentElement()) {
+        if (const std::shared_ptr<const WebElementStyle> &parentStyle = parent->computedStyle())
+            style.inherit(parentStyle->computed);
+    }
+
+    const WebStyle previous = item->computedStyle() ? item->computedStyle()->computed : WebStyle();
+    if (style != previous) {
+        item->setComputedStyle(style.isEmpty() ? nullptr : sharedStyle(style));
+        emit elementRestyled(item);
+    }
+
+    // Children only change with what they inherit, or, once selectors have
+    // combinators, with what this element matches
+    if (!item->hasChildElements()) return;
+    if (!wholeSubtree && !m_sheet.hasCombinators() && inheritedPart(style) == inheritedPart(previous))
+        return;
+
+    const QList<QGraphicsItem*> children = item->childItems();
+    for (QGraphicsItem *child : children) {
+        WebElementItem *element = static_cast<WebElementItem*>(child);
+        const QString id = element->elementId();
+        const QString cls = element->elementClass();
+        restyle(element, subjectOf(element, id, cls, &subject), wholeSubtree);
+    }
+}
+
+WebStyle WebStyleEngine::inlineStyle(const QString &style)
+{
+    if (style.isEmpty()) return WebStyle();
+
+    // Many elements repeat the same style attribute
+    auto it = m_inlineStyles.constFind(style);
+    if (it != m_inlineStyles.constEnd())
+        return it.value();
+
+    if (m_inlineStyles.size() >= InlineCacheSize)
+        m_inlineStyles.clear();
+    WebStyle parsed = WebCssParser::parseDeclarations(style);
+    m_inlineStyles.insert(style, parsed);
+    return parsed;
+}
+
+std::shared_ptr<const WebElementStyle> WebStyleEngine::sharedStyle(const WebStyle &style)
+{
+    auto it = m_sharedStyles.constFind(style);
+    if (it != m_sharedStyles.constEnd())
+        return it.value();
+
+    // Styles no element uses anymore are only held here
+    if (m_sharedStyles.size() >= SharedStylePruneSize) {
+        for (auto it = m_sharedStyles.begin(); it != m_sharedStyles.end();)
+            it = it.value().use_count() == 1 ? m_sharedStyles.erase(it) : std::next(it);
+    }
+
+    std::shared_ptr<const WebElementStyle> resolved = resolve(style);
+    m_sharedStyles.insert(style, resolved);
+    return resolved;
+}
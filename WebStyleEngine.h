@@ -0,0 +1,94 @@
+#ifndef WEBSTYLEENGINE_H
+#define WEBSTYLEENGINE_H
+
+#include "WebStyleSheet.h"
+#include <QBrush>
+#include <QFont>
+#include <QHash>
+#include <QObject>
+#include <QPen>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+class WebDesignScene;
+class WebElementItem;
+
+// What an element paints with once its CSS is resolved. Elements with the
+// same computed style share one instance.
+struct WebElementStyle
+{
+    WebStyle computed;
+    QBrush fill;
+    QBrush selectedFill;
+    QPen border{Qt::NoPen};
+    QPen text;
+    QFont font;
+
+    bool hasFill() const { return computed.has(WebStyle::BackgroundColor); }
+    bool hasBorder() const { return border.style() != Qt::NoPen; }
+    bool hasTextColor() const { return computed.has(WebStyle::Color); }
+    bool hasFont() const;
+};
+
+// Applies the global style sheet and inline styles to the canvas. Elements are
+// indexed under the same keys the sheet files its rules under (#id, .class,
+// tag), so an edit of the sheet only restyles the elements that an added or
+// removed rule can reach, and an edit of an element only restyles it and, if
+// inherited properties changed, its subtree.
+class WebStyleEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WebStyleEngine(WebDesignScene *scene, QObject *parent = nullptr);
+
+    const WebStyleSheet &styleSheet() const { return m_sheet; }
+
+    // Follows another scene; its elements are restyled against the current sheet
+    void setScene(WebDesignScene *scene);
+
+    signals:
+        // The computed style of item changed
+        void elementRestyled(WebElementItem *item);
+
+public slots:
+    void setStyleSheet(const QString &css);
+    void restyleAll();
+
+private slots:
+    void onElementAdded(WebElementItem *item);
+    void onElementRemoved(WebElementItem *item);
+    void onElementChanged(WebElementItem *item);
+    void onSceneCleared();
+
+private:
+    struct IndexEntry
+    {
+        QStringList keys;
+        QString style;
+    };
+
+    // Bounds for the caches of parsed inline styles and shared paint styles
+    static constexpr qsizetype InlineCacheSize = 4096;
+    static constexpr qsizetype SharedStylePruneSize = 1024;
+
+    void connectScene();
+    void index(WebElementItem *item);
+    void unindex(WebElementItem *item);
+    void restyleFromAncestors(WebElementItem *item);
+    void restyle(WebElementItem *item, const WebStyleSubject &subject, bool wholeSubtree);
+    WebStyle inlineStyle(const QString &style);
+    std::shared_ptr<const WebElementStyle> sharedStyle(const WebStyle &style);
+
+    WebDesignScene *m_scene;
+    QString m_css;
+    WebStyleSheet m_sheet;
+    QHash<QString, QSet<WebElementItem*>> m_itemsByKey;
+    QHash<WebElementItem*, IndexEntry> m_entries;
+    QHash<QString, WebStyle> m_inlineStyles;
+    QHash<WebStyle, std::shared_ptr<const WebElementStyle>> m_sharedStyles;
+};
+
+#endif // WEBSTYLEENGINE_H
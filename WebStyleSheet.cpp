@@ -0,0 +1,159 @@
+#include "WebStyleSheet.h"
+#include <QHashFunctions>
+#include <algorithm>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// Ids outweigh any number of classes, classes any number of tags
+constexpr quint32 kIdSpecificity = 1u << 20;
+constexpr quint32 kClassSpecificity = 1u << 10;
+constexpr quint32 kTagSpecificity = 1u;
+
+const QString kUniversalKey = u"*"_s;
+}
+
+void WebStyle::merge(const WebStyle &other, quint16 properties)
+{
+    if (properties & BackgroundColor) backgroundColor = other.backgroundColor;
+    if (properties & Color) color = other.color;
+    if (properties & FontFamily) fontFamily = other.fontFamily;
+    if (properties & FontSize) fontSize = other.fontSize;
+    if (properties & FontWeight) fontWeight = other.fontWeight;
+    if (properties & FontStyle) italic = other.italic;
+    if (properties & BorderWidth) borderWidth = other.borderWidth;
+    if (properties & BorderStyle) borderStyle = other.borderStyle;
+    if (properties & BorderColor) borderColor = other.borderColor;
+    if (properties & Width) width = other.width;
+    if (properties & Height) height = other.height;
+    defined |= properties;
+}
+
+bool operator==(const WebStyle &a, const WebStyle &b)
+{
+    return a.defined == b.defined && a.backgroundColor == b.backgroundColor && a.color == b.color
+           && a.borderColor == b.borderColor && a.fontFamily == b.fontFamily && a.fontSize == b.fontSize
+           && a.fontWeight == b.fontWeight && a.italic == b.italic && a.borderStyle == b.borderStyle
+           && a.borderWidth == b.borderWidth && a.width == b.width && a.height == b.height;
+}
+
+size_t qHash(const WebStyle &style, size_t seed)
+{
+    return qHashMulti(seed, style.defined, style.backgroundColor, style.color, style.borderColor,
+                      style.fontFamily, style.fontSize, style.fontWeight, style.italic,
+                      quint8(style.borderStyle), style.borderWidth, style.width, style.height);
+}
+
+bool WebStyleSubject::hasClass(QStringView name) const
+{
+    for (QStringView cls : classes.tokenize(QChar(u' '), Qt::SkipEmptyParts)) {
+        if (cls == name)
+            return true;
+    }
+    return false;
+}
+
+bool WebCssCompound::matches(const WebStyleSubject &subject) const
+{
+    if (!tag.isEmpty() && tag != subject.tag) return false;
+    if (!id.isEmpty() && id != subject.id) return false;
+    for (const QString &cls : classes) {
+        if (!subject.hasClass(cls))
+            return false;
+    }
+    return true;
+}
+
+bool WebCssSelector::matches(const WebStyleSubject &subject) const
+{
+    // Right to left, the rightmost compound is the cheapest to reject
+    const qsizetype last = compounds.size() - 1;
+    return last >= 0 && compounds.at(last).matches(subject) && matchesLeftOf(last, subject);
+}
+
+bool WebCssSelector::matchesLeftOf(qsizetype index, const WebStyleSubject &subject) const
+{
+    if (index == 0) return true;
+
+    const WebCssCompound &left = compounds.at(index - 1);
+    if (compounds.at(index).combinator == WebCssCompound::Child) {
+        const WebStyleSubject *parent = subject.parent;
+        return parent && left.matches(*parent) && matchesLeftOf(index - 1, *parent);
+    }
+
+    for (const WebStyleSubject *ancestor = subject.parent; ancestor; ancestor = ancestor->parent) {
+        if (left.matches(*ancestor) && matchesLeftOf(index - 1, *ancestor))
+            return true;
+    }
+    return false;
+}
+
+void WebStyleSheet::addRule(const WebCssRule &rule)
+{
+    WebCssRule compiled = rule;
+    compiled.selector.specificity = 0;
+    for (const WebCssCompound &compound : std::as_const(compiled.selector.compounds)) {
+        if (!compound.id.isEmpty()) compiled.selector.specificity += kIdSpecificity;
+        compiled.selector.specificity += compound.classes.size() * kClassSpecificity;
+        if (!compound.tag.isEmpty()) compiled.selector.specificity += kTagSpecificity;
+    }
+    m_hasCombinators = m_hasCombinators || compiled.selector.compounds.size() > 1;
+
+    m_index[ruleKey(compiled)].append(m_rules.size());
+    m_rules.append(compiled);
+}
+
+WebStyle WebStyleSheet::computeStyle(const WebStyleSubject &subject) const
+{
+    WebStyle style;
+    if (m_rules.isEmpty()) return style;
+
+    // Each rule sits under one key, so no rule is collected twice
+    QList<qsizetype> matched;
+    auto collect = [&](const QString &key) {
+        auto it = m_index.constFind(key);
+        if (it == m_index.constEnd()) return;
+        for (qsizetype rule : it.value()) {
+            if (m_rules.at(rule).selector.matches(subject))
+                matched.append(rule);
+        }
+    };
+    const QStringList keys = subjectKeys(subject.tag, subject.id, subject.classes);
+    for (const QString &key : keys)
+        collect(key);
+    collect(kUniversalKey);
+
+    // Cascade order: specificity, then position in the sheet
+    std::sort(matched.begin(), matched.end(), [this](qsizetype a, qsizetype b) {
+        quint32 specificityA = m_rules.at(a).selector.specificity;
+        quint32 specificityB = m_rules.at(b).selector.specificity;
+        return specificityA != specificityB ? specificityA < specificityB : a < b;
+    });
+    for (qsizetype rule : std::as_const(matched))
+        style.merge(m_rules.at(rule).style);
+    return style;
+}
+
+QString WebStyleSheet::ruleKey(const WebCssRule &rule)
+{
+    const WebCssCompound &subject = rule.selector.compounds.constLast();
+    if (!subject.id.isEmpty()) return u"#"_s + subject.id;
+    if (!subject.classes.isEmpty()) return u"."_s + subject.classes.constFirst();
+    if (!subject.tag.isEmpty()) return subject.tag;
+    return kUniversalKey;
+}
+
+QStringList WebStyleSheet::subjectKeys(QLatin1StringView tag, QStringView id, QStringView classes)
+{
+    QStringList keys;
+    keys.append(QString(tag));
+    if (!id.isEmpty())
+        keys.append(u"#"_s + id.toString());
+    for (QStringView cls : classes.tokenize(QChar(u' '), Qt::SkipEmptyParts)) {
+        QString key = u"."_s + cls.toString();
+        // A class typed twice would collect its rules twice
+        if (!keys.contains(key))
+            keys.append(key);
+    }
+    return keys;
+}
@@ -0,0 +1,144 @@
+#ifndef WEBSTYLESHEET_H
+#define WEBSTYLESHEET_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// The subset of CSS the canvas can show, compiled from declarations. Only
+// properties flagged in `defined` were set; lengths are in pixels and colors
+// are 0xAARRGGBB like WebElementTypeInfo::color.
+struct WebStyle
+{
+    enum Property : quint16 {
+        BackgroundColor = 0x001,
+        Color = 0x002,
+        FontFamily = 0x004,
+        FontSize = 0x008,
+        FontWeight = 0x010,
+        FontStyle = 0x020,
+        BorderWidth = 0x040,
+        BorderStyle = 0x080,
+        BorderColor = 0x100,
+        Width = 0x200,
+        Height = 0x400
+    };
+
+    // Passed on from a container to its children unless they set them
+    static constexpr quint16 InheritedProperties = Color | FontFamily | FontSize | FontWeight | FontStyle;
+
+    enum Border : quint8 {
+        NoBorder,
+        SolidBorder,
+        DashedBorder,
+        DottedBorder
+    };
+
+    quint16 defined = 0;
+    quint32 backgroundColor = 0;
+    quint32 color = 0;
+    quint32 borderColor = 0;
+    QString fontFamily;
+    qreal fontSize = 0;
+    quint16 fontWeight = 400;
+    bool italic = false;
+    Border borderStyle = NoBorder;
+    qreal borderWidth = 0;
+    qreal width = 0;
+    qreal height = 0;
+
+    bool has(Property property) const { return defined & property; }
+    bool isEmpty() const { return defined == 0; }
+
+    // Properties set in other replace the ones here, as a later or more specific rule does
+    void merge(const WebStyle &other) { merge(other, other.defined); }
+    // Takes the inherited properties this style leaves open from the parent's computed style
+    void inherit(const WebStyle &parent) { merge(parent, parent.defined & InheritedProperties & ~defined); }
+
+    friend bool operator==(const WebStyle &a, const WebStyle &b);
+    friend bool operator!=(const WebStyle &a, const WebStyle &b) { return !(a == b); }
+
+private:
+    void merge(const WebStyle &other, quint16 properties);
+};
+
+size_t qHash(const WebStyle &style, size_t seed = 0);
+
+// What selectors look at of one element. Subjects link to their parent's so
+// descendant and child selectors can walk up; they are built on the stack.
+struct WebStyleSubject
+{
+    QLatin1StringView tag;
+    QStringView id;
+    QStringView classes; // space separated, as typed into the class field
+    const WebStyleSubject *parent = nullptr;
+
+    bool hasClass(QStringView name) const;
+};
+
+// One compound selector such as div.card#main, with the combinator that
+// relates it to the compound on its left
+struct WebCssCompound
+{
+    enum Combinator : quint8 {
+        None,
+        Descendant,
+        Child
+    };
+
+    QString tag; // empty for the universal selector
+    QString id;
+    QStringList classes;
+    Combinator combinator = None;
+
+    bool matches(const WebStyleSubject &subject) const;
+};
+
+struct WebCssSelector
+{
+    QList<WebCssCompound> compounds; // left to right
+    quint32 specificity = 0;
+
+    bool matches(const WebStyleSubject &subject) const;
+
+private:
+    bool matchesLeftOf(qsizetype index, const WebStyleSubject &subject) const;
+};
+
+struct WebCssRule
+{
+    WebCssSelector selector;
+    WebStyle style;
+    // Selector and declarations as written, compares rules across edits of the sheet
+    QString signature;
+};
+
+// Compiled global style sheet. Rules are filed under the most selective part
+// of their rightmost compound (id, else a class, else the tag), so matching
+// an element only looks at the rules that name its id, classes or tag.
+class WebStyleSheet
+{
+public:
+    void addRule(const WebCssRule &rule);
+
+    const QList<WebCssRule> &rules() const { return m_rules; }
+    bool isEmpty() const { return m_rules.isEmpty(); }
+    // True when some selector depends on ancestors, restyling then covers subtrees
+    bool hasCombinators() const { return m_hasCombinators; }
+
+    // Cascaded rules for the subject, without inline style and inheritance
+    WebStyle computeStyle(const WebStyleSubject &subject) const;
+
+    // The key a rule is filed under: "#id", ".class", the tag, or "*"
+    static QString ruleKey(const WebCssRule &rule);
+    // Every key an element can be reached through, the counterpart of ruleKey
+    static QStringList subjectKeys(QLatin1StringView tag, QStringView id, QStringView classes);
+
+private:
+    QList<WebCssRule> m_rules;
+    QHash<QString, QList<qsizetype>> m_index;
+    bool m_hasCombinators = false;
+};
+
+#endif // WEBSTYLESHEET_H
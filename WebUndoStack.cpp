@@ -0,0 +1,203 @@
+#include "WebUndoStack.h"
+#include <QAction>
+#include <QIcon>
+#include <QKeySequence>
+#include <ranges>
+
+void WebMacroCommand::append(std::unique_ptr<WebUndoCommand> command)
+{
+    m_commands.push_back(std::move(command));
+}
+
+std::unique_ptr<WebUndoCommand> WebMacroCommand::takeFirst()
+{
+    std::unique_ptr<WebUndoCommand> command = std::move(m_commands.front());
+    m_commands.erase(m_commands.begin());
+    return command;
+}
+
+void WebMacroCommand::undo()
+{
+    for (auto &command : std::views::reverse(m_commands))
+        command->undo();
+}
+
+void WebMacroCommand::redo()
+{
+    for (auto &command : m_commands)
+        command->redo();
+}
+
+qsizetype WebMacroCommand::byteSize() const
+{
+    qsizetype size = sizeof(*this);
+    for (const auto &command : m_commands)
+        size += command->byteSize();
+    return size;
+}
+
+WebUndoStack::WebUndoStack(QObject *parent)
+    : QObject(parent), m_index(0), m_memoryLimit(DefaultMemoryLimit), m_memoryUsage(0),
+      m_macroDepth(0)
+{
+}
+
+WebUndoStack::~WebUndoStack() = default;
+
+void WebUndoStack::push(WebUndoCommand *command)
+{
+    std::unique_ptr<WebUndoCommand> owned(command);
+    owned->redo();
+
+    if (m_macro) {
+        m_macro->append(std::move(owned));
+        return;
+    }
+    record(std::move(owned));
+}
+
+void WebUndoStack::beginMacro(const QString &text)
+{
+    if (m_macroDepth++ == 0)
+        m_macro = std::make_unique<WebMacroCommand>(text);
+}
+
+void WebUndoStack::endMacro()
+{
+    if (m_macroDepth == 0 || --m_macroDepth > 0) return;
+
+    // A macro of one command is recorded as that command, so it can still merge
+    std::unique_ptr<WebMacroCommand> macro = std::move(m_macro);
+    if (macro->count() == 1)
+        record(macro->takeFirst());
+    else if (macro->count() > 1)
+        record(std::move(macro));
+}
+
+void WebUndoStack::record(std::unique_ptr<WebUndoCommand> command)
+{
+    // A new edit discards whatever could have been redone
+    while (qsizetype(m_commands.size()) > m_index) {
+        m_memoryUsage -= m_commands.back()->byteSize();
+        m_commands.pop_back();
+    }
+
+    WebUndoCommand *top = m_commands.empty() ? nullptr : m_commands.back().get();
+    if (top && command->id() != -1 && top->id() == command->id()) {
+        qsizetype before = top->byteSize();
+        if (top->mergeWith(command.get())) {
+            m_memoryUsage += top->byteSize() - before;
+            trim();
+            emitState();
+            return;
+        }
+    }
+
+    m_memoryUsage += command->byteSize();
+    m_commands.push_back(std::move(command));
+    m_index = qsizetype(m_commands.size());
+    trim();
+    emitState();
+}
+
+void WebUndoStack::trim()
+{
+    // The newest command is always kept, even when it alone exceeds the limit
+    while (m_memoryUsage > m_memoryLimit && m_commands.size() > 1 && m_index > 1) {
+        m_memoryUsage -= m_commands.front()->byteSize();
+        m_commands.pop_front();
+        --m_index;
+    }
+}
+
+void WebUndoStack::setMemoryLimit(qsizetype bytes)
+{
+    m_memoryLimit = bytes;
+    trim();
+    emitState();
+}
+
+QString WebUndoStack::undoText() const
+{
+    return canUndo() ? m_commands.at(m_index - 1)->text() : QString();
+}
+
+QString WebUndoStack::redoText() const
+{
+    return canRedo() ? m_commands.at(m_index)->text() : QString();
+}
+
+void WebUndoStack::undo()
+{
+    if (!canUndo() || m_macro) return;
+
+    m_commands.at(--m_index)->undo();
+    emitState();
+}
+
+void WebUndoStack::redo()
+{
+    if (!canRedo() || m_macro) return;
+
+    m_commands.at(m_index++)->redo();
+    emitState();
+}
+
+void WebUndoStack::clear()
+{
+    m_commands.clear();
+    m_macro.reset();
+    m_macroDepth = 0;
+    m_index = 0;
+    m_memoryUsage = 0;
+    emitState();
+}
+
+void WebUndoStack::emitState()
+{
+    emit indexChanged(m_index);
+    emit canUndoChanged(canUndo());
+    emit canRedoChanged(canRedo());
+    emit undoTextChanged(undoText());
+    emit redoTextChanged(redoText());
+}
+
+QAction *WebUndoStack::createUndoAction(QObject *parent) const
+{
+    QAction *action = new QAction(tr("Undo"), parent);
+    action->setIcon(QIcon::fromTheme("edit-undo"));
+    action->setShortcut(QKeySequence::Undo);
+    bindUndoAction(action);
+    return action;
+}
+
+QAction *WebUndoStack::createRedoAction(QObject *parent) const
+{
+    QAction *action = new QAction(tr("Redo"), parent);
+    action->setIcon(QIcon::fromTheme("edit-redo"));
+    action->setShortcut(QKeySequence::Redo);
+    bindRedoAction(action);
+    return action;
+}
+
+void WebUndoStack::bindUndoAction(QAction *action) const
+{
+    auto updateText = [action](const QString &text) {
+        action->setText(text.isEmpty() ? tr("Undo") : tr("Undo %1").arg(text));
+    };
+    action->setEnabled(canUndo());
+    updateText(undoText());
+    connect(this, &WebUndoStack::canUndoChanged, action, &QAction::setEnabled);
+    connect(this, &WebUndoStack::undoTextChanged, action, updateText);
+}
+
+void WebUndoStack::bindRedoAction(QAction *action) const
+{
+    auto updateText = [action](const QString &text) {
+        action->setText(text.isEmpty() ? tr("Redo") : tr("Redo %1").arg(text));
+    };
+    action->setEnabled(canRedo());
+    updateText(redoText());
+    connect(this, &WebUndoStack::canRedoChanged, action, &QAction::setEnabled);
+    connect(this, &WebUndoStack::redoTextChanged, action, updateText);
+}
@@ -0,0 +1,107 @@
+#ifndef WEBUNDOSTACK_H
+#define WEBUNDOSTACK_H
+
+#include <QObject>
+#include <QUndoCommand>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QAction;
+
+// Base of every recorded edit. Commands keep only what is needed to go back
+// and forth (a slot and the changed values) and report how much memory that
+// takes, so the stack can bound the size of the history.
+class WebUndoCommand : public QUndoCommand
+{
+public:
+    using QUndoCommand::QUndoCommand;
+
+    virtual qsizetype byteSize() const = 0;
+
+protected:
+    static qsizetype stringBytes(const QString &value) { return value.size() * qsizetype(sizeof(char16_t)); }
+};
+
+// A group of commands undone and redone as one step, see WebUndoStack::beginMacro
+class WebMacroCommand : public WebUndoCommand
+{
+public:
+    explicit WebMacroCommand(const QString &text) { setText(text); }
+
+    void append(std::unique_ptr<WebUndoCommand> command);
+    qsizetype count() const { return qsizetype(m_commands.size()); }
+    std::unique_ptr<WebUndoCommand> takeFirst();
+
+    void undo() override;
+    void redo() override;
+    qsizetype byteSize() const override;
+
+private:
+    std::vector<std::unique_ptr<WebUndoCommand>> m_commands;
+};
+
+// Undo history in the style of QUndoStack. Unlike QUndoStack, which can only
+// cap the number of commands, it caps the memory held by the commands and
+// drops the oldest ones once the limit is exceeded.
+class WebUndoStack : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WebUndoStack(QObject *parent = nullptr);
+    ~WebUndoStack() override;
+
+    // Runs the command's redo() and records it, merging it into the previous command if possible
+    void push(WebUndoCommand *command);
+
+    // Commands pushed between these calls are executed right away and recorded as one step
+    void beginMacro(const QString &text);
+    void endMacro();
+
+    bool canUndo() const { return m_index > 0; }
+    bool canRedo() const { return m_index < qsizetype(m_commands.size()); }
+    QString undoText() const;
+    QString redoText() const;
+
+    qsizetype count() const { return qsizetype(m_commands.size()); }
+    qsizetype index() const { return m_index; }
+
+    qsizetype memoryLimit() const { return m_memoryLimit; }
+    void setMemoryLimit(qsizetype bytes);
+    qsizetype memoryUsage() const { return m_memoryUsage; }
+
+    QAction *createUndoAction(QObject *parent) const;
+    QAction *createRedoAction(QObject *parent) const;
+    // Keep an existing action in sync with this stack, for actions that switch between stacks
+    void bindUndoAction(QAction *action) const;
+    void bindRedoAction(QAction *action) const;
+
+    static constexpr qsizetype DefaultMemoryLimit = 32 * 1024 * 1024;
+
+public slots:
+    void undo();
+    void redo();
+    void clear();
+
+    signals:
+        void indexChanged(qsizetype index);
+        void canUndoChanged(bool canUndo);
+        void canRedoChanged(bool canRedo);
+        void undoTextChanged(const QString &text);
+        void redoTextChanged(const QString &text);
+
+private:
+    void record(std::unique_ptr<WebUndoCommand> command);
+    void trim();
+    void emitState();
+
+    std::deque<std::unique_ptr<WebUndoCommand>> m_commands;
+    qsizetype m_index;
+    qsizetype m_memoryLimit;
+    qsizetype m_memoryUsage;
+    std::unique_ptr<WebMacroCommand> m_macro;
+    int m_macroDepth;
+};
+
+#endif // WEBUNDOSTACK_H
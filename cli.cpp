@@ -0,0 +1,57 @@
+#include "WebBatchConverter.h"
+#include "WebHtmlExporter.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+
+// Command line front end of the core library: converts one design or a whole
+// directory of designs to HTML without loading any GUI module.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("webdesigner-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts .webdesign and .json designs to HTML. Projects of several pages\n"
+                                     "are written as a site, into a directory named after the HTML file.");
+    parser.addHelpOption();
+    QCommandLineOption jobsOption({"j", "jobs"}, "Number of parallel conversions, all cores by default.", "count");
+    parser.addOption(jobsOption);
+    parser.addPositionalArgument("input", "A design file or a directory of design files.");
+    parser.addPositionalArgument("output", "The HTML file, or the directory the HTML files are written to.");
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2)
+        parser.showHelp(2);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (!QFileInfo(args.at(0)).isDir()) {
+        QString error;
+        if (!WebHtmlExporter::exportDesign(args.at(0), args.at(1), &error)) {
+            err << args.at(0) << ": " << error << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    WebBatchConverter converter(parser.value(jobsOption).toInt());
+    QElapsedTimer timer;
+    timer.start();
+    const QList<WebBatchResult> results = converter.convertDirectory(args.at(0), args.at(1));
+
+    qsizetype failed = 0;
+    for (const WebBatchResult &result : results) {
+        if (result.ok) continue;
+        err << result.designFile << ": " << result.error << "\n";
+        ++failed;
+    }
+
+    out << "Converted " << results.size() - failed << " of " << results.size() << " designs in "
+        << timer.elapsed() << " ms using " << converter.threadCount() << " threads\n";
+    return failed ? 1 : 0;
+}
@@ -1,8 +1,43 @@
 #include "mainwindow.h"
+#include "WebHtmlExporter.h"
+#include "WebBenchmark.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QTextStream>
+
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream err(stderr);
+
+    qsizetype index = args.indexOf("--export");
+    if (index < 0 || index + 2 >= args.size()) {
+        err << "Usage: " << args.first() << " --export <design.webdesign> <output.html>\n";
+        return 2;
+    }
+
+    QString error;
+    if (!WebHtmlExporter::exportDesign(args.at(index + 1), args.at(index + 2), &error)) {
+        err << args.at(index + 1) << ": " << error << "\n";
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    // Build farms run conversions without a display, so skip the GUI entirely
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--export") == 0)
+            return runHeadless(argc, argv);
+        if (qstrcmp(argv[i], "--benchmark") == 0) {
+            QApplication app(argc, argv);
+            QStringList args = app.arguments();
+            return runBenchmarks(args.mid(args.indexOf("--benchmark") + 1));
+        }
+    }
+
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 
@@ -1,30 +1,61 @@
 #include "mainwindow.h"
 #include "ui_MainWindow.h"
 #include "WebDesignScene.h"
+#include "WebComponent.h"
 #include "WebElementProperties.h"
-
+#include "WebPreviewEngine.h"
+#include "WebStyleEngine.h"
+#include "WebHtmlExporter.h"
+#include "WebElementItem.h"
+#include "WebUndoStack.h"
+#include "WebAutosave.h"
+#include "WebPerformanceDock.h"
+#include "WebPageCache.h"
+#include "WebRenderEngine.h"
+#include "WebRenderView.h"
+#include "WebOutlineModel.h"
+#include "WebProfiler.h"
+
+#include <QDockWidget>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QHash>
+#include <QInputDialog>
+#include <QMenu>
 #include <QMessageBox>
-#include <QJsonDocument>
-#include <QJsonArray>
 #include <QStandardPaths>
+#include <QScrollBar>
+#include <QSet>
+#include <QSignalBlocker>
+#include <QStatusBar>
+#include <QTimer>
+#include <QToolButton>
+#include <QTreeView>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , designScene(nullptr)
+    , documentFormat(WebDesignSerializer::BinaryFormat)
 {
     ui->setupUi(this);
     setWindowTitle(tr("Qt Web Designer 6.8"));
     resize(1400, 900);
 
-    createToolBar();
     createWidgets();
+    createToolBar();
     createConnections();
     setupElementsList();
+
+    // Ask about a crashed session once the window is up
+    QTimer::singleShot(0, this, &MainWindow::recoverAutosave);
 }
 
 MainWindow::~MainWindow()
 {
+    // A clean shutdown leaves nothing to recover
+    autosave->discard();
     delete ui;
 }
 
@@ -44,34 +75,477 @@ void MainWindow::createToolBar()
     exportAction->setIcon(QIcon::fromTheme("text-html"));
     connect(exportAction, &QAction::triggered, this, &MainWindow::exportHtml);
 
+    QAction *exportSiteAction = toolBar->addAction(tr("Export Site"));
+    exportSiteAction->setIcon(QIcon::fromTheme("folder-html"));
+    connect(exportSiteAction, &QAction::triggered, this, &MainWindow::exportSite);
+
     QAction *clearAction = toolBar->addAction(tr("Clear"));
     clearAction->setIcon(QIcon::fromTheme("edit-clear"));
     connect(clearAction, &QAction::triggered, this, &MainWindow::clearCanvas);
 
     toolBar->addSeparator();
 
+    // Every page has its own history, the actions follow the scene that is shown
+    undoAction = designScene->undoStack()->createUndoAction(this);
+    toolBar->addAction(undoAction);
+    connect(undoAction, &QAction::triggered, this, &MainWindow::undo);
+
+    redoAction = designScene->undoStack()->createRedoAction(this);
+    toolBar->addAction(redoAction);
+    connect(redoAction, &QAction::triggered, this, &MainWindow::redo);
+
+    toolBar->addSeparator();
+
+    // Hiding a container hides everything inside it
+    QAction *hideAction = toolBar->addAction(tr("Hide"));
+    hideAction->setIcon(QIcon::fromTheme("view-hidden"));
+    connect(hideAction, &QAction::triggered, this, [this] { designScene->hideSelection(); });
+
+    QAction *showAllAction = toolBar->addAction(tr("Show All"));
+    showAllAction->setIcon(QIcon::fromTheme("view-visible"));
+    connect(showAllAction, &QAction::triggered, this, [this] { designScene->showAllElements(); });
+
+    // Arranging needs a selection of several elements, see onSelectionChanged
+    QMenu *arrangeMenu = new QMenu(this);
+    const WebArrange::Operation operations[] = {
+        WebArrange::AlignLeft, WebArrange::AlignHorizontalCenter, WebArrange::AlignRight,
+        WebArrange::AlignTop, WebArrange::AlignVerticalCenter, WebArrange::AlignBottom,
+        WebArrange::DistributeHorizontally, WebArrange::DistributeVertically,
+        WebArrange::MatchWidth, WebArrange::MatchHeight, WebArrange::MatchSize
+    };
+    for (WebArrange::Operation operation : operations) {
+        if (operation == WebArrange::AlignTop || operation == WebArrange::DistributeHorizontally
+            || operation == WebArrange::MatchWidth)
+            arrangeMenu->addSeparator();
+        QAction *action = arrangeMenu->addAction(WebArrange::text(operation));
+        connect(action, &QAction::triggered, this, [this, operation] {
+            propertiesPanel->commitPendingChanges();
+            designScene->arrangeSelection(operation);
+        });
+    }
+    arrangeButton = new QToolButton(this);
+    arrangeButton->setText(tr("Arrange"));
+    arrangeButton->setIcon(QIcon::fromTheme("align-horizontal-left"));
+    arrangeButton->setToolButtonStyle(toolBar->toolButtonStyle());
+    arrangeButton->setPopupMode(QToolButton::InstantPopup);
+    arrangeButton->setMenu(arrangeMenu);
+    arrangeButton->setEnabled(false);
+    toolBar->addWidget(arrangeButton);
+
+    snapAction = toolBar->addAction(tr("Snap"));
+    snapAction->setIcon(QIcon::fromTheme("snap-orthogonal"));
+    snapAction->setCheckable(true);
+    snapAction->setChecked(designScene->snapEnabled());
+    snapAction->setToolTip(tr("Snap dragged elements to the edges and centers of the others"));
+    connect(snapAction, &QAction::toggled, this, [this](bool enabled) { designScene->setSnapEnabled(enabled); });
+
+    toolBar->addSeparator();
+
+    QAction *addPageAction = toolBar->addAction(tr("Add Page"));
+    addPageAction->setIcon(QIcon::fromTheme("document-new"));
+    connect(addPageAction, &QAction::triggered, this, &MainWindow::addPage);
+
+    removePageAction = toolBar->addAction(tr("Remove Page"));
+    removePageAction->setIcon(QIcon::fromTheme("edit-delete"));
+    removePageAction->setEnabled(project.pageCount() > 1);
+    connect(removePageAction, &QAction::triggered, this, &MainWindow::removePage);
+
+    toolBar->addSeparator();
+
+    // Both follow the selection, see onSelectionChanged
+    createComponentAction = toolBar->addAction(tr("Create Component"));
+    createComponentAction->setIcon(QIcon::fromTheme("insert-object"));
+    createComponentAction->setToolTip(tr("Make the selected element and its content a reusable component"));
+    createComponentAction->setEnabled(false);
+    connect(createComponentAction, &QAction::triggered, this, &MainWindow::createComponent);
+
+    updateComponentAction = toolBar->addAction(tr("Update Component"));
+    updateComponentAction->setIcon(QIcon::fromTheme("view-refresh"));
+    updateComponentAction->setToolTip(tr("Make the selected instance the component's master copy for every page"));
+    updateComponentAction->setEnabled(false);
+    connect(updateComponentAction, &QAction::triggered, this, &MainWindow::updateComponent);
+
+    toolBar->addSeparator();
+
+    QAction *performanceAction = performanceDock->toggleViewAction();
+    performanceAction->setIcon(QIcon::fromTheme("utilities-system-monitor"));
+    toolBar->addAction(performanceAction);
+
+    QAction *renderAction = renderDock->toggleViewAction();
+    renderAction->setIcon(QIcon::fromTheme("document-print-preview"));
+    toolBar->addAction(renderAction);
+
     QAction *aboutAction = toolBar->addAction(tr("About"));
     connect(aboutAction, &QAction::triggered, this, &MainWindow::showAbout);
+
+    // Queries such as "type:button .cta" select every matching element, see WebSearchIndex
+    QToolBar *findBar = addToolBar(tr("Find"));
+    searchEdit = new QLineEdit(findBar);
+    searchEdit->setPlaceholderText(tr("Find elements, e.g. type:button .cta"));
+    searchEdit->setClearButtonEnabled(true);
+    searchEdit->setMaximumWidth(320);
+    findBar->addWidget(searchEdit);
+    connect(searchEdit, &QLineEdit::returnPressed, this, &MainWindow::findElements);
+
+    QAction *findAction = new QAction(tr("Find Elements"), this);
+    findAction->setShortcut(QKeySequence::Find);
+    connect(findAction, &QAction::triggered, this, [this] {
+        searchEdit->setFocus();
+        searchEdit->selectAll();
+    });
+    addAction(findAction);
 }
 
 void MainWindow::createWidgets()
 {
-    designScene = new WebDesignScene(this);
+    // Only the pages opened last have a scene, the others are kept as blobs
+    pageCache = new WebPageCache(WebPageCache::DefaultCapacity, this);
+    designScene = pageCache->acquire(project, project.activePage());
     ui->designView->setScene(designScene);
-    ui->designView->setRenderHint(QPainter::Antialiasing);
+    // Elements are axis-aligned boxes, antialiasing them only costs frame time
+    ui->designView->setRenderHint(QPainter::Antialiasing, false);
     ui->designView->setDragMode(QGraphicsView::RubberBandDrag);
 
+    // Mapped designs create their items only for the part of the canvas that is visible
+    connect(ui->designView->horizontalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::materializeVisibleElements);
+    connect(ui->designView->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::materializeVisibleElements);
+    ui->designView->viewport()->installEventFilter(this);
+
     propertiesPanel = new WebElementProperties(this);
     ui->rightPanel->layout()->addWidget(propertiesPanel);
+
+    previewEngine = new WebPreviewEngine(designScene, propertiesPanel, ui->htmlPreview, this);
+    styleEngine = new WebStyleEngine(designScene, this);
+    autosave = new WebAutosave(designScene, propertiesPanel, &project, this);
+
+    performanceDock = new WebPerformanceDock(designScene, this);
+    addDockWidget(Qt::RightDockWidgetArea, performanceDock);
+    performanceDock->hide();
+
+    // Rendered only while the dock is open, see WebRenderView
+    renderEngine = new WebRenderEngine(designScene, styleEngine, this);
+    renderDock = new QDockWidget(tr("Rendered Preview"), this);
+    renderDock->setObjectName("renderDock");
+    renderDock->setWidget(new WebRenderView(renderEngine));
+    addDockWidget(Qt::RightDockWidgetArea, renderDock);
+    renderDock->hide();
+
+    pagesList = new QListWidget;
+    QDockWidget *pagesDock = new QDockWidget(tr("Pages"), this);
+    pagesDock->setObjectName("pagesDock");
+    pagesDock->setWidget(pagesList);
+    addDockWidget(Qt::LeftDockWidgetArea, pagesDock);
+    refreshPageList();
+
+    // Double clicking a component inserts an instance of it
+    componentsList = new QListWidget;
+    QDockWidget *componentsDock = new QDockWidget(tr("Components"), this);
+    componentsDock->setObjectName("componentsDock");
+    componentsDock->setWidget(componentsList);
+    addDockWidget(Qt::LeftDockWidgetArea, componentsDock);
+    refreshComponentList();
+
+    // Rows are fetched as they scroll into view, see WebOutlineModel
+    outlineModel = new WebOutlineModel(designScene, this);
+    outlineView = new QTreeView;
+    outlineView->setModel(outlineModel);
+    outlineView->setHeaderHidden(true);
+    outlineView->setUniformRowHeights(true);
+    outlineView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    outlineDock = new QDockWidget(tr("Outline"), this);
+    outlineDock->setObjectName("outlineDock");
+    outlineDock->setWidget(outlineView);
+    addDockWidget(Qt::LeftDockWidgetArea, outlineDock);
 }
 
 void MainWindow::createConnections()
 {
-    connect(designScene, &WebDesignScene::elementSelected,
-            this, &MainWindow::onElementSelected);
+    connectScene();
 
     connect(propertiesPanel, &WebElementProperties::propertiesChanged,
             this, &MainWindow::updateHtmlPreview);
+    // The engine ignores the signal unless the global CSS itself changed
+    connect(propertiesPanel, &WebElementProperties::propertiesChanged, this, [this] {
+        styleEngine->setStyleSheet(propertiesPanel->getGlobalCss());
+    });
+
+    connect(autosave, &WebAutosave::autosaveFailed, this, [this](const QString &error) {
+        statusBar()->showMessage(tr("Autosave failed: %1").arg(error), 5000);
+    });
+
+    connect(pagesList, &QListWidget::currentRowChanged, this, &MainWindow::showPage);
+    connect(pagesList, &QListWidget::itemChanged, this, &MainWindow::renamePage);
+    connect(componentsList, &QListWidget::itemActivated, this, &MainWindow::insertComponent);
+    connect(componentsList, &QListWidget::itemChanged, this, &MainWindow::renameComponent);
+
+    // The model is reset with every load, the selection model stays the same
+    connect(outlineView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &MainWindow::onOutlineSelectionChanged);
+    connect(outlineDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible)
+            syncOutlineSelection();
+    });
+}
+
+void MainWindow::connectScene()
+{
+    // Rubber band selections change it too, not only clicks
+    connect(designScene, &QGraphicsScene::selectionChanged,
+            this, &MainWindow::onSelectionChanged);
+
+    // The panel keeps raw pointers to the edited elements, let go of them before they are deleted
+    connect(designScene, &WebDesignScene::sceneCleared,
+            propertiesPanel, &WebElementProperties::clear);
+    connect(designScene, &WebDesignScene::elementRemoved,
+            propertiesPanel, &WebElementProperties::removeElement);
+    connect(designScene, &WebDesignScene::elementTextEdited, this, [this](WebElementItem *item) {
+        if (propertiesPanel->isEditing(item))
+            propertiesPanel->refresh();
+    });
+}
+
+void MainWindow::setActiveScene(WebDesignScene *scene)
+{
+    if (scene == designScene) return;
+
+    propertiesPanel->clear();
+    disconnect(designScene, nullptr, this, nullptr);
+    disconnect(designScene, nullptr, propertiesPanel, nullptr);
+    disconnect(designScene->undoStack(), nullptr, undoAction, nullptr);
+    disconnect(designScene->undoStack(), nullptr, redoAction, nullptr);
+
+    designScene = scene;
+    designScene->setSnapEnabled(snapAction->isChecked());
+    ui->designView->setScene(designScene);
+    previewEngine->setScene(designScene);
+    styleEngine->setScene(designScene);
+    autosave->setScene(designScene);
+    performanceDock->setScene(designScene);
+    renderEngine->setScene(designScene);
+    outlineModel->setScene(designScene);
+    designScene->undoStack()->bindUndoAction(undoAction);
+    designScene->undoStack()->bindRedoAction(redoAction);
+    connectScene();
+    // A cached page comes back with the selection it was left with
+    onSelectionChanged();
+
+    materializeVisibleElements();
+}
+
+void MainWindow::storeActivePage()
+{
+    // Only the open page can differ from its blob, every other page was stored when it was left
+    propertiesPanel->commitPendingChanges();
+    project.setElements(project.activePage(), designScene->snapshot());
+    project.setProperties(propertiesPanel->getGlobalProperties());
+}
+
+void MainWindow::openProject(const WebProject &loaded, const QSharedPointer<WebDesignMapping> &mapping)
+{
+    // Scenes of the previous design are deleted once nothing shows them anymore
+    pageCache->clear();
+    project = loaded;
+    propertiesPanel->setGlobalProperties(project.properties());
+
+    WebDesignScene *scene = pageCache->acquire(project, project.activePage());
+    if (mapping)
+        scene->loadMapped(mapping);
+    setActiveScene(scene);
+    refreshPageList();
+    refreshComponentList();
+}
+
+void MainWindow::refreshPageList()
+{
+    const QSignalBlocker blocker(pagesList);
+    pagesList->clear();
+    for (qsizetype i = 0; i < project.pageCount(); ++i) {
+        QListWidgetItem *item = new QListWidgetItem(project.page(i).name, pagesList);
+        item->setFlags(item->flags() | Qt::ItemIsEditable);
+    }
+    pagesList->setCurrentRow(int(project.activePage()));
+    if (removePageAction)
+        removePageAction->setEnabled(project.pageCount() > 1);
+}
+
+void MainWindow::showPage(int index)
+{
+    if (index < 0 || index >= project.pageCount() || index == project.activePage()) return;
+
+    const WebProfileScope scope("mainwindow/showPage");
+    storeActivePage();
+    project.setActivePage(index);
+    setActiveScene(pageCache->acquire(project, index));
+
+    const QSignalBlocker blocker(pagesList);
+    pagesList->setCurrentRow(index);
+}
+
+void MainWindow::addPage()
+{
+    const qsizetype index = project.addPage(tr("Page %1").arg(project.pageCount() + 1));
+    refreshPageList();
+    showPage(int(index));
+}
+
+void MainWindow::removePage()
+{
+    if (project.pageCount() <= 1) return;
+
+    const qsizetype index = project.activePage();
+    QMessageBox::StandardButton answer = QMessageBox::question(
+        this, tr("Remove Page"),
+        tr("Remove the page \"%1\" and everything on it? This cannot be undone.").arg(project.page(index).name));
+    if (answer != QMessageBox::Yes) return;
+
+    // Move to a neighbour first, the scene of the removed page is deleted
+    const quint32 id = project.page(index).id;
+    showPage(int(index > 0 ? index - 1 : 1));
+    project.removePage(project.indexOf(id));
+    pageCache->remove(id);
+    refreshPageList();
+    autosave->snapshotNow();
+}
+
+void MainWindow::renamePage(QListWidgetItem *item)
+{
+    const int index = pagesList->row(item);
+    const QString name = item->text().trimmed();
+    if (index < 0 || name == project.page(index).name) return;
+
+    // A page needs a name to be told apart, an empty one is undone
+    if (name.isEmpty()) {
+        const QSignalBlocker blocker(pagesList);
+        item->setText(project.page(index).name);
+        return;
+    }
+    project.renamePage(index, name);
+    autosave->snapshotNow();
+}
+
+void MainWindow::refreshComponentList()
+{
+    const QSignalBlocker blocker(componentsList);
+    componentsList->clear();
+    for (const WebComponent &component : project.components().components()) {
+        QListWidgetItem *item = new QListWidgetItem(component.name, componentsList);
+        item->setData(Qt::UserRole, component.id);
+        item->setFlags(item->flags() | Qt::ItemIsEditable);
+    }
+}
+
+void MainWindow::createComponent()
+{
+    const QList<WebElementItem*> selection = designScene->selectedElements();
+    if (selection.isEmpty()) return;
+    propertiesPanel->commitPendingChanges();
+
+    // The first selected element that is not inside another one, with its whole subtree
+    const QSet<WebElementItem*> selected(selection.cbegin(), selection.cend());
+    WebElementItem *root = selection.constFirst();
+    for (WebElementItem *item : selection) {
+        if (!selected.contains(item->parentElement())) {
+            root = item;
+            break;
+        }
+    }
+
+    bool ok = false;
+    const QString name = QInputDialog::getText(this, tr("Create Component"), tr("Name:"),
+                                               QLineEdit::Normal, root->elementType(), &ok).trimmed();
+    if (!ok || name.isEmpty()) return;
+
+    // Parents come before their children, so each one is numbered by the time it is looked up
+    const QList<WebElementItem*> items = designScene->subtree(root);
+    QHash<const WebElementItem*, qint32> indexOf;
+    indexOf.reserve(items.size());
+    QList<WebElementData> elements;
+    elements.reserve(items.size());
+    for (WebElementItem *item : items) {
+        WebElementData data = item->elementData();
+        data.parent = indexOf.value(item->parentElement(), -1);
+        indexOf.insert(item, qint32(elements.size()));
+        elements.append(data);
+    }
+
+    // The elements become the first instance and share their fields with the master copy
+    WebComponentLibrary &library = project.components();
+    const quint32 id = library.add(name, elements);
+    for (qsizetype i = 0; i < items.size(); ++i)
+        items.at(i)->setComponent(id, qint32(i), 0, library.fields(id, qint32(i)));
+
+    refreshComponentList();
+    onSelectionChanged();
+    autosave->snapshotNow();
+}
+
+void MainWindow::updateComponent()
+{
+    propertiesPanel->commitPendingChanges();
+
+    WebElementItem *instance = nullptr;
+    const QList<WebElementItem*> selection = designScene->selectedElements();
+    for (WebElementItem *item : selection) {
+        if (item->isInstance()) {
+            instance = item;
+            break;
+        }
+    }
+    if (!instance) return;
+
+    // The other parts are in the subtree of the instance's root
+    const quint32 id = instance->component();
+    WebElementItem *root = instance;
+    while (root->componentPart() != 0 && root->parentElement() && root->parentElement()->component() == id)
+        root = root->parentElement();
+
+    const WebProfileScope scope("mainwindow/updateComponent");
+    WebComponentLibrary &library = project.components();
+    QList<WebElementItem*> parts;
+    const QList<WebElementItem*> items = designScene->subtree(root);
+    for (WebElementItem *item : items) {
+        if (item->component() != id) continue;
+        WebElementFields fields;
+        for (int field = 0; field < WebElementFieldCount; ++field)
+            fields.setValue(WebElementField(field), item->elementField(WebElementField(field)));
+        library.setFields(id, item->componentPart(), fields);
+        parts.append(item);
+    }
+    for (WebElementItem *item : std::as_const(parts))
+        item->setComponent(id, item->componentPart(), 0, library.fields(id, item->componentPart()));
+
+    // Open pages follow in one pass each, the others resolve their instances when loaded or exported
+    const QList<WebDesignScene*> scenes = pageCache->scenes();
+    for (WebDesignScene *scene : scenes)
+        scene->followComponent(id);
+
+    propertiesPanel->refresh();
+    autosave->snapshotNow();
+}
+
+void MainWindow::insertComponent(QListWidgetItem *item)
+{
+    propertiesPanel->commitPendingChanges();
+    const QPointF center = ui->designView->mapToScene(ui->designView->viewport()->rect().center());
+    designScene->insertComponent(item->data(Qt::UserRole).toUInt(), center);
+}
+
+void MainWindow::renameComponent(QListWidgetItem *item)
+{
+    const quint32 id = item->data(Qt::UserRole).toUInt();
+    const WebComponent *component = project.components().find(id);
+    if (!component) return;
+
+    const QString name = item->text().trimmed();
+    if (name.isEmpty()) {
+        const QSignalBlocker blocker(componentsList);
+        item->setText(component->name);
+        return;
+    }
+    project.components().rename(id, name);
+    autosave->snapshotNow();
 }
 
 void MainWindow::setupElementsList()
@@ -87,54 +561,115 @@ void MainWindow::setupElementsList()
     ui->elementsList->setDefaultDropAction(Qt::CopyAction);
 }
 
-void MainWindow::onElementSelected(QGraphicsItem *item)
+void MainWindow::onSelectionChanged()
 {
-    propertiesPanel->setCurrentElement(item);
+    const WebProfileScope scope("mainwindow/selection");
+    const QList<WebElementItem*> selection = designScene->selectedElements();
+    propertiesPanel->setSelection(selection);
+    arrangeButton->setEnabled(selection.size() > 1);
+    createComponentAction->setEnabled(!selection.isEmpty());
+    updateComponentAction->setEnabled(std::any_of(selection.cbegin(), selection.cend(),
+                                                  [](WebElementItem *item) { return item->isInstance(); }));
+    syncOutlineSelection();
 }
 
-void MainWindow::updateHtmlPreview()
+void MainWindow::syncOutlineSelection()
 {
-    QJsonObject project = designScene->toJson();
-    QString html = "<!DOCTYPE html>\n<html>\n<head>\n<title>Generated Page</title>\n";
+    // A closed outline catches up when it is shown again
+    if (syncingSelection || !outlineDock->isVisible()) return;
+    const WebProfileScope scope("mainwindow/syncOutline");
+    syncingSelection = true;
+
+    QItemSelection selection;
+    const QList<WebElementItem*> selected = designScene->selectedElements();
+    for (WebElementItem *item : selected) {
+        const QModelIndex index = outlineModel->indexOf(item);
+        if (index.isValid())
+            selection.select(index, index);
+    }
+    outlineView->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
+    if (!selected.isEmpty())
+        outlineView->scrollTo(outlineModel->indexOf(selected.constFirst()));
 
-    // Add CSS
-    html += "<style>\n";
-    html += "body { font-family: Arial, sans-serif; margin: 20px; }\n";
-    html += propertiesPanel->getGlobalCss();
-    html += "\n</style>\n</head>\n<body>\n";
+    syncingSelection = false;
+}
 
-    // Add elements
-    QJsonArray elements = project["elements"].toArray();
-    for (const QJsonValue &element : elements) {
-        html += propertiesPanel->generateHtml(element.toObject()) + "\n";
+void MainWindow::onOutlineSelectionChanged()
+{
+    if (syncingSelection) return;
+    const WebProfileScope scope("mainwindow/outlineSelection");
+    syncingSelection = true;
+
+    // Picking a pending record in the outline materializes it
+    QList<WebElementItem*> items;
+    const QModelIndexList rows = outlineView->selectionModel()->selectedIndexes();
+    for (const QModelIndex &index : rows) {
+        if (WebElementItem *item = outlineModel->elementAt(index))
+            items.append(item);
     }
+    designScene->selectElements(items);
+    if (!items.isEmpty())
+        ui->designView->ensureVisible(items.constFirst());
 
-    html += "\n</body>\n</html>";
+    syncingSelection = false;
+}
 
-    ui->htmlPreview->setPlainText(html);
+void MainWindow::findElements()
+{
+    const WebProfileScope scope("mainwindow/findElements");
+    propertiesPanel->commitPendingChanges();
+
+    // The panel follows through onSelectionChanged
+    const QString query = searchEdit->text().trimmed();
+    const QList<WebElementItem*> found = query.isEmpty() ? QList<WebElementItem*>() : designScene->findElements(query);
+    designScene->selectElements(found);
+    if (!found.isEmpty())
+        ui->designView->ensureVisible(found.constFirst());
+    statusBar()->showMessage(tr("%n element(s) found", nullptr, int(found.size())), 3000);
+}
+
+void MainWindow::updateHtmlPreview()
+{
+    const WebProfileScope scope("mainwindow/updateHtmlPreview");
+    previewEngine->refresh();
 }
 
 void MainWindow::saveDesign()
 {
+    const QString binaryFilter = tr("Web Design Files (*.webdesign)");
+    const QString jsonFilter = tr("Web Design JSON Files (*.json)");
+    QString selectedFilter = documentFormat == WebDesignSerializer::JsonFormat ? jsonFilter : binaryFilter;
+
     QString fileName = QFileDialog::getSaveFileName(
         this,
         tr("Save Design"),
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
-        tr("Web Design Files (*.webdesign)"));
+        binaryFilter + ";;" + jsonFilter,
+        &selectedFilter);
 
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::warning(this, tr("Error"), tr("Could not save file"));
-        return;
+    const WebProfileScope scope("file/save");
+    // The file is replaced by renaming over it, which Windows refuses while it
+    // is still mapped for the records of a design that are not loaded yet
+    const QFileInfo target(fileName);
+    const QList<WebDesignScene*> scenes = pageCache->scenes();
+    for (WebDesignScene *scene : scenes) {
+        if (scene->pendingElementCount() > 0 && QFileInfo(scene->mappedFileName()) == target)
+            scene->materializeAll();
     }
+    storeActivePage();
 
-    QJsonObject project = designScene->toJson();
-    project["properties"] = propertiesPanel->getGlobalProperties();
+    WebDesignSerializer::Format format = selectedFilter == jsonFilter
+        ? WebDesignSerializer::JsonFormat : WebDesignSerializer::BinaryFormat;
 
-    file.write(QJsonDocument(project).toJson());
-    file.close();
+    QString error;
+    if (!WebProject::write(fileName, project, format, &error)) {
+        QMessageBox::warning(this, tr("Error"), tr("Could not save file: %1").arg(error));
+        return;
+    }
+    documentFormat = format;
+    autosave->setProjectFile(fileName);
 }
 
 void MainWindow::loadDesign()
@@ -143,30 +678,96 @@ void MainWindow::loadDesign()
         this,
         tr("Load Design"),
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
-        tr("Web Design Files (*.webdesign)"));
+        tr("Web Design Files (*.webdesign *.json)"));
 
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
-        QMessageBox::warning(this, tr("Error"), tr("Could not open file"));
-        return;
+    const WebProfileScope scope("file/load");
+
+    // Single page binary designs are mapped and materialized as they scroll into view,
+    // the page blob is filled from the scene the first time the page is stored
+    QString error;
+    if (WebDesignSerializer::detectFileFormat(fileName) == WebDesignSerializer::BinaryFormat) {
+        QSharedPointer<WebDesignMapping> mapping(new WebDesignMapping);
+        if (!mapping->open(fileName, &error)) {
+            QMessageBox::warning(this, tr("Error"), tr("Invalid design file: %1").arg(error));
+            return;
+        }
+        WebProject loaded;
+        loaded.setProperties(mapping->properties());
+        openProject(loaded, mapping);
+        documentFormat = WebDesignSerializer::BinaryFormat;
+    } else {
+        WebProject loaded;
+        if (!WebProject::read(fileName, &loaded, &documentFormat, &error)) {
+            QMessageBox::warning(this, tr("Error"), tr("Invalid design file: %1").arg(error));
+            return;
+        }
+        openProject(loaded);
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (doc.isNull()) {
-        QMessageBox::warning(this, tr("Error"), tr("Invalid design file"));
-        return;
-    }
+    // Scenes are new, no history of the previous design carries over
+    autosave->setProjectFile(fileName);
 
-    QJsonObject project = doc.object();
-    designScene->fromJson(project["elements"].toArray());
-    propertiesPanel->setGlobalProperties(project["properties"].toObject());
+    materializeVisibleElements();
+}
 
+void MainWindow::undo()
+{
+    // Edits still waiting in the panel become the newest step before anything is undone
+    propertiesPanel->commitPendingChanges();
+    designScene->undoStack()->undo();
+    propertiesPanel->refresh();
     updateHtmlPreview();
 }
 
+void MainWindow::redo()
+{
+    propertiesPanel->commitPendingChanges();
+    designScene->undoStack()->redo();
+    propertiesPanel->refresh();
+    updateHtmlPreview();
+}
+
+void MainWindow::recoverAutosave()
+{
+    QString projectFile;
+    if (WebAutosave::hasRecovery(&projectFile)) {
+        QString name = projectFile.isEmpty() ? tr("an untitled design") : QFileInfo(projectFile).fileName();
+        QMessageBox::StandardButton answer = QMessageBox::question(
+            this, tr("Recover Design"),
+            tr("Qt Web Designer did not shut down properly. Recover the unsaved changes to %1?").arg(name));
+
+        WebProject recovered;
+        QString error;
+        if (answer == QMessageBox::Yes) {
+            if (WebAutosave::recover(projectFile, &recovered, &error)) {
+                openProject(recovered);
+                autosave->setProjectFile(projectFile);
+                autosave->snapshotNow();
+                return;
+            }
+            QMessageBox::warning(this, tr("Error"), tr("Could not recover the design: %1").arg(error));
+        }
+    }
+
+    // Start journaling the new, empty design
+    autosave->setProjectFile(QString());
+}
+
+void MainWindow::materializeVisibleElements()
+{
+    QRect viewport = ui->designView->viewport()->rect();
+    designScene->materialize(ui->designView->mapToScene(viewport).boundingRect());
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->designView->viewport() && event->type() == QEvent::Resize)
+        materializeVisibleElements();
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::exportHtml()
 {
     QString fileName = QFileDialog::getSaveFileName(
@@ -177,21 +778,48 @@ void MainWindow::exportHtml()
 
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    // Export from the scene itself, the preview may still be waiting for a commit
+    const WebProfileScope scope("file/export");
+    propertiesPanel->commitPendingChanges();
+
+    WebHtmlExporter exporter(fileName);
+    if (!exporter.begin(propertiesPanel->getGlobalCss() + project.components().styleSheet())) {
         QMessageBox::warning(this, tr("Error"), tr("Could not save file"));
         return;
     }
 
-    file.write(ui->htmlPreview->toPlainText().toUtf8());
-    file.close();
+    exporter.writeElements(project.components().exportElements(designScene->snapshot()));
+
+    if (!exporter.finish()) {
+        QMessageBox::warning(this, tr("Error"), tr("Could not save file: %1").arg(exporter.errorString()));
+    }
+}
+
+void MainWindow::exportSite()
+{
+    QString directory = QFileDialog::getExistingDirectory(
+        this,
+        tr("Export Site"),
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+
+    if (directory.isEmpty()) return;
+
+    const WebProfileScope scope("file/exportSite");
+    storeActivePage();
+
+    QString error;
+    if (!project.exportSite(directory, &error)) {
+        QMessageBox::warning(this, tr("Error"), tr("Could not export the site: %1").arg(error));
+        return;
+    }
+    statusBar()->showMessage(tr("Exported %n page(s) to %1", nullptr, int(project.pageCount())).arg(directory), 5000);
 }
 
 void MainWindow::clearCanvas()
 {
-    designScene->clear();
+    propertiesPanel->commitPendingChanges();
+    designScene->clearElements();
     propertiesPanel->clear();
-    ui->htmlPreview->clear();
 }
 
 void MainWindow::showAbout()
@@ -9,6 +9,7 @@
 #include <QLineEdit>
 #include <QComboBox>
 #include <QJsonObject>
+#include "WebProject.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -16,6 +17,17 @@ QT_END_NAMESPACE
 
 class WebDesignScene;
 class WebElementProperties;
+class WebPreviewEngine;
+class WebStyleEngine;
+class WebAutosave;
+class WebPerformanceDock;
+class WebRenderEngine;
+class WebPageCache;
+class WebOutlineModel;
+class QAction;
+class QDockWidget;
+class QToolButton;
+class QTreeView;
 
 class MainWindow : public QMainWindow
 {
@@ -30,19 +42,69 @@ private slots:
     void saveDesign();
     void loadDesign();
     void exportHtml();
+    void exportSite();
     void clearCanvas();
+    void undo();
+    void redo();
     void showAbout();
-    void onElementSelected(QGraphicsItem *item);
+    void onSelectionChanged();
+    void materializeVisibleElements();
+    void recoverAutosave();
+    void showPage(int index);
+    void addPage();
+    void removePage();
+    void renamePage(QListWidgetItem *item);
+    void createComponent();
+    void updateComponent();
+    void insertComponent(QListWidgetItem *item);
+    void renameComponent(QListWidgetItem *item);
+    void findElements();
+    void onOutlineSelectionChanged();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
     void createToolBar();
     void createWidgets();
     void createConnections();
     void setupElementsList();
+    void connectScene();
+    void setActiveScene(WebDesignScene *scene);
+    void storeActivePage();
+    void openProject(const WebProject &loaded, const QSharedPointer<WebDesignMapping> &mapping = {});
+    void refreshPageList();
+    void refreshComponentList();
+    void syncOutlineSelection();
 
     Ui::MainWindow *ui;
     WebDesignScene *designScene;
     WebElementProperties *propertiesPanel;
+    WebPreviewEngine *previewEngine;
+    WebStyleEngine *styleEngine;
+    WebAutosave *autosave;
+    WebPerformanceDock *performanceDock;
+    WebRenderEngine *renderEngine;
+    QDockWidget *renderDock;
+    WebPageCache *pageCache;
+    QListWidget *pagesList;
+    QListWidget *componentsList;
+    QAction *undoAction;
+    QAction *redoAction;
+    QAction *removePageAction = nullptr;
+    QAction *snapAction;
+    QAction *createComponentAction;
+    QAction *updateComponentAction;
+    QToolButton *arrangeButton;
+    QLineEdit *searchEdit;
+    WebOutlineModel *outlineModel;
+    QTreeView *outlineView;
+    QDockWidget *outlineDock;
+    // Set while one side of the selection updates the other
+    bool syncingSelection = false;
+    // Every page of the open design; the active page's blob is refreshed from the scene when needed
+    WebProject project;
+    WebDesignSerializer::Format documentFormat;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
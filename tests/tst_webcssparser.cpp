@@ -0,0 +1,146 @@
+#include "WebCssParser.h"
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+class tst_WebCssParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parsesColors_data();
+    void parsesColors();
+    void parsesDeclarations();
+    void skipsUnknownDeclarations();
+    void cascadesBySpecificity();
+    void laterRuleWinsTie();
+    void matchesCombinators();
+    void inheritsTextProperties();
+};
+
+void tst_WebCssParser::parsesColors_data()
+{
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<quint32>("color");
+
+    QTest::newRow("hex") << u"#ff8000"_s << true << 0xffff8000u;
+    QTest::newRow("short hex") << u"#0f0"_s << true << 0xff00ff00u;
+    QTest::newRow("hex with alpha") << u"#0000ff80"_s << true << 0x800000ffu;
+    QTest::newRow("named") << u"Navy"_s << true << 0xff000080u;
+    QTest::newRow("transparent") << u"transparent"_s << true << 0x00000000u;
+    QTest::newRow("rgb") << u"rgb(255, 128, 0)"_s << true << 0xffff8000u;
+    QTest::newRow("rgb spaces") << u"rgb(255 128 0)"_s << true << 0xffff8000u;
+    QTest::newRow("rgba") << u"rgba(0, 0, 255, 0.5)"_s << true << 0x800000ffu;
+    QTest::newRow("percent") << u"rgb(100%, 0%, 0%)"_s << true << 0xffff0000u;
+    QTest::newRow("unknown name") << u"notacolor"_s << false << 0u;
+    QTest::newRow("bad hex") << u"#12345"_s << false << 0u;
+    QTest::newRow("trailing") << u"red blue"_s << false << 0u;
+}
+
+void tst_WebCssParser::parsesColors()
+{
+    QFETCH(QString, value);
+    QFETCH(bool, valid);
+    QFETCH(quint32, color);
+
+    quint32 parsed = 0;
+    QCOMPARE(WebCssParser::parseColor(value, &parsed), valid);
+    if (valid)
+        QCOMPARE(parsed, color);
+}
+
+void tst_WebCssParser::parsesDeclarations()
+{
+    const WebStyle style = WebCssParser::parseDeclarations(
+        u"color: red; background: #fff; border: 2px dashed rgb(0, 0, 255); font-size: 12pt; "
+        u"font-weight: bold; width: 100px"_s);
+
+    QVERIFY(style.has(WebStyle::Color));
+    QCOMPARE(style.color, 0xffff0000u);
+    QVERIFY(style.has(WebStyle::BackgroundColor));
+    QCOMPARE(style.backgroundColor, 0xffffffffu);
+    QCOMPARE(style.borderWidth, 2.0);
+    QCOMPARE(style.borderStyle, WebStyle::DashedBorder);
+    QCOMPARE(style.borderColor, 0xff0000ffu);
+    QCOMPARE(style.fontSize, 16.0);
+    QCOMPARE(style.fontWeight, quint16(700));
+    QCOMPARE(style.width, 100.0);
+    QVERIFY(!style.has(WebStyle::Height));
+}
+
+void tst_WebCssParser::skipsUnknownDeclarations()
+{
+    // A typo, an unsupported property and a broken value leave the rest alone
+    const WebStyle style = WebCssParser::parseDeclarations(u"colr: red; float: left; width: wide; color: blue"_s);
+    QCOMPARE(style.defined, quint16(WebStyle::Color));
+    QCOMPARE(style.color, 0xff0000ffu);
+}
+
+void tst_WebCssParser::cascadesBySpecificity()
+{
+    // Written from most to least specific, the cascade has to reorder them
+    const WebStyleSheet sheet = WebCssParser::parseStyleSheet(
+        u"#intro { color: green } p.note { color: blue } .note { color: purple } p { color: red; font-size: 20px }"_s);
+    QCOMPARE(sheet.rules().size(), qsizetype(4));
+
+    WebStyleSubject plain{"p"_L1, QStringView(), QStringView()};
+    QCOMPARE(sheet.computeStyle(plain).color, 0xffff0000u);
+
+    const QString note = u"note wide"_s;
+    WebStyleSubject classed{"p"_L1, QStringView(), note};
+    QCOMPARE(sheet.computeStyle(classed).color, 0xff0000ffu);
+
+    const QString intro = u"intro"_s;
+    WebStyleSubject identified{"p"_L1, intro, note};
+    const WebStyle style = sheet.computeStyle(identified);
+    QCOMPARE(style.color, 0xff008000u);
+    // Properties the winning rule does not set still come from the others
+    QCOMPARE(style.fontSize, 20.0);
+
+    WebStyleSubject other{"div"_L1, QStringView(), QStringView()};
+    QVERIFY(sheet.computeStyle(other).isEmpty());
+}
+
+void tst_WebCssParser::laterRuleWinsTie()
+{
+    const WebStyleSheet sheet = WebCssParser::parseStyleSheet(u"p { color: red } p { color: blue }"_s);
+    WebStyleSubject subject{"p"_L1, QStringView(), QStringView()};
+    QCOMPARE(sheet.computeStyle(subject).color, 0xff0000ffu);
+}
+
+void tst_WebCssParser::matchesCombinators()
+{
+    const WebStyleSheet sheet = WebCssParser::parseStyleSheet(
+        u"div p { font-size: 20px } div > p { font-weight: bold } section > p { width: 10px }"_s);
+    QVERIFY(sheet.hasCombinators());
+
+    // div > section > p: a descendant of the div, a child of the section only
+    WebStyleSubject div{"div"_L1, QStringView(), QStringView()};
+    WebStyleSubject section{"section"_L1, QStringView(), QStringView(), &div};
+    WebStyleSubject nested{"p"_L1, QStringView(), QStringView(), &section};
+    const WebStyle style = sheet.computeStyle(nested);
+    QVERIFY(style.has(WebStyle::FontSize));
+    QVERIFY(!style.has(WebStyle::FontWeight));
+    QVERIFY(style.has(WebStyle::Width));
+
+    WebStyleSubject child{"p"_L1, QStringView(), QStringView(), &div};
+    QVERIFY(sheet.computeStyle(child).has(WebStyle::FontWeight));
+
+    WebStyleSubject alone{"p"_L1, QStringView(), QStringView()};
+    QVERIFY(sheet.computeStyle(alone).isEmpty());
+}
+
+void tst_WebCssParser::inheritsTextProperties()
+{
+    const WebStyle parent = WebCssParser::parseDeclarations(u"color: red; font-size: 20px; background: blue"_s);
+    WebStyle child = WebCssParser::parseDeclarations(u"font-size: 10px"_s);
+    child.inherit(parent);
+
+    QCOMPARE(child.color, 0xffff0000u);
+    QCOMPARE(child.fontSize, 10.0);
+    QVERIFY(!child.has(WebStyle::BackgroundColor));
+}
+
+QTEST_GUILESS_MAIN(tst_WebCssParser)
+#include "tst_webcssparser.moc"
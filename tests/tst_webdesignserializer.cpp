@@ -0,0 +1,312 @@
+#include "WebDesignSerializer.h"
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <array>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// A container with a nested image, and a hidden component instance with a link
+WebDesignDocument sampleDocument()
+{
+    WebDesignDocument document;
+
+    WebElementData container;
+    container.type = u"Container"_s;
+    container.id = u"main"_s;
+    container.cls = u"card wide"_s;
+    container.text = u"Container"_s;
+    container.style = u"color: red"_s;
+    container.x = 10;
+    container.y = 20;
+    container.width = 300;
+    container.height = 200;
+    document.elements.append(container);
+
+    WebElementData image;
+    image.type = u"Image"_s;
+    image.text = u"Logo"_s;
+    image.x = 5.5;
+    image.y = 7.25;
+    image.width = 120;
+    image.height = 80;
+    image.parent = 0;
+    image.setValue(WebElementField::Src, u"logo.png"_s);
+    image.setValue(WebElementField::Alt, u"Company logo"_s);
+    document.elements.append(image);
+
+    WebElementData button;
+    button.type = u"Button"_s;
+    button.cls = u"card wide"_s;
+    button.text = u"Sign up"_s;
+    button.x = 400;
+    button.y = 30;
+    button.width = 120;
+    button.height = 40;
+    button.component = 7;
+    button.part = 0;
+    button.overrides = WebElementData::fieldBit(WebElementField::Text);
+    button.hidden = true;
+    button.setValue(WebElementField::Href, u"/signup"_s);
+    document.elements.append(button);
+
+    document.properties.insert(u"title"_s, u"Sample"_s);
+    return document;
+}
+
+// The file as the older version wrote it, byte by byte
+QByteArray legacyBinary(quint16 version, const WebDesignDocument &document)
+{
+    QList<QString> strings;
+    auto intern = [&strings](const QString &value) {
+        qsizetype index = strings.indexOf(value);
+        if (index < 0) {
+            index = strings.size();
+            strings.append(value);
+        }
+        return quint32(index);
+    };
+    QList<std::array<quint32, 5>> references;
+    for (const WebElementData &element : document.elements)
+        references.append({intern(element.type), intern(element.id), intern(element.cls),
+                           intern(element.text), intern(element.style)});
+
+    const QByteArray properties = R"({"title":"Legacy"})";
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    out.writeRawData("WDSB", 4);
+    out << version << quint16(0) << quint32(strings.size()) << quint32(document.elements.size())
+        << quint32(properties.size());
+    for (const QString &value : std::as_const(strings)) {
+        out << quint32(value.size());
+        for (QChar c : value)
+            out << quint16(c.unicode());
+    }
+    for (qsizetype i = 0; i < document.elements.size(); ++i) {
+        const WebElementData &element = document.elements.at(i);
+        out << element.x << element.y << element.width << element.height;
+        for (quint32 index : references.at(i))
+            out << index;
+        if (version >= 2)
+            out << element.parent;
+        if (version >= 3)
+            out << element.component << element.part << quint32(element.overrides);
+    }
+    out.writeRawData(properties.constData(), properties.size());
+    return data;
+}
+
+void compareElements(const QList<WebElementData> &actual, const QList<WebElementData> &expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (qsizetype i = 0; i < expected.size(); ++i)
+        QCOMPARE(actual.at(i).toJson(), expected.at(i).toJson());
+}
+
+bool writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+}
+
+class tst_WebDesignSerializer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void binaryRoundTrip();
+    void jsonRoundTrip();
+    void readsOlderVersions_data();
+    void readsOlderVersions();
+    void rejectsTruncatedBinary();
+    void rejectsCorruptBinary();
+    void rejectsInvalidJson();
+    void readKeepsFormatOnFailure();
+    void mapsBinaryFile();
+    void mappingReportsErrors();
+};
+
+void tst_WebDesignSerializer::binaryRoundTrip()
+{
+    const WebDesignDocument document = sampleDocument();
+    const QByteArray data = WebDesignSerializer::toBinary(document);
+    QCOMPARE(WebDesignSerializer::detectFormat(data), WebDesignSerializer::BinaryFormat);
+
+    WebDesignDocument read;
+    QString error;
+    QVERIFY2(WebDesignSerializer::fromBinary(data, &read, &error), qPrintable(error));
+    compareElements(read.elements, document.elements);
+    QCOMPARE(read.properties, document.properties);
+    QVERIFY(read.elements.at(2).hidden);
+}
+
+void tst_WebDesignSerializer::jsonRoundTrip()
+{
+    const WebDesignDocument document = sampleDocument();
+    const QByteArray data = WebDesignSerializer::toJson(document);
+    QCOMPARE(WebDesignSerializer::detectFormat(data), WebDesignSerializer::JsonFormat);
+
+    WebDesignDocument read;
+    QString error;
+    QVERIFY2(WebDesignSerializer::fromJson(data, &read, &error), qPrintable(error));
+    compareElements(read.elements, document.elements);
+    QCOMPARE(read.properties, document.properties);
+}
+
+void tst_WebDesignSerializer::readsOlderVersions_data()
+{
+    QTest::addColumn<quint16>("version");
+    QTest::newRow("v1") << quint16(1);
+    QTest::newRow("v2") << quint16(2);
+    QTest::newRow("v3") << quint16(3);
+}
+
+void tst_WebDesignSerializer::readsOlderVersions()
+{
+    QFETCH(quint16, version);
+
+    // What the version could store: no attributes or hidden flag before 4,
+    // no components before 3, no nesting before 2
+    WebDesignDocument expected = sampleDocument();
+    for (WebElementData &element : expected.elements) {
+        element.attributes.clear();
+        element.hidden = false;
+        if (version < 3) {
+            element.component = 0;
+            element.part = -1;
+            element.overrides = 0;
+        }
+        if (version < 2)
+            element.parent = -1;
+    }
+
+    WebDesignDocument read;
+    QString error;
+    QVERIFY2(WebDesignSerializer::fromBinary(legacyBinary(version, expected), &read, &error), qPrintable(error));
+    compareElements(read.elements, expected.elements);
+    QCOMPARE(read.properties.value(u"title"_s).toString(), u"Legacy"_s);
+}
+
+void tst_WebDesignSerializer::rejectsTruncatedBinary()
+{
+    // Every part of the file is needed, the properties trailer included
+    const QByteArray data = WebDesignSerializer::toBinary(sampleDocument());
+    for (qsizetype size = 0; size < data.size(); ++size) {
+        WebDesignDocument read;
+        QString error;
+        QVERIFY2(!WebDesignSerializer::fromBinary(data.first(size), &read, &error),
+                 qPrintable(u"accepted %1 of %2 bytes"_s.arg(size).arg(data.size())));
+        QVERIFY(!error.isEmpty());
+    }
+}
+
+void tst_WebDesignSerializer::rejectsCorruptBinary()
+{
+    // One element of empty strings: the table holds one string of 4 bytes,
+    // the record's type index follows the header, the table and 4 doubles
+    WebDesignDocument document;
+    document.elements.append(WebElementData());
+    const QByteArray data = WebDesignSerializer::toBinary(document);
+    constexpr qsizetype typeIndexOffset = 20 + 4 + 4 * sizeof(double);
+
+    WebDesignDocument read;
+    QString error;
+    QVERIFY(WebDesignSerializer::fromBinary(data, &read, &error));
+
+    QByteArray corrupt = data;
+    corrupt[typeIndexOffset] = 5;
+    QVERIFY(!WebDesignSerializer::fromBinary(corrupt, &read, &error));
+    QVERIFY(!error.isEmpty());
+
+    QByteArray newer = data;
+    newer[4] = char(WebDesignSerializer::BinaryVersion + 1);
+    error.clear();
+    QVERIFY(!WebDesignSerializer::fromBinary(newer, &read, &error));
+    QVERIFY(!error.isEmpty());
+
+    error.clear();
+    QVERIFY(!WebDesignSerializer::fromBinary("WDSB", &read, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void tst_WebDesignSerializer::rejectsInvalidJson()
+{
+    WebDesignDocument read;
+    QString error;
+    QVERIFY(!WebDesignSerializer::fromJson("{\"elements\": [", &read, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void tst_WebDesignSerializer::readKeepsFormatOnFailure()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString broken = dir.filePath(u"broken.webdesign"_s);
+    const QString valid = dir.filePath(u"valid.webdesign"_s);
+    QVERIFY(writeFile(broken, "{"));
+    QVERIFY(writeFile(valid, WebDesignSerializer::toJson(sampleDocument())));
+
+    WebDesignDocument read;
+    WebDesignSerializer::Format format = WebDesignSerializer::BinaryFormat;
+    QString error;
+    QVERIFY(!WebDesignSerializer::read(broken, &read, &format, &error));
+    QVERIFY(!error.isEmpty());
+    QCOMPARE(format, WebDesignSerializer::BinaryFormat);
+
+    QVERIFY2(WebDesignSerializer::read(valid, &read, &format, &error), qPrintable(error));
+    QCOMPARE(format, WebDesignSerializer::JsonFormat);
+    QCOMPARE(WebDesignSerializer::detectFileFormat(valid), WebDesignSerializer::JsonFormat);
+}
+
+void tst_WebDesignSerializer::mapsBinaryFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const WebDesignDocument document = sampleDocument();
+    const QString fileName = dir.filePath(u"design.webdesign"_s);
+    QVERIFY(writeFile(fileName, WebDesignSerializer::toBinary(document)));
+    QCOMPARE(WebDesignSerializer::detectFileFormat(fileName), WebDesignSerializer::BinaryFormat);
+
+    WebDesignMapping mapping;
+    QString error;
+    QVERIFY2(mapping.open(fileName, &error), qPrintable(error));
+    QCOMPARE(mapping.elementCount(), document.elements.size());
+    QVERIFY(mapping.isNested());
+    QCOMPARE(mapping.properties(), document.properties);
+
+    QList<WebElementData> elements;
+    for (qsizetype record = 0; record < mapping.elementCount(); ++record) {
+        const WebElementData &element = document.elements.at(record);
+        QCOMPARE(mapping.geometry(record), QRectF(element.x, element.y, element.width, element.height));
+        QCOMPARE(mapping.isHidden(record), element.hidden);
+        elements.append(mapping.element(record));
+    }
+    compareElements(elements, document.elements);
+}
+
+void tst_WebDesignSerializer::mappingReportsErrors()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray data = WebDesignSerializer::toBinary(sampleDocument());
+
+    const QList<QByteArray> files = {QByteArray(), data.first(10), data.first(data.size() / 2),
+                                     WebDesignSerializer::toJson(sampleDocument())};
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        const QString fileName = dir.filePath(u"file%1.webdesign"_s.arg(i));
+        QVERIFY(writeFile(fileName, files.at(i)));
+
+        WebDesignMapping mapping;
+        QString error;
+        QVERIFY(!mapping.open(fileName, &error));
+        QVERIFY2(!error.isEmpty(), qPrintable(u"no error for file %1"_s.arg(i)));
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_WebDesignSerializer)
+#include "tst_webdesignserializer.moc"
@@ -0,0 +1,140 @@
+#include "WebEdgeIndex.h"
+#include <QTest>
+
+class tst_WebEdgeIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void snapsToNearestEdge();
+    void respectsTolerance();
+    void skipsKeys();
+    void updatesInPlace();
+    void updatesInBatch();
+    void rebuildMatchesInserts();
+};
+
+namespace {
+WebEdgeIndex twoRects()
+{
+    WebEdgeIndex index;
+    index.insert(1, QRectF(0, 0, 100, 50));
+    index.insert(2, QRectF(200, 0, 100, 50));
+    return index;
+}
+}
+
+void tst_WebEdgeIndex::snapsToNearestEdge()
+{
+    const WebEdgeIndex index = twoRects();
+    QCOMPARE(index.size(), qsizetype(2));
+
+    WebEdgeIndex::Match match = index.nearest(WebEdgeIndex::Horizontal, 103, 5);
+    QVERIFY(match.isValid());
+    QCOMPARE(match.position, 100.0);
+    QCOMPARE(match.distance, 3.0);
+    QCOMPARE(match.key, quintptr(1));
+
+    // Centers count as edges
+    match = index.nearest(WebEdgeIndex::Horizontal, 248, 5);
+    QCOMPARE(match.position, 250.0);
+    QCOMPARE(match.key, quintptr(2));
+
+    match = index.nearest(WebEdgeIndex::Vertical, 52, 5);
+    QCOMPARE(match.position, 50.0);
+
+    // The closer edge wins whichever side it is on
+    match = index.nearest(WebEdgeIndex::Horizontal, 197, 5);
+    QCOMPARE(match.position, 200.0);
+    QCOMPARE(match.key, quintptr(2));
+}
+
+void tst_WebEdgeIndex::respectsTolerance()
+{
+    const WebEdgeIndex index = twoRects();
+    QVERIFY(!index.nearest(WebEdgeIndex::Horizontal, 150, 5).isValid());
+    QVERIFY(!index.nearest(WebEdgeIndex::Horizontal, 106, 5).isValid());
+    QVERIFY(index.nearest(WebEdgeIndex::Horizontal, 105, 5).isValid());
+    QVERIFY(!WebEdgeIndex().nearest(WebEdgeIndex::Vertical, 0, 5).isValid());
+}
+
+void tst_WebEdgeIndex::skipsKeys()
+{
+    const WebEdgeIndex index = twoRects();
+    auto skipSecond = [](quintptr key) { return key == 2; };
+    QVERIFY(!index.nearest(WebEdgeIndex::Horizontal, 198, 5, skipSecond).isValid());
+
+    const WebEdgeIndex::Match match = index.nearest(WebEdgeIndex::Horizontal, 102, 5, skipSecond);
+    QCOMPARE(match.position, 100.0);
+    QCOMPARE(match.key, quintptr(1));
+}
+
+void tst_WebEdgeIndex::updatesInPlace()
+{
+    WebEdgeIndex index = twoRects();
+    index.insert(1, QRectF(190, 0, 10, 10));
+    QCOMPARE(index.rect(1), QRectF(190, 0, 10, 10));
+    QVERIFY(!index.nearest(WebEdgeIndex::Horizontal, 100, 5).isValid());
+
+    const WebEdgeIndex::Match match = index.nearest(WebEdgeIndex::Horizontal, 196, 5);
+    QCOMPARE(match.position, 195.0);
+    QCOMPARE(match.key, quintptr(1));
+
+    index.remove(2);
+    QVERIFY(!index.contains(2));
+    QVERIFY(!index.nearest(WebEdgeIndex::Horizontal, 300, 5).isValid());
+    QCOMPARE(index.size(), qsizetype(1));
+}
+
+void tst_WebEdgeIndex::updatesInBatch()
+{
+    // More changes than are applied one by one, so they are merged
+    WebEdgeIndex index;
+    QList<WebEdgeIndex::Entry> entries;
+    for (quintptr key = 1; key <= 40; ++key)
+        entries.append({key, QRectF(qreal(key) * 1000, 0, 10, 10)});
+    index.update(entries);
+    QCOMPARE(index.size(), qsizetype(40));
+
+    QList<WebEdgeIndex::Entry> moves;
+    for (quintptr key = 1; key <= 40; ++key) {
+        // Every other rectangle moves, the rest are removed
+        moves.append({key, key % 2 ? QRectF(qreal(key) * 1000 + 500, 0, 10, 10) : QRectF()});
+    }
+    index.update(moves);
+    QCOMPARE(index.size(), qsizetype(20));
+
+    for (quintptr key = 1; key <= 40; ++key) {
+        const WebEdgeIndex::Match old = index.nearest(WebEdgeIndex::Horizontal, qreal(key) * 1000, 2);
+        QVERIFY(!old.isValid());
+        const WebEdgeIndex::Match moved = index.nearest(WebEdgeIndex::Horizontal, qreal(key) * 1000 + 501, 2);
+        QCOMPARE(moved.isValid(), key % 2 == 1);
+        if (moved.isValid())
+            QCOMPARE(moved.key, key);
+    }
+}
+
+void tst_WebEdgeIndex::rebuildMatchesInserts()
+{
+    QList<WebEdgeIndex::Entry> entries;
+    for (quintptr key = 1; key <= 10; ++key)
+        entries.append({key, QRectF(qreal(key) * 37, qreal(key) * 11, 20, 30)});
+
+    WebEdgeIndex rebuilt;
+    rebuilt.rebuild(entries);
+    WebEdgeIndex inserted;
+    for (const WebEdgeIndex::Entry &entry : std::as_const(entries))
+        inserted.insert(entry.key, entry.rect);
+
+    for (qreal position = 0; position < 500; position += 3) {
+        for (WebEdgeIndex::Axis axis : {WebEdgeIndex::Horizontal, WebEdgeIndex::Vertical}) {
+            const WebEdgeIndex::Match a = rebuilt.nearest(axis, position, 4);
+            const WebEdgeIndex::Match b = inserted.nearest(axis, position, 4);
+            QCOMPARE(a.isValid(), b.isValid());
+            QCOMPARE(a.position, b.position);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_WebEdgeIndex)
+#include "tst_webedgeindex.moc"
@@ -0,0 +1,139 @@
+#include "WebDesignSerializer.h"
+#include "WebElementTree.h"
+#include <QTest>
+#include <algorithm>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+QList<WebElementData> elementsWithParents(const QList<qint32> &parents)
+{
+    QList<WebElementData> elements;
+    for (qint32 parent : parents) {
+        WebElementData element;
+        element.type = u"Container"_s;
+        element.parent = parent;
+        elements.append(element);
+    }
+    return elements;
+}
+
+QStringList walkOf(const WebElementTree &tree)
+{
+    QStringList steps;
+    tree.walk([&steps](qsizetype index, bool) { steps.append(u"enter %1"_s.arg(index)); },
+              [&steps](qsizetype index) { steps.append(u"leave %1"_s.arg(index)); });
+    return steps;
+}
+
+// Every element is entered once, whatever the parents say
+bool entersEachOnce(const WebElementTree &tree)
+{
+    QList<qsizetype> entered;
+    tree.walk([&entered](qsizetype index, bool) { entered.append(index); }, [](qsizetype) {});
+    std::sort(entered.begin(), entered.end());
+    for (qsizetype i = 0; i < entered.size(); ++i) {
+        if (entered.at(i) != i)
+            return false;
+    }
+    return entered.size() == tree.size();
+}
+}
+
+class tst_WebElementTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void walksInDocumentOrder();
+    void acceptsParentAfterChild();
+    void rejectsBrokenParents();
+    void breaksCycles_data();
+    void breaksCycles();
+    void removalReparentsChildren();
+};
+
+void tst_WebElementTree::walksInDocumentOrder()
+{
+    const WebElementTree tree(elementsWithParents({-1, 0, 0, 1, -1, 4}));
+    QVERIFY(tree.hasChildren(0));
+    QVERIFY(!tree.hasChildren(2));
+    QCOMPARE(walkOf(tree), QStringList({u"enter 0"_s, u"enter 1"_s, u"enter 3"_s, u"leave 1"_s, u"enter 2"_s,
+                                        u"leave 0"_s, u"enter 4"_s, u"enter 5"_s, u"leave 4"_s}));
+}
+
+void tst_WebElementTree::acceptsParentAfterChild()
+{
+    const WebElementTree tree(elementsWithParents({1, -1}));
+    QCOMPARE(tree.parentOf(0), qsizetype(1));
+    QCOMPARE(walkOf(tree), QStringList({u"enter 1"_s, u"enter 0"_s, u"leave 1"_s}));
+}
+
+void tst_WebElementTree::rejectsBrokenParents()
+{
+    // Itself, past the end and below -1 all count as top level
+    const WebElementTree tree(elementsWithParents({0, 99, -5, 1}));
+    QCOMPARE(tree.parentOf(0), qsizetype(-1));
+    QCOMPARE(tree.parentOf(1), qsizetype(-1));
+    QCOMPARE(tree.parentOf(2), qsizetype(-1));
+    QCOMPARE(tree.parentOf(3), qsizetype(1));
+    QVERIFY(entersEachOnce(tree));
+}
+
+void tst_WebElementTree::breaksCycles_data()
+{
+    QTest::addColumn<QList<qint32>>("parents");
+    QTest::addColumn<qsizetype>("madeTopLevel");
+
+    // The element that closes the loop, followed from the lowest index, becomes top level
+    QTest::newRow("pair") << QList<qint32>{1, 0} << qsizetype(1);
+    QTest::newRow("three") << QList<qint32>{2, 0, 1} << qsizetype(1);
+    QTest::newRow("below a root") << QList<qint32>{-1, 0, 3, 2} << qsizetype(3);
+    QTest::newRow("two loops") << QList<qint32>{1, 0, 3, 2, 2} << qsizetype(1);
+}
+
+void tst_WebElementTree::breaksCycles()
+{
+    QFETCH(QList<qint32>, parents);
+    QFETCH(qsizetype, madeTopLevel);
+
+    const WebElementTree tree(elementsWithParents(parents));
+    QCOMPARE(tree.parentOf(madeTopLevel), qsizetype(-1));
+    QVERIFY(entersEachOnce(tree));
+
+    // No element is its own ancestor any more
+    for (qsizetype i = 0; i < tree.size(); ++i) {
+        qsizetype depth = 0;
+        for (qsizetype node = tree.parentOf(i); node >= 0; node = tree.parentOf(node))
+            QVERIFY(++depth <= tree.size());
+    }
+}
+
+void tst_WebElementTree::removalReparentsChildren()
+{
+    QList<WebElementData> elements = elementsWithParents({-1, 0, 1, 0, -1});
+    const QList<QPointF> positions = {{100, 50}, {10, 10}, {1, 2}, {5, 5}, {0, 0}};
+    for (qsizetype i = 0; i < elements.size(); ++i) {
+        elements[i].x = positions.at(i).x();
+        elements[i].y = positions.at(i).y();
+    }
+
+    // Children of the removed container move up and stay where they were on the page
+    WebDesignDocument document;
+    document.elements = elements;
+    document.removeElement(0);
+    QCOMPARE(document.elements.size(), qsizetype(4));
+    QCOMPARE(document.elements.at(0).parent, -1);
+    QCOMPARE(QPointF(document.elements.at(0).x, document.elements.at(0).y), QPointF(110, 60));
+    QCOMPARE(document.elements.at(1).parent, 0);
+    QCOMPARE(QPointF(document.elements.at(1).x, document.elements.at(1).y), QPointF(1, 2));
+    QCOMPARE(document.elements.at(2).parent, -1);
+    QCOMPARE(QPointF(document.elements.at(2).x, document.elements.at(2).y), QPointF(105, 55));
+    QCOMPARE(document.elements.at(3).parent, -1);
+
+    const WebElementTree tree(document.elements);
+    QCOMPARE(walkOf(tree), QStringList({u"enter 0"_s, u"enter 1"_s, u"leave 0"_s, u"enter 2"_s, u"enter 3"_s}));
+}
+
+QTEST_GUILESS_MAIN(tst_WebElementTree)
+#include "tst_webelementtree.moc"
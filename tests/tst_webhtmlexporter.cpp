@@ -0,0 +1,97 @@
+#include "WebHtmlExporter.h"
+#include "WebProject.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+class tst_WebHtmlExporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void exportsDesign_data();
+    void exportsDesign();
+    void exportsProjectAsSite_data();
+    void exportsProjectAsSite();
+};
+
+namespace {
+QList<WebElementData> paragraph(const QString &text)
+{
+    WebElementData element;
+    element.type = u"Paragraph"_s;
+    element.text = text;
+    element.width = 100;
+    element.height = 20;
+    return {element};
+}
+
+QByteArray readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void addFormats()
+{
+    QTest::addColumn<bool>("binary");
+    QTest::newRow("json") << false;
+    QTest::newRow("binary") << true;
+}
+}
+
+void tst_WebHtmlExporter::exportsDesign_data()
+{
+    addFormats();
+}
+
+void tst_WebHtmlExporter::exportsDesign()
+{
+    QFETCH(bool, binary);
+    const auto format = binary ? WebDesignSerializer::BinaryFormat : WebDesignSerializer::JsonFormat;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    WebProject project;
+    project.setElements(0, paragraph(u"Hello"_s));
+    const QString designFile = dir.filePath(u"page.webdesign"_s);
+    QString error;
+    QVERIFY2(WebProject::write(designFile, project, format, &error), qPrintable(error));
+
+    const QString htmlFile = dir.filePath(u"page.html"_s);
+    QVERIFY2(WebHtmlExporter::exportDesign(designFile, htmlFile, &error), qPrintable(error));
+    QVERIFY(readFile(htmlFile).contains("Hello"));
+}
+
+void tst_WebHtmlExporter::exportsProjectAsSite_data()
+{
+    addFormats();
+}
+
+void tst_WebHtmlExporter::exportsProjectAsSite()
+{
+    QFETCH(bool, binary);
+    const auto format = binary ? WebDesignSerializer::BinaryFormat : WebDesignSerializer::JsonFormat;
+
+    // Read as a plain design the project used to come out as an empty page
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    WebProject project;
+    project.setElements(0, paragraph(u"Welcome"_s));
+    project.addPage(u"About Us"_s, paragraph(u"History"_s));
+    const QString designFile = dir.filePath(u"site.webdesign"_s);
+    QString error;
+    QVERIFY2(WebProject::write(designFile, project, format, &error), qPrintable(error));
+
+    const QString htmlFile = dir.filePath(u"site.html"_s);
+    QVERIFY2(WebHtmlExporter::exportDesign(designFile, htmlFile, &error), qPrintable(error));
+    QVERIFY(!QFile::exists(htmlFile));
+    QCOMPARE(WebHtmlExporter::siteDirectory(htmlFile), dir.filePath(u"site"_s));
+    QVERIFY(readFile(dir.filePath(u"site/index.html"_s)).contains("Welcome"));
+    QVERIFY(readFile(dir.filePath(u"site/about-us.html"_s)).contains("History"));
+}
+
+QTEST_GUILESS_MAIN(tst_WebHtmlExporter)
+#include "tst_webhtmlexporter.moc"
@@ -0,0 +1,123 @@
+#include "WebOffsetTree.h"
+#include <QRandomGenerator>
+#include <QTest>
+
+class tst_WebOffsetTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void startsEmpty();
+    void assignsLengths_data();
+    void assignsLengths();
+    void appendsLengths_data();
+    void appendsLengths();
+    void addsDeltas();
+};
+
+namespace {
+QList<qsizetype> randomLengths(qsizetype count, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QList<qsizetype> lengths;
+    lengths.reserve(count);
+    for (qsizetype i = 0; i < count; ++i)
+        lengths.append(random.bounded(1000));
+    return lengths;
+}
+
+// Compares every offset, including the one past the end, with plain prefix sums
+void verifyOffsets(const WebOffsetTree &tree, const QList<qsizetype> &lengths)
+{
+    QCOMPARE(tree.size(), lengths.size());
+    qsizetype sum = 0;
+    for (qsizetype index = 0; index <= lengths.size(); ++index) {
+        QCOMPARE(tree.offset(index), sum);
+        if (index < lengths.size())
+            sum += lengths.at(index);
+    }
+}
+
+void addSizes()
+{
+    QTest::addColumn<qsizetype>("count");
+
+    // Powers of two and their neighbours end or start a new top level range
+    for (qsizetype count : {1, 2, 3, 7, 8, 9, 31, 32, 33, 100, 1024})
+        QTest::addRow("%lld", qint64(count)) << count;
+}
+}
+
+void tst_WebOffsetTree::startsEmpty()
+{
+    WebOffsetTree tree;
+    QCOMPARE(tree.size(), qsizetype(0));
+    QCOMPARE(tree.offset(0), qsizetype(0));
+
+    tree.append(5);
+    tree.clear();
+    QCOMPARE(tree.size(), qsizetype(0));
+    tree.assign({});
+    QCOMPARE(tree.offset(0), qsizetype(0));
+}
+
+void tst_WebOffsetTree::assignsLengths_data()
+{
+    addSizes();
+}
+
+void tst_WebOffsetTree::assignsLengths()
+{
+    QFETCH(qsizetype, count);
+
+    const QList<qsizetype> lengths = randomLengths(count, 42);
+    WebOffsetTree tree;
+    tree.assign(lengths);
+    verifyOffsets(tree, lengths);
+}
+
+void tst_WebOffsetTree::appendsLengths_data()
+{
+    addSizes();
+}
+
+void tst_WebOffsetTree::appendsLengths()
+{
+    QFETCH(qsizetype, count);
+
+    // Appending one by one has to build the same tree as assigning at once
+    const QList<qsizetype> lengths = randomLengths(count, 7);
+    WebOffsetTree appended;
+    for (qsizetype length : lengths)
+        appended.append(length);
+    WebOffsetTree assigned;
+    assigned.assign(lengths);
+    verifyOffsets(appended, lengths);
+    for (qsizetype index = 0; index <= count; ++index)
+        QCOMPARE(appended.offset(index), assigned.offset(index));
+}
+
+void tst_WebOffsetTree::addsDeltas()
+{
+    QList<qsizetype> lengths = randomLengths(100, 3);
+    WebOffsetTree tree;
+    tree.assign(lengths);
+
+    QRandomGenerator random(11);
+    for (int change = 0; change < 200; ++change) {
+        const qsizetype index = random.bounded(int(lengths.size()));
+        // Lengths shrink as well as grow, down to nothing
+        const qsizetype delta = random.bounded(-int(lengths.at(index)), 500);
+        lengths[index] += delta;
+        tree.add(index, delta);
+    }
+    verifyOffsets(tree, lengths);
+
+    // Appending after changes extends the changed sums
+    lengths.append(17);
+    tree.append(17);
+    verifyOffsets(tree, lengths);
+}
+
+QTEST_GUILESS_MAIN(tst_WebOffsetTree)
+#include "tst_weboffsettree.moc"
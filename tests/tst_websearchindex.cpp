@@ -0,0 +1,165 @@
+#include "WebSearchIndex.h"
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+class tst_WebSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tokenizesFields();
+    void findsByField_data();
+    void findsByField();
+    void removesElements();
+    void reindexesEdits();
+    void forgetsUnusedWords();
+    void rekeysElements();
+    void rebuildMatchesInserts();
+};
+
+namespace {
+WebElementData element(const QString &type, const QString &id, const QString &cls, const QString &text)
+{
+    WebElementData data;
+    data.type = type;
+    data.id = id;
+    data.cls = cls;
+    data.text = text;
+    return data;
+}
+
+// Button 1, a heading 2 and a link 3 sharing some words
+WebSearchIndex sampleIndex()
+{
+    WebSearchIndex index;
+    index.insert(1, element(u"Button"_s, u"signup"_s, u"cta primary"_s, u"Sign up"_s));
+    index.insert(2, element(u"Heading 1"_s, u"title"_s, u"primary"_s, u"Sign in or sign up"_s));
+    WebElementData link = element(u"Link"_s, QString(), u"nav"_s, u"Home"_s);
+    link.setValue(WebElementField::Href, u"index.html"_s);
+    index.insert(3, link);
+    return index;
+}
+}
+
+void tst_WebSearchIndex::tokenizesFields()
+{
+    const QList<QString> tokens = WebSearchIndex::tokensOf(element(u"Heading 1"_s, u"main"_s, u"a b"_s, u"Hi, there"_s));
+    QVERIFY(tokens.contains(u"type:heading1"_s));
+    QVERIFY(tokens.contains(u"type:h1"_s));
+    QVERIFY(tokens.contains(u"id:main"_s));
+    QVERIFY(tokens.contains(u"class:a"_s));
+    QVERIFY(tokens.contains(u"class:b"_s));
+    QVERIFY(tokens.contains(u"text:hi"_s));
+    QVERIFY(tokens.contains(u"text:there"_s));
+    QVERIFY(std::is_sorted(tokens.cbegin(), tokens.cend()));
+}
+
+void tst_WebSearchIndex::findsByField_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QList<quintptr>>("keys");
+
+    QTest::newRow("type name") << u"type:button"_s << QList<quintptr>{1};
+    QTest::newRow("type tag") << u"type:h1"_s << QList<quintptr>{2};
+    QTest::newRow("class") << u".cta"_s << QList<quintptr>{1};
+    QTest::newRow("shared class") << u".primary"_s << QList<quintptr>{1, 2};
+    QTest::newRow("id") << u"#title"_s << QList<quintptr>{2};
+    QTest::newRow("any field") << u"sign"_s << QList<quintptr>{1, 2};
+    QTest::newRow("upper case") << u"SIGN"_s << QList<quintptr>{1, 2};
+    QTest::newRow("every term") << u"sign type:button"_s << QList<quintptr>{1};
+    QTest::newRow("no common element") << u".nav sign"_s << QList<quintptr>();
+    QTest::newRow("attribute") << u"href:index.html"_s << QList<quintptr>{3};
+    QTest::newRow("several tokens") << u"text:sign-in"_s << QList<quintptr>{2};
+    QTest::newRow("unknown word") << u"missing"_s << QList<quintptr>();
+    QTest::newRow("empty") << QString() << QList<quintptr>();
+}
+
+void tst_WebSearchIndex::findsByField()
+{
+    QFETCH(QString, query);
+    QFETCH(QList<quintptr>, keys);
+
+    const WebSearchIndex index = sampleIndex();
+    QCOMPARE(index.find(query), keys);
+}
+
+void tst_WebSearchIndex::removesElements()
+{
+    WebSearchIndex index = sampleIndex();
+    index.remove(1);
+    QVERIFY(!index.contains(1));
+    QCOMPARE(index.size(), qsizetype(2));
+    QVERIFY(index.find(u".cta"_s).isEmpty());
+    QCOMPARE(index.find(u"sign"_s), QList<quintptr>{2});
+
+    // Removing twice is harmless
+    index.remove(1);
+    QCOMPARE(index.size(), qsizetype(2));
+}
+
+void tst_WebSearchIndex::reindexesEdits()
+{
+    WebSearchIndex index = sampleIndex();
+    index.insert(1, element(u"Button"_s, u"signup"_s, u"cta primary"_s, u"Register"_s));
+    QCOMPARE(index.size(), qsizetype(3));
+    QCOMPARE(index.find(u"sign"_s), QList<quintptr>{2});
+    QCOMPARE(index.find(u"register"_s), QList<quintptr>{1});
+    QCOMPARE(index.find(u".primary"_s), (QList<quintptr>{1, 2}));
+}
+
+void tst_WebSearchIndex::forgetsUnusedWords()
+{
+    // The token freed by the removal is reused for the next new word and
+    // must not keep answering for the old one
+    WebSearchIndex index;
+    index.insert(1, element(u"Button"_s, QString(), QString(), u"alpha"_s));
+    index.remove(1);
+    QVERIFY(index.find(u"alpha"_s).isEmpty());
+
+    index.insert(2, element(u"Button"_s, QString(), QString(), u"beta"_s));
+    QVERIFY(index.find(u"alpha"_s).isEmpty());
+    QCOMPARE(index.find(u"beta"_s), QList<quintptr>{2});
+    QCOMPARE(index.find(u"type:button"_s), QList<quintptr>{2});
+
+    // Words that drop out of an edit are forgotten as well
+    index.insert(2, element(u"Button"_s, QString(), QString(), u"gamma"_s));
+    QVERIFY(index.find(u"beta"_s).isEmpty());
+    index.insert(3, element(u"Button"_s, QString(), QString(), u"delta"_s));
+    QVERIFY(index.find(u"beta"_s).isEmpty());
+    QCOMPARE(index.find(u"gamma"_s), QList<quintptr>{2});
+    QCOMPARE(index.find(u"delta"_s), QList<quintptr>{3});
+}
+
+void tst_WebSearchIndex::rekeysElements()
+{
+    WebSearchIndex index = sampleIndex();
+    index.rekey(1, 10);
+    QVERIFY(!index.contains(1));
+    QVERIFY(index.contains(10));
+    QCOMPARE(index.find(u".cta"_s), QList<quintptr>{10});
+    // Posting lists stay sorted under the new key
+    QCOMPARE(index.find(u".primary"_s), (QList<quintptr>{2, 10}));
+
+    index.rekey(10, 10);
+    QCOMPARE(index.find(u".cta"_s), QList<quintptr>{10});
+}
+
+void tst_WebSearchIndex::rebuildMatchesInserts()
+{
+    const WebSearchIndex inserted = sampleIndex();
+    QList<WebSearchIndex::Entry> entries;
+    entries.append({3, element(u"Link"_s, QString(), u"nav"_s, u"Home"_s)});
+    entries[0].element.setValue(WebElementField::Href, u"index.html"_s);
+    entries.append({2, element(u"Heading 1"_s, u"title"_s, u"primary"_s, u"Sign in or sign up"_s)});
+    entries.append({1, element(u"Button"_s, u"signup"_s, u"cta primary"_s, u"Sign up"_s)});
+
+    WebSearchIndex rebuilt;
+    rebuilt.rebuild(entries);
+    QCOMPARE(rebuilt.size(), inserted.size());
+    for (const QString &query : {u"sign"_s, u".primary"_s, u"type:a"_s, u"home"_s, u"#signup up"_s})
+        QCOMPARE(rebuilt.find(query), inserted.find(query));
+}
+
+QTEST_GUILESS_MAIN(tst_WebSearchIndex)
+#include "tst_websearchindex.moc"